@@ -0,0 +1,44 @@
+require 'benchmark'
+
+total = (ENV['TOTAL'] || 100).to_i
+
+sizes = [100, 1_000, 10_000]
+bignums = sizes.map { |n| (1..n).inject(0) { |a, i| a * 10 + rand(10) } + 10 ** (n - 1) }
+strings = bignums.map { |b| b.to_s }
+hexes = bignums.map { |b| b.to_s(16) }
+
+Benchmark.bmbm do |x|
+  x.report "loop" do
+    total.times do |i|
+      sizes.size.times do |j|
+        j
+      end
+    end
+  end
+
+  sizes.each_with_index do |n, j|
+    x.report "Bignum#to_s #{n} digits" do
+      total.times do |i|
+        bignums[j].to_s
+      end
+    end
+
+    x.report "Bignum#to_s(16) #{n} digits" do
+      total.times do |i|
+        bignums[j].to_s(16)
+      end
+    end
+
+    x.report "String#to_i #{n} digits" do
+      total.times do |i|
+        strings[j].to_i
+      end
+    end
+
+    x.report "String#to_i(16) #{n} digits" do
+      total.times do |i|
+        hexes[j].to_i(16)
+      end
+    end
+  end
+end
@@ -32,9 +32,30 @@ class IO
     raise PrimitiveFailure, "IO#write failed. Might not have passed a string."
   end
 
-  def blocking_read(size)
+  def prim_writev(strings, offset)
+    Ruby.primitive :io_writev
+    raise PrimitiveFailure, "IO#prim_writev primitive failed"
+  end
+
+  def prim_copy_to(dest, count, offset)
+    Ruby.primitive :io_copy_to
+    raise PrimitiveFailure, "IO#prim_copy_to primitive failed"
+  end
+
+  def prim_blocking_read(size)
     Ruby.primitive :io_blocking_read
-    raise PrimitiveFailure, "IO#blocking_read primitive failed"
+    raise PrimitiveFailure, "IO#prim_blocking_read primitive failed"
+  end
+
+  ##
+  # Reads up to +size+ bytes, returning nil at end of file. Only the
+  # current Thread waits for data to arrive.
+  def blocking_read(size)
+    while (str = prim_blocking_read(size)) == false
+      wait_til_readable
+    end
+
+    str
   end
 
   def prim_reopen(other)
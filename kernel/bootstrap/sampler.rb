@@ -2,7 +2,7 @@ class Sampler
   
   def activate(hz)
     Ruby.primitive :sampler_activate
-    raise PrimitiveFailure, "primitive failed"
+    raise PrimitiveFailure, "the sampler only runs in the main VM"
   end
   
   def terminate
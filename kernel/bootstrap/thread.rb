@@ -30,4 +30,9 @@ class Thread
     Kernel.raise ThreadError, "Wakeup failed, thread may be dead"
   end
 
+  def cpu_time
+    Ruby.primitive :thread_cpu_time
+    Kernel.raise PrimitiveFailure, "Failed to get thread CPU time"
+  end
+
 end
@@ -4,6 +4,21 @@ class Rubinius::VM
     raise PrimitiveFailure, "primitive failed"
   end
 
+  def self.start_instruction_stats
+    Ruby.primitive :vm_start_instruction_stats
+    raise PrimitiveFailure, "unable to start instruction stats"
+  end
+
+  def self.stop_instruction_stats(path)
+    Ruby.primitive :vm_stop_instruction_stats
+    raise PrimitiveFailure, "instruction stats are not running"
+  end
+
+  def self.metrics
+    Ruby.primitive :vm_metrics
+    raise PrimitiveFailure, "primitive failed"
+  end
+
   def self.start_profiler
     Ruby.primitive :vm_start_profiler
     raise PrimitiveFailure, "unable to start profiler"
@@ -52,9 +67,9 @@ class Rubinius::VM
     raise PrimitiveFailure, "primitive failed"
   end
 
-  def self.join(id)
+  def self.join_prim(id, channel)
     Ruby.primitive :machine_join
-    raise PrimitiveFailure, "primitive failed"
+    raise PrimitiveFailure, "no such VM"
   end
 
   def self.poll_message
@@ -66,4 +81,9 @@ class Rubinius::VM
     Ruby.primitive :machine_send_message
     raise PrimitiveFailure, "primitive failed"
   end
+
+  def self.listen_prim(channel)
+    Ruby.primitive :machine_listen
+    raise PrimitiveFailure, "primitive failed"
+  end
 end
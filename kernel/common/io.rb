@@ -298,6 +298,29 @@ class IO
     return [lhs, rhs]
   end
 
+  ##
+  # Copies from +src+ to +dst+, each either an IO or a file name, until
+  # end of file or until +copy_length+ bytes have been copied. If
+  # +src_offset+ is given, reading starts there and the file position
+  # of +src+ is not changed. Returns the number of bytes copied.
+  #
+  # The bytes are moved by the VM (using sendfile(2) where the platform
+  # has it) rather than through Strings, and waiting on a socket only
+  # blocks the current Thread.
+  #
+  #  IO.copy_stream "public/index.html", socket
+  def self.copy_stream(src, dst, copy_length = nil, src_offset = nil)
+    from = src.kind_of?(IO) ? src : File.open(StringValue(src), "r")
+    to = dst.kind_of?(IO) ? dst : File.open(StringValue(dst), "w")
+
+    begin
+      from.copy_to to, copy_length, src_offset
+    ensure
+      from.close unless from.equal? src
+      to.close unless to.equal? dst
+    end
+  end
+
   ## 
   # Runs the specified command string as a subprocess;
   # the subprocess‘s standard input and output will be
@@ -1358,6 +1381,54 @@ class IO
     chan.receive
   end
 
+  COPY_CHUNK_SIZE = 65536
+
+  ##
+  # Implements IO.copy_stream for an open source IO.
+  def copy_to(dst, length, offset)
+    ensure_open
+    dst.ensure_open_and_writable
+
+    copied = 0
+
+    # Anything already pulled into the read buffer has to go first.
+    if offset.nil? and not @ibuffer.empty?
+      str = @ibuffer.shift length
+      dst.write str
+      copied += str.size
+    end
+
+    until length and copied >= length
+      count = COPY_CHUNK_SIZE
+      count = length - copied if length and length - copied < count
+
+      case bytes = prim_copy_to(dst, count, offset)
+      when nil
+        dst.wait_til_writable
+      when false
+        wait_til_readable
+      when 0
+        break
+      when Array
+        # dst filled up and the source couldn't take the rest back.
+        # #writev waits for dst and resumes short writes.
+        written, rest = bytes
+        copied += written + dst.writev([rest])
+      else
+        copied += bytes
+        offset += bytes if offset
+      end
+    end
+
+    copied
+  end
+
+  def wait_til_writable
+    chan = Channel.new
+    Scheduler.send_on_writable chan, self
+    chan.receive
+  end
+
   alias_method :prim_write, :write
 
   ##
@@ -1389,6 +1460,33 @@ class IO
   alias_method :syswrite, :write
   alias_method :write_nonblock, :write
 
+  ##
+  # Writes each String in +strings+ to ios, in order, submitting them
+  # to the OS together rather than one write per String. Short writes
+  # are resumed where they left off and, if the descriptor would block,
+  # only the current Thread waits for it to become writable. Returns
+  # the total number of bytes written.
+  #
+  #  $stdout.writev ["HTTP/1.1 200 OK\r\n\r\n", body]
+  def writev(strings)
+    ensure_open_and_writable
+
+    strings = strings.map { |s| String s }
+    total = 0
+    strings.each { |s| total += s.size }
+
+    written = 0
+    while written < total
+      if count = prim_writev(strings, written)
+        written += count
+      else
+        wait_til_writable
+      end
+    end
+
+    written
+  end
+
 end
 
 ##
@@ -1419,6 +1517,7 @@ class IO::BidirectionalPipe < IO
     :syswrite,
     :write,
     :write_nonblock,
+    :writev,
   ]
 
   def initialize(pid, read, write)
@@ -487,14 +487,18 @@ class MatchData
     @full
   end
 
+  ##
+  # @region holds the begin and end offsets of each group in turn,
+  # without a Tuple per group.
+
   def begin(idx)
     return @full.at(0) if idx == 0
-    return @region.at(idx - 1).at(0)
+    return @region.at((idx - 1) * 2)
   end
 
   def end(idx)
     return full.at(1) if idx == 0
-    @region.at(idx - 1).at(1)
+    @region.at((idx - 1) * 2 + 1)
   end
 
   def offset(idx)
@@ -505,20 +509,23 @@ class MatchData
   end
 
   def length
-    @region.fields + 1
+    @region.fields / 2 + 1
   end
 
   def captures
     out = []
-    @region.each do |tup|
-      x = tup.at(0)
+    i = 0
+    while i < @region.fields
+      x = @region.at(i)
 
       if x == -1
         out << nil
       else
-        y = tup.at(1)
+        y = @region.at(i + 1)
         out << @source[x, y-x]
       end
+
+      i += 2
     end
     return out
   end
@@ -609,18 +616,24 @@ class MatchData
   private :matched_area
 
   def get_capture(num)
-    x, y = @region[num]
-    return nil if !y or x == -1
+    return nil if num * 2 >= @region.fields
+
+    x = @region.at(num * 2)
+    return nil if x == -1
 
+    y = @region.at(num * 2 + 1)
     return @source[x, y-x]
   end
 
   private :get_capture
 
   def each_capture
-    @region.each do |tup|
-      x, y = *tup
+    i = 0
+    while i < @region.fields
+      x = @region.at(i)
+      y = @region.at(i + 1)
       yield @source[x, y-x]
+      i += 2
     end
   end
 
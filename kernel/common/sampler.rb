@@ -43,48 +43,32 @@ class Sampler
       @slices + @descendants_slices
     end
 
-    def count_parent(call)
+    def count_parent(call, count=1)
       if call
-        @parents[call] += 1
-        call.children[self] += 1
+        @parents[call] += count
+        call.children[self] += count
       end
     end
   end
 
   def display(out=STDOUT)
-    @total_slices = 0
+    @total_slices = @gc_cycles
     @calls = Hash.new { |h,k| h[k] = Call.new(k) }
 
-    @results.each do |ent|
-      next unless ent
+    # Each result is a call stack, outermost method first, and the number
+    # of samples taken with that stack.
+    @results.each do |frames, count|
+      @total_slices += count
 
-      @total_slices += 1
-
-      call = find_call(ent)
-      call.slices += 1
-
-      # skip context unwinding for a primitive
-      next if ent.kind_of? Fixnum
+      call = @calls[frames.last]
+      call.slices += count
 
       if @call_graph
-        # count parents and children
-        call.count_parent(find_call(ent.sender))
-
-        # calc descendants
-        seen_calls = { call => 1 }
-
-        while true
-          ent = ent.sender
-          break unless ent
-
-          c = find_call(ent)
+        call.count_parent(@calls[frames[-2]], count) if frames.size > 1
 
-          # unwind to the root, but count each call only once
-          unless seen_calls[c]
-            seen_calls[c] = 1
-
-            c.descendants_slices += 1
-          end
+        # count each caller only once, however often it recurses
+        (frames[0...-1].uniq - [frames.last]).each do |name|
+          @calls[name].descendants_slices += count
         end
       end
     end
@@ -118,17 +102,18 @@ class Sampler
     nil
   end
 
-  def context_name(entry)
-    # a Fixnum means that a primitive was running
-    if entry.kind_of? Fixnum
-      "VM.primitive => #{Rubinius::Primitives[entry]}"
-    else
-      entry.normalized_name
+  ##
+  # Writes the samples in the collapsed stack format read by
+  # flamegraph.pl: one line per distinct call stack, frames separated by
+  # semicolons and followed by the number of samples.
+
+  def display_collapsed(out=STDOUT)
+    @results.each do |frames, count|
+      out << "#{frames.join(';')} #{count}\n"
     end
-  end
 
-  def find_call(entry)
-    @calls[context_name(entry)]
+    out << "VM.garbage_collection #{@gc_cycles}\n" if @gc_cycles > 0
+    nil
   end
 
   def percent(slices)
@@ -1,19 +1,31 @@
 ##
 # Implements the MVM functionality.
+#
+# Each VM runs on its own native thread with its own heap, in the same
+# process. Messages between them are copied, so only nil, true, false,
+# numbers, Strings, Symbols and Arrays and Tuples of those can be sent.
 
 class Rubinius::VM
   def self.spawn(*args)
     args.unshift "rubinius"
-    ret = spawn_prim(args)
-    return new(*ret)
+    new spawn_prim(args)
+  end
+
+  ##
+  # The Channel the messages sent to this VM arrive on.
+
+  def self.message_channel
+    unless @message_channel
+      @message_channel = Channel.new
+      listen_prim @message_channel
+    end
+
+    @message_channel
   end
 
   def self.get_message
-    # This is how we go to sleep until someone sends us something
-    # MESSAGE_IO is a pipe that the environment will send a magic
-    # byte down to tell us that there is a message read.
-    Rubinius::MESSAGE_IO.sysread(1)
-    poll_message
+    # Only the calling Thread sleeps until someone sends us something.
+    message_channel.receive
   end
 
   def self.each_message
@@ -22,23 +34,24 @@ class Rubinius::VM
     end
   end
 
-  def initialize(id, stdin, stdout, stderr)
+  def initialize(id)
     @id = id
-    @stdin = stdin
-    @stdout = stdout
-    @stderr = stderr
-
-    @stdin.setup
-    @stdout.setup
   end
 
   attr_reader :id
-  attr_reader :stdin
-  attr_reader :stdout
-  attr_reader :stderr
+
+  ##
+  # Waits for this VM to exit. Only the calling Thread waits.
 
   def join
-    self.class.join @id
+    chan = Channel.new
+    event = self.class.join_prim @id, chan
+
+    begin
+      chan.receive
+    ensure
+      Scheduler.cancel event
+    end
   end
 
   def <<(obj)
@@ -10,7 +10,11 @@ module Profiler__
   
   def print_profile(f)
     stop_profile
-    @p.display(f)
+    if ENV['PROFILE_COLLAPSED']
+      @p.display_collapsed(f)
+    else
+      @p.display(f)
+    end
   end
   
   module_function :start_profile, :stop_profile, :print_profile
@@ -0,0 +1,15 @@
+require File.dirname(__FILE__) + '/../../spec_helper'
+
+describe "Float#dup" do
+  it "returns an equal Float" do
+    1.5.dup.should == 1.5
+    1.0e-300.dup.should == 1.0e-300
+  end
+end
+
+describe "Float#clone" do
+  it "returns an equal Float" do
+    1.5.clone.should == 1.5
+    1.0e-300.clone.should == 1.0e-300
+  end
+end
@@ -0,0 +1,42 @@
+require File.dirname(__FILE__) + '/../../spec_helper'
+
+describe "IO.copy_stream" do
+  before :each do
+    @from = "copy_stream_from.txt"
+    @to = "copy_stream_to.txt"
+    @contents = "1234567890"
+
+    File.open(@from, "w") { |io| io.write @contents }
+  end
+
+  after :each do
+    File.delete(@from) if File.exists?(@from)
+    File.delete(@to) if File.exists?(@to)
+  end
+
+  it "copies the whole source when given file names" do
+    IO.copy_stream(@from, @to).should == 10
+    File.read(@to).should == @contents
+  end
+
+  it "copies at most copy_length bytes" do
+    IO.copy_stream(@from, @to, 4).should == 4
+    File.read(@to).should == "1234"
+  end
+
+  it "starts at src_offset without moving the source position" do
+    File.open(@from, "r") do |src|
+      IO.copy_stream(src, @to, 3, 5).should == 3
+      src.read(2).should == "12"
+    end
+    File.read(@to).should == "678"
+  end
+
+  it "copies data already buffered by the source first" do
+    File.open(@from, "r") do |src|
+      src.read(2).should == "12"
+      File.open(@to, "w") { |dst| IO.copy_stream(src, dst).should == 8 }
+    end
+    File.read(@to).should == "34567890"
+  end
+end
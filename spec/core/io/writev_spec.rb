@@ -0,0 +1,31 @@
+require File.dirname(__FILE__) + '/../../spec_helper'
+
+describe "IO#writev" do
+  before :each do
+    @fname = "test.txt"
+    @io = File.open @fname, "w"
+  end
+
+  after :each do
+    @io.close unless @io.closed?
+    File.delete(@fname) if File.exists?(@fname)
+  end
+
+  it "writes each String in order and returns the number of bytes written" do
+    @io.writev(["HTTP/1.1 200 OK\r\n", "", "\r\n", "body"]).should == 23
+    @io.close
+
+    File.read(@fname).should == "HTTP/1.1 200 OK\r\n\r\nbody"
+  end
+
+  it "returns 0 when given no Strings" do
+    @io.writev([]).should == 0
+  end
+
+  it "raises IOError when the stream is not opened for writing" do
+    @io.close
+    io = File.open @fname, "r"
+    lambda { io.writev ["a"] }.should raise_error(IOError)
+    io.close
+  end
+end
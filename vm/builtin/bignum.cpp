@@ -1,9 +1,15 @@
 /* The implementation of Bignum, providing infinite size integers */
 
 #include <ctype.h>
+#include <limits.h>
 #include <math.h>
+#include <stdint.h>
+#include <sys/time.h>
+#include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <string>
+#include <vector>
 
 #include "vm/object_utils.hpp"
 #include "vm.hpp"
@@ -15,17 +21,11 @@
 #include "builtin/float.hpp"
 #include "builtin/string.hpp"
 
-#define BASIC_CLASS(blah) G(blah)
-#define NEW_STRUCT(obj, str, kls, kind) \
-  obj = (typeof(obj))Bignum::create(state); \
-  str = (kind *)(obj->mp_val())
-#define DATA_STRUCT(obj, type) ((type)(obj->mp_val()))
+#include "config.hpp"
+#include "native_thread.hpp"
 
-#define NMP mp_int *n; Bignum* n_obj; \
-  NEW_STRUCT(n_obj, n, BASIC_CLASS(bignum), mp_int);
-
-#define MMP mp_int *m; Bignum* m_obj; \
-  NEW_STRUCT(m_obj, m, BASIC_CLASS(bignum), mp_int);
+#define NMP mp_int *n = scratch_int(0)
+#define MMP mp_int *m = scratch_int(1)
 
 
 #define BDIGIT_DBL long long
@@ -33,44 +33,43 @@
 
 namespace rubinius {
 
+  static void free_scratch_ints(void* ints) {
+    mp_int* scratch = static_cast<mp_int*>(ints);
+
+    mp_clear(&scratch[0]);
+    mp_clear(&scratch[1]);
+    delete[] scratch;
+  }
+
   /*
-   * LibTomMath actually stores stuff internally in longs.
-   * The problem with it's API is that it's int based, so
-   * this will create problems on 64 bit platforms if
-   * everything is cut down to 32 bits. Hence the existence
-   * of the mp_set_long, mp_init_set_long and mp_get_long
-   * functions here.
+   * Results are computed into one of these and only then copied into a
+   * Bignum sized to fit (see Bignum::normalize), because libtommath can
+   * not grow the inline digits of a Bignum. Reusing them also saves an
+   * mp_init per operation. There is a pair per native thread, so that
+   * VMs running side by side don't share them.
    */
-  static int mp_set_long (mp_int * a, unsigned long b)
-  {
-    int     err;
-    // @todo Move these two values to bignum.h
-    size_t  x = 0;
-    size_t  count = sizeof(unsigned long) * 2;
-    size_t  shift_width = (sizeof(unsigned long) * 8) - 4;
-
-    mp_zero (a);
-
-    /* set four bits at a time */
-    for (x = 0; x < count; x++) {
-      /* shift the number up four bits */
-      if ((err = mp_mul_2d (a, 4, a)) != MP_OKAY) {
-        return err;
-      }
-
-      /* OR in the top four bits of the source */
-      a->dp[0] |= (b >> shift_width) & 15;
+  static native::ThreadLocal<mp_int*> scratch_ints(free_scratch_ints);
 
-      /* shift the source up to the next four bits */
-      b <<= 4;
+  static mp_int* scratch_int(int which) {
+    mp_int* scratch = scratch_ints.get();
 
-      /* ensure that digits are not clamped off */
-      a->used += 1;
+    if(!scratch) {
+      scratch = new mp_int[2];
+      mp_init(&scratch[0]);
+      mp_init(&scratch[1]);
+      scratch_ints.set(scratch);
     }
-    mp_clamp (a);
-    return MP_OKAY;
+
+    return &scratch[which];
   }
 
+  /*
+   * LibTomMath actually stores stuff internally in longs.
+   * The problem with it's API is that it's int based, so
+   * this will create problems on 64 bit platforms if
+   * everything is cut down to 32 bits. Hence the existence
+   * of mp_get_long here.
+   */
   static unsigned long mp_get_long (mp_int * a)
   {
       int i;
@@ -149,6 +148,8 @@ namespace rubinius {
       sign = x->sign;
     }
 
+    /* n may be scratch with digits left over, so clear those first. */
+    mp_zero(n);
     mp_grow(n, l2);
     n->used = l2;
     n->sign = MP_ZPOS;
@@ -192,7 +193,7 @@ namespace rubinius {
   void Bignum::Info::cleanup(Object* obj) {
     Bignum* big = as<Bignum>(obj);
     mp_int *n = big->mp_val();
-    mp_clear(n);
+    if(!big->inline_p()) mp_clear(n);
   }
 
   void Bignum::Info::mark(Object* obj, ObjectMark& mark) { }
@@ -213,89 +214,100 @@ namespace rubinius {
   }
 
   Bignum* Bignum::create(STATE) {
+    mp_int zero;
+    mp_digit digit = 0;
+
+    zero.used = 0;
+    zero.alloc = 1;
+    zero.sign = MP_ZPOS;
+    zero.dp = &digit;
+
+    return Bignum::create(state, &zero);
+  }
+
+  /**
+   * A Bignum with the value of value. Up to max_inline_digits digits are
+   * copied into the object itself, which then needs no cleanup when it
+   * dies. Larger values hand their digits over to the Bignum and value
+   * is left initialized but empty.
+   */
+  Bignum* Bignum::create(STATE, mp_int* value) {
     Bignum* o;
-    o = (Bignum*)state->new_struct(G(bignum), sizeof(mp_int));
-    mp_init(o->mp_val());
+
+    if(value->used <= max_inline_digits) {
+      o = (Bignum*)state->new_struct(G(bignum),
+                                     sizeof(mp_int) + value->used * sizeof(mp_digit));
+      o->mp_val_.used = value->used;
+      o->mp_val_.alloc = 0;
+      o->mp_val_.sign = value->sign;
+      memcpy(o->inline_digits_, value->dp, value->used * sizeof(mp_digit));
+    } else {
+      o = (Bignum*)state->new_struct(G(bignum), sizeof(mp_int));
+      o->mp_val_ = *value;
+      mp_init(value);
+      o->RequiresCleanup = true;
+      state->om->track_cleanup(o);
+    }
+
     return o;
   }
 
   Bignum* Bignum::initialize_copy(STATE, Bignum* other) {
-    mp_copy(mp_val(), other->mp_val());
+    if(other == this) return this;
+
+    if(inline_p()) {
+      /* The inline digits can't grow, so switch to a heap copy. */
+      mp_init_copy(&mp_val_, other->mp_val());
+      RequiresCleanup = true;
+      state->om->track_cleanup(this);
+    } else {
+      mp_copy(other->mp_val(), mp_val());
+    }
+
     return this;
   }
 
-  Bignum* Bignum::from(STATE, int num) {
-    mp_int *a;
-    Bignum* o;
-    o = Bignum::create(state);
-    a = o->mp_val();
+  /** Builds the digits of mag on the stack, Bignum::create copies them inline. */
+  static Bignum* from_magnitude(STATE, unsigned long long mag, bool negative) {
+    mp_digit digits[(sizeof(unsigned long long) * CHAR_BIT + DIGIT_BIT - 1) / DIGIT_BIT];
+    mp_int value;
 
-    if(num < 0) {
-      mp_set_int(a, (unsigned int)-num);
-      a->sign = MP_NEG;
-    } else {
-      mp_set_int(a, (unsigned int)num);
+    value.used = 0;
+    value.alloc = sizeof(digits) / sizeof(mp_digit);
+    value.dp = digits;
+
+    while(mag) {
+      digits[value.used++] = (mp_digit)(mag & MP_MASK);
+      mag >>= DIGIT_BIT;
     }
-    return o;
+
+    value.sign = negative && value.used > 0 ? MP_NEG : MP_ZPOS;
+
+    return Bignum::create(state, &value);
+  }
+
+  Bignum* Bignum::from(STATE, int num) {
+    return from_magnitude(state, num < 0 ? 0ULL - (long long)num : num, num < 0);
   }
 
   Bignum* Bignum::from(STATE, unsigned int num) {
-    Bignum* o;
-    o = Bignum::create(state);
-    mp_set_int(o->mp_val(), num);
-    return o;
+    return from_magnitude(state, num, false);
   }
 
   Bignum* Bignum::from(STATE, long num) {
-    mp_int *a;
-    Bignum* o;
-    o = Bignum::create(state);
-    a = o->mp_val();
-
-    if(num < 0) {
-      mp_set_long(a, (unsigned long)-num);
-      a->sign = MP_NEG;
-    } else {
-      mp_set_long(a, (unsigned long)num);
-    }
-    return o;
+    return from_magnitude(state, num < 0 ? 0ULL - (long long)num : num, num < 0);
   }
 
   Bignum* Bignum::from(STATE, unsigned long num) {
-    Bignum* o;
-    o = Bignum::create(state);
-    mp_set_long(o->mp_val(), num);
-    return o;
+    return from_magnitude(state, num, false);
   }
 
   Bignum* Bignum::from(STATE, unsigned long long val) {
-    mp_int low, high;
-    mp_int* ans;
-    mp_init_set_int(&low, val & 0xffffffff);
-    mp_init_set_int(&high, val >> 32);
-    mp_mul_2d(&high, 32, &high);
-
-    Bignum* ret = Bignum::create(state);
-    ans = ret->mp_val();
-    mp_or(&low, &high, ans);
-
-    mp_clear(&low);
-    mp_clear(&high);
-
-    return ret;
+    return from_magnitude(state, val, false);
   }
 
   Bignum* Bignum::from(STATE, long long val) {
-    Bignum* ret;
-
-    if(val < 0) {
-      ret = Bignum::from(state, (unsigned long long)-val);
-      ret->mp_val()->sign = MP_NEG;
-    } else {
-      ret = Bignum::from(state, (unsigned long long)val);
-    }
-
-    return ret;
+    return from_magnitude(state, val < 0 ? 0ULL - val : val, val < 0);
   }
 
   Bignum* Bignum::create(STATE, Fixnum* val) {
@@ -345,6 +357,17 @@ namespace rubinius {
     return out;
   }
 
+  Integer* Bignum::normalize(STATE, mp_int* value) {
+    mp_clamp(value);
+
+    if((size_t)mp_count_bits(value) <= FIXNUM_WIDTH) {
+      native_int val = (native_int)mp_get_long(value);
+      return Fixnum::from(value->sign == MP_NEG ? -val : val);
+    }
+
+    return Bignum::create(state, value);
+  }
+
   Integer* Bignum::normalize(STATE, Bignum* b) {
     mp_clamp(b->mp_val());
 
@@ -364,13 +387,13 @@ namespace rubinius {
     } else {
       mp_sub_d(mp_val(), -bi, n);
     }
-    return Bignum::normalize(state, n_obj);
+    return Bignum::normalize(state, n);
   }
 
   Integer* Bignum::add(STATE, Bignum* b) {
     NMP;
     mp_add(mp_val(), b->mp_val(), n);
-    return Bignum::normalize(state, n_obj);
+    return Bignum::normalize(state, n);
   }
 
   Float* Bignum::add(STATE, Float* b) {
@@ -385,13 +408,13 @@ namespace rubinius {
     } else {
       mp_add_d(mp_val(), -bi, n);
     }
-    return Bignum::normalize(state, n_obj);
+    return Bignum::normalize(state, n);
   }
 
   Integer* Bignum::sub(STATE, Bignum* b) {
     NMP;
     mp_sub(mp_val(), b->mp_val(), n);
-    return Bignum::normalize(state, n_obj);
+    return Bignum::normalize(state, n);
   }
 
   Float* Bignum::sub(STATE, Float* b) {
@@ -412,13 +435,13 @@ namespace rubinius {
         mp_neg(n, n);
       }
     }
-    return Bignum::normalize(state, n_obj);
+    return Bignum::normalize(state, n);
   }
 
   Integer* Bignum::mul(STATE, Bignum* b) {
     NMP;
-    mp_mul(mp_val(), b->mp_val(), n);
-    return Bignum::normalize(state, n_obj);
+    Bignum::multiply(mp_val(), b->mp_val(), n);
+    return Bignum::normalize(state, n);
   }
 
   Float* Bignum::mul(STATE, Float* b) {
@@ -455,7 +478,7 @@ namespace rubinius {
       }
       mp_sub_d(n, 1, n);
     }
-    return Bignum::normalize(state, n_obj);
+    return Bignum::normalize(state, n);
   }
 
   Integer* Bignum::divide(STATE, Bignum* b, Integer** remainder) {
@@ -468,13 +491,13 @@ namespace rubinius {
     mp_div(mp_val(), b->mp_val(), n, m);
     if(mp_cmp_d(n, 0) == MP_LT && mp_cmp_d(m, 0) != MP_EQ) {
       mp_sub_d(n, 1, n);
-      mp_mul(b->mp_val(), n, m);
+      Bignum::multiply(b->mp_val(), n, m);
       mp_sub(mp_val(), m, m);
     }
     if(remainder) {
-      *remainder = Bignum::normalize(state, m_obj);
+      *remainder = Bignum::normalize(state, m);
     }
-    return Bignum::normalize(state, n_obj);
+    return Bignum::normalize(state, n);
   }
 
   Integer* Bignum::div(STATE, Fixnum* denominator) {
@@ -538,11 +561,11 @@ namespace rubinius {
 
     /* Perhaps this should use mp_and rather than our own version */
     bignum_bitwise_op(BITWISE_OP_AND, mp_val(), as<Bignum>(b)->mp_val(), n);
-    return Bignum::normalize(state, n_obj);
+    return Bignum::normalize(state, n);
   }
 
   Integer* Bignum::bit_and(STATE, Float* b) {
-    return bit_and(state, Bignum::from_double(state, b->val));
+    return bit_and(state, Bignum::from_double(state, b->val()));
   }
 
   Integer* Bignum::bit_or(STATE, Integer* b) {
@@ -553,11 +576,11 @@ namespace rubinius {
     }
     /* Perhaps this should use mp_or rather than our own version */
     bignum_bitwise_op(BITWISE_OP_OR, mp_val(), as<Bignum>(b)->mp_val(), n);
-    return Bignum::normalize(state, n_obj);
+    return Bignum::normalize(state, n);
   }
 
   Integer* Bignum::bit_or(STATE, Float* b) {
-    return bit_or(state, Bignum::from_double(state, b->val));
+    return bit_or(state, Bignum::from_double(state, b->val()));
   }
 
   Integer* Bignum::bit_xor(STATE, Integer* b) {
@@ -568,11 +591,11 @@ namespace rubinius {
     }
     /* Perhaps this should use mp_xor rather than our own version */
     bignum_bitwise_op(BITWISE_OP_XOR, mp_val(), as<Bignum>(b)->mp_val(), n);
-    return Bignum::normalize(state, n_obj);
+    return Bignum::normalize(state, n);
   }
 
   Integer* Bignum::bit_xor(STATE, Float* b) {
-    return bit_xor(state, Bignum::from_double(state, b->val));
+    return bit_xor(state, Bignum::from_double(state, b->val()));
   }
 
   Integer* Bignum::invert(STATE) {
@@ -586,14 +609,14 @@ namespace rubinius {
     mp_sub(&a, &b, n);
 
     mp_clear(&a); mp_clear(&b);
-    return Bignum::normalize(state, n_obj);
+    return Bignum::normalize(state, n);
   }
 
   Integer* Bignum::neg(STATE) {
     NMP;
 
     mp_neg(mp_val(), n);
-    return Bignum::normalize(state, n_obj);
+    return Bignum::normalize(state, n);
   }
 
   /* These 2 don't use mp_lshd because it shifts by internal digits,
@@ -609,7 +632,7 @@ namespace rubinius {
 
     mp_mul_2d(a, shift, n);
     n->sign = a->sign;
-    return Bignum::normalize(state, n_obj);
+    return Bignum::normalize(state, n);
   }
 
   Integer* Bignum::right_shift(STATE, Integer* bits) {
@@ -636,7 +659,7 @@ namespace rubinius {
       }
     }
 
-    return Bignum::normalize(state, n_obj);
+    return Bignum::normalize(state, n);
   }
 
   Object* Bignum::equal(STATE, Fixnum* b) {
@@ -848,23 +871,624 @@ namespace rubinius {
     return Float::coerce(state, this);
   }
 
-  String* Bignum::to_s(STATE, Integer* radix) {
-    char *buf;
-    int sz = 1024;
-    int k;
-    String* obj;
-
-    for(;;) {
-      buf = ALLOC_N(char, sz);
-      mp_toradix_nd(mp_val(), buf, radix->to_native(), sz, &k);
-      if(k < sz - 2) {
-        obj = String::create(state, buf);
-        FREE(buf);
-        return obj;
+  /*
+   * Multiplication
+   *
+   * libtommath switches from schoolbook to Karatsuba and Toom-3 at the
+   * sizes in its KARATSUBA_* and TOOM_* globals. Operands beyond the
+   * Toom-3 range are multiplied with a number theoretic transform.
+   *
+   * The cutoffs are shared by every VM in the process, so they're only
+   * set once, by configure_multiply() as the first VM boots, from the
+   * rbx.bignum.* config keys. Without those, libtommath's compiled in
+   * values and cNttMulDefault are used. The vm/bignum_tune tool times
+   * the crossovers on this machine and prints the keys to set.
+   */
+
+  /** Operand sizes (in limbs) where tuning each crossover starts. No
+   * cutoff is configured below cTuneMinimumSize. */
+  static const int cTuneMinimumSize = 16;
+  static const int cTuneNttMinimumSize = 2048;
+
+  /** Largest size tried for each crossover; past it the cutoff is left there. */
+  static const int cTuneKaratsubaLimit = 512;
+  static const int cTuneToomLimit = 2048;
+  static const int cTuneNttLimit = 16384;
+
+#ifdef __SIZEOF_INT128__
+  /** Where the NTT overtook Toom-3 on a 64 bit x86. */
+  static const int cNttMulDefault = 8192;
+#else
+  static const int cNttMulDefault = INT_MAX;
+#endif
+
+  /** Smallest operands (in limbs) handed to ntt_multiply. */
+  static int ntt_mul_cutoff = cNttMulDefault;
+
+  static bool multiply_configured = false;
+  static native::Mutex multiply_lock;
+
+#ifdef __SIZEOF_INT128__
+  /*
+   * The transform works modulo p = 2**64 - 2**32 + 1, which has roots of
+   * unity of every order up to 2**32 and allows a cheap reduction of
+   * 128 bit products. Operands are cut into chunks small enough that no
+   * coefficient of the product reaches p, so a single prime suffices.
+   */
+  typedef unsigned __int128 ntt_wide;
+
+  static const uint64_t cNttPrime = 0xffffffff00000001ULL;
+  static const uint64_t cNttEpsilon = 0xffffffffULL;     /**< 2**64 mod p */
+  static const uint64_t cNttGenerator = 7;
+
+  /*
+   * The coefficients are effectively random, so the corrections below
+   * are done with masks rather than branches the CPU cannot predict.
+   */
+  static inline uint64_t ntt_reduce(ntt_wide x) {
+    uint64_t lo = (uint64_t)x;
+    uint64_t hi = (uint64_t)(x >> 64);
+    uint64_t hi_hi = hi >> 32;
+    uint64_t hi_lo = hi & cNttEpsilon;
+
+    /* 2**96 = -1 and 2**64 = 2**32 - 1 (mod p) */
+    uint64_t t = lo - hi_hi;
+    t -= cNttEpsilon & -(uint64_t)(lo < hi_hi);
+
+    uint64_t u = hi_lo * cNttEpsilon;
+    uint64_t r = t + u;
+    r += cNttEpsilon & -(uint64_t)(r < u);
+
+    return r - (cNttPrime & -(uint64_t)(r >= cNttPrime));
+  }
+
+  static inline uint64_t ntt_mul(uint64_t a, uint64_t b) {
+    return ntt_reduce((ntt_wide)a * b);
+  }
+
+  static inline uint64_t ntt_add(uint64_t a, uint64_t b) {
+    uint64_t s = a + b;
+    return s - (cNttPrime & -(uint64_t)((s < a) | (s >= cNttPrime)));
+  }
+
+  static inline uint64_t ntt_sub(uint64_t a, uint64_t b) {
+    return a - b + (cNttPrime & -(uint64_t)(a < b));
+  }
+
+  static uint64_t ntt_pow(uint64_t base, uint64_t exp) {
+    uint64_t r = 1;
+
+    while(exp) {
+      if(exp & 1) r = ntt_mul(r, base);
+      base = ntt_mul(base, base);
+      exp >>= 1;
+    }
+
+    return r;
+  }
+
+  /** In place transform of a, whose size is a power of two. */
+  static void ntt_transform(std::vector<uint64_t>& a, bool inverse) {
+    size_t n = a.size();
+
+    for(size_t i = 1, j = 0; i < n; i++) {
+      size_t bit = n >> 1;
+      for(; j & bit; bit >>= 1) j ^= bit;
+      j ^= bit;
+      if(i < j) std::swap(a[i], a[j]);
+    }
+
+    std::vector<uint64_t> twiddles(n / 2);
+
+    for(size_t len = 2; len <= n; len <<= 1) {
+      size_t half = len / 2;
+      uint64_t w = ntt_pow(cNttGenerator, (cNttPrime - 1) / len);
+      if(inverse) w = ntt_pow(w, cNttPrime - 2);
+
+      twiddles[0] = 1;
+      for(size_t k = 1; k < half; k++) {
+        twiddles[k] = ntt_mul(twiddles[k - 1], w);
+      }
+
+      for(size_t i = 0; i < n; i += len) {
+        for(size_t k = 0; k < half; k++) {
+          uint64_t u = a[i + k];
+          uint64_t v = ntt_mul(a[i + k + half], twiddles[k]);
+          a[i + k] = ntt_add(u, v);
+          a[i + k + half] = ntt_sub(u, v);
+        }
+      }
+    }
+
+    if(inverse) {
+      uint64_t scale = ntt_pow(n, cNttPrime - 2);
+      for(size_t i = 0; i < n; i++) {
+        a[i] = ntt_mul(a[i], scale);
+      }
+    }
+  }
+
+  /** Cuts the magnitude of x into chunks of bits each, lowest first. */
+  static void ntt_split(mp_int* x, int bits, std::vector<uint64_t>& out) {
+    uint64_t mask = ((uint64_t)1 << bits) - 1;
+    ntt_wide acc = 0;
+    int have = 0;
+    size_t k = 0;
+
+    for(int i = 0; i < x->used; i++) {
+      acc |= (ntt_wide)x->dp[i] << have;
+      have += DIGIT_BIT;
+
+      while(have >= bits) {
+        out[k++] = (uint64_t)acc & mask;
+        acc >>= bits;
+        have -= bits;
+      }
+    }
+
+    if(have > 0) out[k] = (uint64_t)acc & mask;
+  }
+
+  /** Sets x to the sum of coefficient[k] * 2 ** (bits * k). */
+  static void ntt_join(std::vector<uint64_t>& coefficients, int bits, mp_int* x) {
+    uint64_t mask = ((uint64_t)1 << bits) - 1;
+    size_t digits = (coefficients.size() * bits) / DIGIT_BIT + 2;
+
+    mp_grow(x, digits);
+    mp_zero(x);
+
+    ntt_wide carry = 0;
+    ntt_wide acc = 0;
+    int have = 0;
+    size_t d = 0;
+
+    for(size_t k = 0; k < coefficients.size(); k++) {
+      carry += coefficients[k];
+      acc |= (carry & mask) << have;
+      carry >>= bits;
+      have += bits;
+
+      while(have >= DIGIT_BIT) {
+        x->dp[d++] = (mp_digit)acc & MP_MASK;
+        acc >>= DIGIT_BIT;
+        have -= DIGIT_BIT;
+      }
+    }
+
+    /* The chunks cover the whole product, so carry is empty by now. */
+    if(have > 0) x->dp[d++] = (mp_digit)acc & MP_MASK;
+
+    x->used = d;
+    mp_clamp(x);
+  }
+#endif
+
+  void Bignum::ntt_multiply(mp_int* a, mp_int* b, mp_int* c) {
+#ifdef __SIZEOF_INT128__
+    size_t a_bits = (size_t)a->used * DIGIT_BIT;
+    size_t b_bits = (size_t)b->used * DIGIT_BIT;
+
+    /*
+     * A product coefficient is a sum of at most min(a, b) chunk products,
+     * so 2 * bits + log2(chunks) has to stay below the 64 bits of p.
+     */
+    int bits = 24;
+    size_t a_chunks, b_chunks;
+
+    for(;; bits--) {
+      a_chunks = (a_bits + bits - 1) / bits;
+      b_chunks = (b_bits + bits - 1) / bits;
+
+      size_t terms = a_chunks < b_chunks ? a_chunks : b_chunks;
+      int log = 0;
+      while(((size_t)1 << log) < terms) log++;
+
+      if(2 * bits + log <= 63) break;
+    }
+
+    size_t n = 1;
+    while(n < a_chunks + b_chunks) n <<= 1;
+
+    std::vector<uint64_t> fa(n, 0);
+    ntt_split(a, bits, fa);
+    ntt_transform(fa, false);
+
+    if(a == b) {
+      for(size_t i = 0; i < n; i++) fa[i] = ntt_mul(fa[i], fa[i]);
+    } else {
+      std::vector<uint64_t> fb(n, 0);
+      ntt_split(b, bits, fb);
+      ntt_transform(fb, false);
+      for(size_t i = 0; i < n; i++) fa[i] = ntt_mul(fa[i], fb[i]);
+    }
+
+    ntt_transform(fa, true);
+
+    int sign = a->sign == b->sign ? MP_ZPOS : MP_NEG;
+
+    mp_int product;
+    mp_init(&product);
+    ntt_join(fa, bits, &product);
+    product.sign = mp_iszero(&product) ? MP_ZPOS : sign;
+
+    mp_exch(&product, c);
+    mp_clear(&product);
+#else
+    mp_mul(a, b, c);
+#endif
+  }
+
+  void Bignum::multiply(mp_int* a, mp_int* b, mp_int* c) {
+    int size = MIN(a->used, b->used);
+
+    if(size >= ntt_mul_cutoff) {
+      ntt_multiply(a, b, c);
+    } else if(a == b) {
+      mp_sqr(a, c);
+    } else {
+      mp_mul(a, b, c);
+    }
+  }
+
+  /** Fills x with size limbs of noise, without touching rand()'s state. */
+  static void tune_operand(mp_int* x, int size, uint64_t seed) {
+    mp_grow(x, size);
+
+    for(int i = 0; i < size; i++) {
+      seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+      x->dp[i] = (mp_digit)(seed >> 4) & MP_MASK;
+    }
+
+    x->dp[size - 1] |= 1;
+    x->used = size;
+    x->sign = MP_ZPOS;
+  }
+
+  static double tune_now() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+  }
+
+  enum TuneAlgorithm {
+    cTuneMul,
+    cTuneSqr,
+    cTuneNtt
+  };
+
+  /** Seconds per multiplication of two size limb operands. */
+  static double tune_time(TuneAlgorithm algorithm, int size) {
+    mp_int a, b, c;
+    mp_init(&a);
+    mp_init(&b);
+    mp_init(&c);
+
+    tune_operand(&a, size, size);
+    tune_operand(&b, size, ~(uint64_t)size);
+
+    /* Repeat until the clock's resolution no longer matters. */
+    int count = 0;
+    double start = tune_now();
+    double elapsed;
+
+    do {
+      switch(algorithm) {
+      case cTuneMul:
+        mp_mul(&a, &b, &c);
+        break;
+      case cTuneSqr:
+        mp_sqr(&a, &c);
+        break;
+      case cTuneNtt:
+        Bignum::ntt_multiply(&a, &b, &c);
+        break;
+      }
+      count++;
+      elapsed = tune_now() - start;
+    } while(elapsed < 0.0002);
+
+    mp_clear(&a);
+    mp_clear(&b);
+    mp_clear(&c);
+
+    return elapsed / count;
+  }
+
+  /**
+   * The smallest size, stepping by a quarter from start, at which setting
+   * *cutoff to the size beats the old algorithm twice in a row.
+   */
+  static int tune_crossover(TuneAlgorithm algorithm, int* cutoff, int start, int limit) {
+    int wins = 0;
+    int first = limit;
+
+    for(int size = start; size <= limit; size += size / 4) {
+      *cutoff = INT_MAX;
+      double old_time = tune_time(algorithm, size);
+      *cutoff = size;
+      double new_time = tune_time(algorithm, size);
+
+      if(new_time < old_time) {
+        if(wins++ == 0) first = size;
+        if(wins == 2) break;
+      } else {
+        wins = 0;
+        first = limit;
+      }
+    }
+
+    return first;
+  }
+
+  static int configured_cutoff(ConfigParser* config, const char* key, int fallback) {
+    long cutoff = config->number(key, fallback);
+
+    if(cutoff < cTuneMinimumSize) return cTuneMinimumSize;
+    if(cutoff > INT_MAX) return INT_MAX;
+    return cutoff;
+  }
+
+  void Bignum::configure_multiply(ConfigParser* config) {
+    native::LockGuard guard(multiply_lock);
+
+    if(multiply_configured) return;
+    multiply_configured = true;
+
+    KARATSUBA_MUL_CUTOFF = configured_cutoff(config, "rbx.bignum.karatsuba_mul",
+                                             KARATSUBA_MUL_CUTOFF);
+    KARATSUBA_SQR_CUTOFF = configured_cutoff(config, "rbx.bignum.karatsuba_sqr",
+                                             KARATSUBA_SQR_CUTOFF);
+    TOOM_MUL_CUTOFF = configured_cutoff(config, "rbx.bignum.toom_mul", TOOM_MUL_CUTOFF);
+    TOOM_SQR_CUTOFF = configured_cutoff(config, "rbx.bignum.toom_sqr", TOOM_SQR_CUTOFF);
+
+#ifdef __SIZEOF_INT128__
+    ntt_mul_cutoff = configured_cutoff(config, "rbx.bignum.ntt_mul", ntt_mul_cutoff);
+#endif
+  }
+
+  /* Tuning rewrites the cutoffs while it runs, so it's only for a process
+   * doing nothing else, such as vm/bignum_tune. */
+  static void tune_multiply() {
+    TOOM_MUL_CUTOFF = TOOM_SQR_CUTOFF = INT_MAX;
+
+    KARATSUBA_MUL_CUTOFF = tune_crossover(cTuneMul, &KARATSUBA_MUL_CUTOFF,
+                                          cTuneMinimumSize, cTuneKaratsubaLimit);
+    KARATSUBA_SQR_CUTOFF = tune_crossover(cTuneSqr, &KARATSUBA_SQR_CUTOFF,
+                                          cTuneMinimumSize, cTuneKaratsubaLimit);
+
+    TOOM_MUL_CUTOFF = tune_crossover(cTuneMul, &TOOM_MUL_CUTOFF,
+                                     KARATSUBA_MUL_CUTOFF * 3, cTuneToomLimit);
+    TOOM_SQR_CUTOFF = tune_crossover(cTuneSqr, &TOOM_SQR_CUTOFF,
+                                     KARATSUBA_SQR_CUTOFF * 3, cTuneToomLimit);
+  }
+
+  static void tune_ntt() {
+#ifdef __SIZEOF_INT128__
+    /* The NTT has no cutoff of its own to vary, so race it against mp_mul. */
+    int wins = 0;
+    ntt_mul_cutoff = cTuneNttLimit;
+
+    for(int size = cTuneNttMinimumSize; size <= cTuneNttLimit; size *= 2) {
+      if(tune_time(cTuneNtt, size) < tune_time(cTuneMul, size)) {
+        if(wins++ == 0) ntt_mul_cutoff = size;
+        if(wins == 2) break;
+      } else {
+        wins = 0;
+        ntt_mul_cutoff = cTuneNttLimit;
+      }
+    }
+#else
+    ntt_mul_cutoff = INT_MAX;
+#endif
+  }
+
+  void Bignum::calibrate_multiply(std::ostream& stream) {
+    native::LockGuard guard(multiply_lock);
+
+    tune_multiply();
+    tune_ntt();
+
+    stream << "rbx.bignum.karatsuba_mul = " << KARATSUBA_MUL_CUTOFF << std::endl;
+    stream << "rbx.bignum.karatsuba_sqr = " << KARATSUBA_SQR_CUTOFF << std::endl;
+    stream << "rbx.bignum.toom_mul = " << TOOM_MUL_CUTOFF << std::endl;
+    stream << "rbx.bignum.toom_sqr = " << TOOM_SQR_CUTOFF << std::endl;
+#ifdef __SIZEOF_INT128__
+    stream << "rbx.bignum.ntt_mul = " << ntt_mul_cutoff << std::endl;
+#endif
+  }
+
+  /*
+   * Radix conversion
+   *
+   * mp_toradix and mp_read_radix handle one digit at a time against the
+   * whole number, which is quadratic in the number of digits. Large
+   * numbers are instead split around a power of the radix and both
+   * halves converted recursively, so the work goes into a few big
+   * multiplications that libtommath does with Karatsuba/Toom-Cook.
+   * The quotient for the split is found with a Barrett reduction
+   * against a cached reciprocal of the power, because mp_div itself is
+   * schoolbook division.
+   */
+
+  /** Digits in the smallest cached power, radix ** cRadixBaseDigits. */
+  static const int cRadixBaseDigits = 64;
+
+  /** Numbers with fewer limbs than this are printed by mp_toradix. */
+  static const int cRadixToStringCutoff = 32;
+
+  struct RadixPower {
+    mp_int  value;    /**< radix ** digits */
+    mp_int  mu;       /**< Barrett reciprocal of value, set up on first division. */
+    int     digits;
+  };
+
+  /** radix_powers[r][k] is r ** (cRadixBaseDigits * 2 ** k). Shared by
+   * every VM in the process and only touched under radix_lock. */
+  static std::vector<RadixPower*> radix_powers[37];
+  static native::Mutex radix_lock;
+
+  static RadixPower* radix_power(int radix, size_t k) {
+    native::LockGuard guard(radix_lock);
+    std::vector<RadixPower*>& powers = radix_powers[radix];
+
+    while(powers.size() <= k) {
+      RadixPower* power = new RadixPower;
+      mp_init(&power->value);
+      mp_init(&power->mu);
+
+      if(powers.empty()) {
+        mp_set(&power->value, radix);
+        mp_expt_d(&power->value, cRadixBaseDigits, &power->value);
+        power->digits = cRadixBaseDigits;
+      } else {
+        Bignum::multiply(&powers.back()->value, &powers.back()->value, &power->value);
+        power->digits = powers.back()->digits * 2;
+      }
+
+      powers.push_back(power);
+    }
+
+    return powers[k];
+  }
+
+  /** q, r = x.divmod(power), x must have at most twice as many limbs as power. */
+  static void radix_divmod(mp_int* x, RadixPower* power, mp_int* q, mp_int* r) {
+    int k = power->value.used;
+
+    {
+      native::LockGuard guard(radix_lock);
+      if(mp_iszero(&power->mu)) mp_reduce_setup(&power->mu, &power->value);
+    }
+
+    mp_copy(x, q);
+    mp_rshd(q, k - 1);
+    Bignum::multiply(q, &power->mu, q);
+    mp_rshd(q, k + 1);
+
+    Bignum::multiply(q, &power->value, r);
+    mp_sub(x, r, r);
+
+    /* Barrett's estimate is at most two short. */
+    while(mp_cmp(r, &power->value) != MP_LT) {
+      mp_sub(r, &power->value, r);
+      mp_add_d(q, 1, q);
+    }
+  }
+
+  /** Appends the digits of x >= 0, zero padded on the left to width. */
+  static void radix_to_string(mp_int* x, int radix, std::string& out, size_t width) {
+    if(x->used < cRadixToStringCutoff) {
+      int size;
+      mp_radix_size(x, radix, &size);
+
+      /* mp_radix_size leaves no room for the NUL when x is zero. */
+      std::vector<char> buf(size + 1);
+      mp_toradix(x, &buf[0], radix);
+
+      size_t len = strlen(&buf[0]);
+      if(width > len) out.append(width - len, '0');
+      out.append(&buf[0], len);
+      return;
+    }
+
+    /*
+     * The smallest power with at least half as many limbs as x. That
+     * keeps x below the bound of the Barrett reduction and, given the
+     * cutoff, keeps the power below x so both halves shrink.
+     */
+    size_t k = 0;
+    RadixPower* power = radix_power(radix, k);
+
+    while(power->value.used * 2 < x->used) {
+      power = radix_power(radix, ++k);
+    }
+
+    mp_int q, r;
+    mp_init(&q);
+    mp_init(&r);
+
+    radix_divmod(x, power, &q, &r);
+
+    if(mp_iszero(&q) && width == 0) {
+      radix_to_string(&r, radix, out, 0);
+    } else {
+      size_t high_width = width > (size_t)power->digits ? width - power->digits : 0;
+      radix_to_string(&q, radix, out, high_width);
+      radix_to_string(&r, radix, out, power->digits);
+    }
+
+    mp_clear(&q);
+    mp_clear(&r);
+  }
+
+  static int radix_digit(char c) {
+    if(c >= '0' && c <= '9') return c - '0';
+    if(c >= 'a' && c <= 'z') return c - 'a' + 10;
+    if(c >= 'A' && c <= 'Z') return c - 'A' + 10;
+    return 36;
+  }
+
+  /** Reads len digits, all valid in radix, into a. */
+  static void radix_from_digits(mp_int* a, const char* digits, size_t len, int radix) {
+    if(len <= (size_t)cRadixBaseDigits * 2) {
+      mp_zero(a);
+
+      for(size_t i = 0; i < len; i++) {
+        mp_mul_d(a, radix, a);
+        mp_add_d(a, radix_digit(digits[i]), a);
       }
-      FREE(buf);
-      sz += 1024;
+      return;
     }
+
+    /* The largest power with fewer digits than the string. */
+    size_t k = 0;
+    while(radix_power(radix, k + 1)->digits < (int)len) k++;
+
+    RadixPower* power = radix_power(radix, k);
+    size_t low = power->digits;
+
+    mp_int high;
+    mp_init(&high);
+
+    radix_from_digits(&high, digits, len - low, radix);
+    radix_from_digits(a, digits + len - low, low, radix);
+
+    Bignum::multiply(&high, &power->value, &high);
+    mp_add(&high, a, a);
+
+    mp_clear(&high);
+  }
+
+  /** Like mp_read_radix: an optional '-', then digits up to the first invalid one. */
+  static void radix_read(mp_int* a, const char* str, int radix) {
+    bool negative = false;
+
+    if(*str == '-') {
+      negative = true;
+      str++;
+    }
+
+    size_t len = 0;
+    while(str[len] && radix_digit(str[len]) < radix) len++;
+
+    radix_from_digits(a, str, len, radix);
+
+    if(negative && !mp_iszero(a)) a->sign = MP_NEG;
+  }
+
+  String* Bignum::to_s(STATE, Integer* radix) {
+    std::string buf;
+    mp_int a;
+
+    mp_init(&a);
+    mp_abs(mp_val(), &a);
+
+    if(mp_val()->sign == MP_NEG) buf.push_back('-');
+    radix_to_string(&a, radix->to_native(), buf, 0);
+
+    mp_clear(&a);
+
+    return String::create(state, buf.c_str(), buf.size());
   }
 
   Integer* Bignum::from_string_detect(STATE, const char *str) {
@@ -900,19 +1524,19 @@ namespace rubinius {
           radix = 8; s += 1;
       }
     }
-    mp_read_radix(n, s, radix);
+    radix_read(n, s, radix);
 
     if(!sign) {
       n->sign = MP_NEG;
     }
 
-    return Bignum::normalize(state, n_obj);
+    return Bignum::normalize(state, n);
   }
 
   Integer* Bignum::from_string(STATE, const char *str, size_t radix) {
     NMP;
-    mp_read_radix(n, str, radix);
-    return Bignum::normalize(state, n_obj);
+    radix_read(n, str, radix);
+    return Bignum::normalize(state, n);
   }
 
   void Bignum::into_string(STATE, size_t radix, char *buf, size_t sz) {
@@ -933,7 +1557,7 @@ namespace rubinius {
     }
 
     /* get number of digits of the lsb we have to read */
-    i = a->used;
+    i = a->used - 1;
     m = DIGIT_RADIX;
 
     /* get most significant digit of result */
@@ -954,7 +1578,7 @@ namespace rubinius {
   }
 
   Integer* Bignum::from_float(STATE, Float* f) {
-    return Bignum::from_double(state, f->val);
+    return Bignum::from_double(state, f->val());
   }
 
   Integer* Bignum::from_double(STATE, double d) {
@@ -977,6 +1601,7 @@ namespace rubinius {
       i++;
     }
 
+    mp_zero(n);
     mp_grow(n, i);
 
     while (i--) {
@@ -991,7 +1616,7 @@ namespace rubinius {
       mp_neg(n, n);
     }
 
-    return Bignum::normalize(state, n_obj);
+    return Bignum::normalize(state, n);
   }
 
   Array* Bignum::coerce(STATE, Bignum* other) {
@@ -1,10 +1,13 @@
 #ifndef RBX_BUILTIN_BIGNUM_HPP
 #define RBX_BUILTIN_BIGNUM_HPP
 
+#include <iosfwd>
+
 #include "builtin/integer.hpp"
 #include "tommath.h"
 
 namespace rubinius {
+  class ConfigParser;
   class Array;
   class String;
   class Float;
@@ -14,10 +17,15 @@ namespace rubinius {
     const static size_t fields = 1;
     const static object_type type = BignumType;
 
+    /** Values with at most this many digits keep them in the object body. */
+    const static int max_inline_digits = (512 + DIGIT_BIT - 1) / DIGIT_BIT;
+
     mp_int mp_val_;
+    mp_digit inline_digits_[];
 
     static void init(STATE);
     static Bignum* create(STATE);
+    static Bignum* create(STATE, mp_int* value);
 
     static Bignum* from(STATE, int num);
     static Bignum* from(STATE, unsigned int num);
@@ -26,10 +34,20 @@ namespace rubinius {
     static Bignum* from(STATE, long long val);
     static Bignum* from(STATE, unsigned long long val);
 
+    /**
+     * Inline digits are marked by alloc == 0. They move whenever the GC
+     * copies the object, so dp is pointed at them on every access. They
+     * must only be read: libtommath would try to realloc them to grow.
+     */
     mp_int* mp_val() {
+      if(mp_val_.alloc == 0) mp_val_.dp = inline_digits_;
       return &mp_val_;
     }
 
+    bool inline_p() {
+      return mp_val_.alloc == 0;
+    }
+
     native_int         to_native();
 
     int                to_int();
@@ -40,10 +58,23 @@ namespace rubinius {
     unsigned long long to_ulong_long();
 
     static Integer* normalize(STATE, Bignum* obj);
+    static Integer* normalize(STATE, mp_int* value);
     static Integer* from_string_detect(STATE, const char* str);
     static Integer* from_string(STATE, const char* str, size_t radix);
     static Integer* from_double(STATE, double d);
 
+    /** c = a * b, choosing the algorithm by the configured crossovers. */
+    static void multiply(mp_int* a, mp_int* b, mp_int* c);
+    /** c = a * b by number theoretic transform, whatever the size. */
+    static void ntt_multiply(mp_int* a, mp_int* b, mp_int* c);
+    /** Sets the multiply crossovers from the rbx.bignum.* keys of +config+.
+     * Only the first call in the process has any effect. */
+    static void configure_multiply(ConfigParser* config);
+    /** Times the multiply crossovers on this CPU and writes them to
+     * +stream+ as rbx.bignum.* settings. Nothing else may multiply
+     * Bignums meanwhile. */
+    static void calibrate_multiply(std::ostream& stream);
+
     // Ruby.primitive :bignum_new
     static Bignum* create(STATE, Fixnum* f);
 
@@ -184,7 +215,7 @@ namespace rubinius {
 
     class Info : public TypeInfo {
     public:
-      Info(object_type type, bool cleanup = true) : TypeInfo(type, true) { }
+      Info(object_type type, bool cleanup = false) : TypeInfo(type, cleanup) { }
       virtual void mark(Object* t, ObjectMark& mark);
       virtual void cleanup(Object* obj);
       virtual void show(STATE, Object* self, int level);
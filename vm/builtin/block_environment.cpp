@@ -11,6 +11,7 @@
 
 #include "profiler.hpp"
 #include "message.hpp"
+#include "vmmethod.hpp"
 
 #include "builtin/class.hpp"
 #include "builtin/compiledmethod.hpp"
@@ -49,14 +50,7 @@ namespace rubinius {
     }
     task->pop(); // Remove this from the stack.
     BlockContext* ctx = create_context(state, task->active());
-    if(task->profiler) {
-      profiler::Method* prof_meth = task->profiler->enter_method(
-          as<Symbol>(home_->name()), home_->module()->name(), profiler::kBlock);
-
-      if(!prof_meth->file()) {
-        prof_meth->set_position(method_->file(), method_->start_line(state));
-      }
-    }
+    if(task->profiler) enter_profiler(state, task, ctx);
     task->make_active(ctx);
     task->push(val);
   }
@@ -74,14 +68,7 @@ namespace rubinius {
       val = Qnil;
     }
     BlockContext* ctx = create_context(state, task->active());
-    if(task->profiler) {
-      profiler::Method* prof_meth = task->profiler->enter_method(
-          as<Symbol>(home_->name()), home_->module()->name(), profiler::kBlock);
-
-      if(!prof_meth->file()) {
-        prof_meth->set_position(method_->file(), method_->start_line(state));
-      }
-    }
+    if(task->profiler) enter_profiler(state, task, ctx);
 
     // HACK: manually clear the stack used as args.
     task->active()->clear_stack(msg.stack);
@@ -96,6 +83,31 @@ namespace rubinius {
     return cExecuteRestart;
   }
 
+  /* Like VMMethod's, the profiler entry is cached on the block's VMMethod
+   * when it has one. */
+  void BlockEnvironment::enter_profiler(STATE, Task* task, BlockContext* ctx) {
+    profiler::Profiler* prof = task->profiler;
+    Symbol* name = as<Symbol>(home_->name());
+    VMMethod* vmm = ctx->vmm;
+
+    Module* mod = home_->module();
+
+    profiler::Method* prof_meth = NULL;
+    if(vmm) prof_meth = vmm->cached_profiler_method(prof, name, mod, profiler::kBlock);
+
+    if(!prof_meth) {
+      prof_meth = prof->find_method(name, mod->name(), profiler::kBlock);
+
+      if(!prof_meth->file()) {
+        prof_meth->set_position(method_->file(), method_->start_line(state));
+      }
+
+      if(vmm) vmm->cache_profiler_method(prof, name, mod, profiler::kBlock, prof_meth);
+    }
+
+    prof->enter_method(prof_meth);
+  }
+
   /*
    * Allocates a context, adjusting the initial stack pointer by the number of
    * locals the method requires.
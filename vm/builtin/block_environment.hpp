@@ -48,6 +48,7 @@ namespace rubinius {
     void call(STATE, Task* task, size_t args);
     void call(STATE, Task* task, Message& msg);
     BlockContext* create_context(STATE, MethodContext* sender);
+    void enter_profiler(STATE, Task* task, BlockContext* ctx);
 
     // Ruby.primitive? :block_call
     ExecuteStatus call_prim(STATE, Executable* exec, Task* task, Message& msg);
@@ -155,29 +155,70 @@ namespace rubinius {
     return other;
   }
 
+  /* Patterns at least this long are searched with Horspool's algorithm,
+   * shorter ones by scanning for the first byte with memchr(), which libc
+   * implements with vector instructions chosen for the running CPU.
+   */
+  static const native_int horspool_threshold = 8;
+
+  static const uint8_t* horspool_search(const uint8_t* haystack, native_int size,
+                                        const uint8_t* pat, native_int len) {
+    native_int skip[256];
+    native_int last = len - 1;
+
+    for(native_int i = 0; i < 256; i++) skip[i] = len;
+    for(native_int i = 0; i < last; i++) skip[pat[i]] = last - i;
+
+    for(native_int i = 0; i <= size - len; i += skip[haystack[i + last]]) {
+      if(haystack[i + last] == pat[last] &&
+          std::memcmp(haystack + i, pat, last) == 0) {
+        return haystack + i;
+      }
+    }
+
+    return NULL;
+  }
+
+  static const uint8_t* memchr_search(const uint8_t* haystack, native_int size,
+                                      const uint8_t* pat, native_int len) {
+    const uint8_t* p = haystack;
+    const uint8_t* limit = haystack + size - len;
+
+    while(p <= limit) {
+      p = (const uint8_t*)std::memchr(p, pat[0], limit - p + 1);
+      if(!p) return NULL;
+
+      if(std::memcmp(p + 1, pat + 1, len - 1) == 0) return p;
+      p++;
+    }
+
+    return NULL;
+  }
+
   Object* ByteArray::locate(STATE, String* pattern, Integer* start) {
     native_int size = SIZE_OF_BODY(this);
-    const char *pat = pattern->byte_address();
+    const uint8_t* pat = (const uint8_t*)pattern->byte_address();
     native_int len = pattern->size();
+    native_int offset = start->to_native();
 
     if(len == 0) {
       return start;
     }
 
-    for(native_int i = start->to_native(); i <= size - len; i++) {
-      if(this->bytes[i] == pat[0]) {
-        native_int j;
-        // match the rest of the pattern string
-        for(j = 1; j < len; j++) {
-          if(this->bytes[i+j] != pat[j]) break;
-        }
-
-        // if the full pattern matched, return the index
-        // of the end of the pattern in 'this'.
-        if(j == len) return Integer::from(state, i + len);
-      }
+    if(offset < 0) offset = 0;
+    if(offset > size - len) return Qnil;
+
+    const uint8_t* found;
+    if(len < horspool_threshold) {
+      found = memchr_search(this->bytes + offset, size - offset, pat, len);
+    } else {
+      found = horspool_search(this->bytes + offset, size - offset, pat, len);
     }
 
+    // if the full pattern matched, return the index
+    // of the end of the pattern in 'this'.
+    if(found) return Integer::from(state, (found - this->bytes) + len);
+
     return Qnil;
   }
 }
@@ -149,6 +149,14 @@ namespace rubinius {
     return io;
   }
 
+  Object* Channel::send_on_writable(STATE, Channel* chan, IO* io) {
+    SendToChannel* cb = new SendToChannel(state, chan);
+    event::Write* sig = new event::Write(state, cb, io->to_fd());
+
+    state->events->start(sig);
+    return io;
+  }
+
   Object* Channel::send_in_microseconds(STATE, Channel* chan, Integer* useconds, Object* tag) {
     double seconds = useconds->to_native() / 1000000.0;
 
@@ -163,7 +171,13 @@ namespace rubinius {
   Object* Channel::send_in_seconds(STATE, Channel* chan, double seconds, Object* tag) {
     SendToChannel* cb = new SendToChannel(state, chan);
     event::Timer* sig = new event::Timer(state, cb, seconds, tag);
+    sig->owns_channel = true;
     state->events->start(sig);
+    return Fixnum::from(sig->id);
+  }
+
+  Object* Channel::cancel(STATE, Fixnum* id) {
+    state->events->clear_by_id(id->to_native());
     return Qnil;
   }
 
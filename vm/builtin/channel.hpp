@@ -54,6 +54,9 @@ namespace rubinius {
     // Ruby.primitive :scheduler_send_on_readable
     static Object* send_on_readable(STATE, Channel* chan, IO* io, Object* maybe_buffer, Fixnum* bytes);
 
+    // Ruby.primitive :scheduler_send_on_writable
+    static Object* send_on_writable(STATE, Channel* chan, IO* io);
+
     // Ruby.primitive :scheduler_send_in_microseconds
     static Object* send_in_microseconds(STATE, Channel* chan, Integer* useconds, Object* tag);
 
@@ -61,6 +64,13 @@ namespace rubinius {
     static Object* send_in_seconds(STATE, Channel* chan, Float* seconds, Object* tag);
     static Object* send_in_seconds(STATE, Channel* chan, double seconds, Object* tag);
 
+    /**
+     *  Cancel the event with the id returned by the send_* method that
+     *  started it, if it hasn't happened yet.
+     */
+    // Ruby.primitive :scheduler_cancel
+    static Object* cancel(STATE, Fixnum* id);
+
     /**
      *  Event child process ending.
      */
@@ -73,6 +73,7 @@ namespace rubinius {
       ctx->klass(state, (Class*)Qnil);
       ctx->obj_type = (object_type)cls->instance_type()->to_native();
     } else {
+      state->metrics.context_heap_overflows++;
       bytes = add_stack(sizeof(MethodContext), stack_size);
       ctx = (MethodContext*)state->new_struct(cls, bytes);
     }
@@ -149,6 +150,7 @@ namespace rubinius {
       ctx->home_ = ctx;
 
     } else {
+      state->metrics.context_heap_overflows++;
 
       size_t bytes = add_stack(sizeof(MethodContext), stack_size);
       ctx = (MethodContext*)state->new_struct(G(methctx), bytes);
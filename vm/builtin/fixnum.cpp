@@ -160,7 +160,7 @@ namespace rubinius {
   }
 
   Object* Fixnum::equal(STATE, Float* other) {
-    return (double)to_native() == other->val ? Qtrue : Qfalse;
+    return (double)to_native() == other->val() ? Qtrue : Qfalse;
   }
 
   Fixnum* Fixnum::compare(STATE, Fixnum* other) {
@@ -188,7 +188,7 @@ namespace rubinius {
 
   Fixnum* Fixnum::compare(STATE, Float* other) {
     double left  = (double)to_native();
-    double right = other->val;
+    double right = other->val();
     if(left == right) {
       return Fixnum::from(0);
     } else if(left < right) {
@@ -203,7 +203,7 @@ namespace rubinius {
   }
 
   Object* Fixnum::gt(STATE, Float* other) {
-    return (double) to_native() > other->val ? Qtrue : Qfalse;
+    return (double) to_native() > other->val() ? Qtrue : Qfalse;
   }
 
   Object* Fixnum::ge(STATE, Fixnum* other) {
@@ -215,7 +215,7 @@ namespace rubinius {
   }
 
   Object* Fixnum::ge(STATE, Float* other) {
-    return (double) to_native() >= other->val ? Qtrue : Qfalse;
+    return (double) to_native() >= other->val() ? Qtrue : Qfalse;
   }
 
   Object* Fixnum::lt(STATE, Bignum* other) {
@@ -223,7 +223,7 @@ namespace rubinius {
   }
 
   Object* Fixnum::lt(STATE, Float* other) {
-    return (double) to_native() < other->val ? Qtrue : Qfalse;
+    return (double) to_native() < other->val() ? Qtrue : Qfalse;
   }
 
   Object* Fixnum::le(STATE, Fixnum* other) {
@@ -235,7 +235,7 @@ namespace rubinius {
   }
 
   Object* Fixnum::le(STATE, Float* other) {
-    return (double) to_native() <= other->val ? Qtrue : Qfalse;
+    return (double) to_native() <= other->val() ? Qtrue : Qfalse;
   }
 
   Integer* Fixnum::left_shift(STATE, Integer* bits) {
@@ -278,7 +278,7 @@ namespace rubinius {
   }
 
   Integer* Fixnum::bit_and(STATE, Float* other) {
-    return Fixnum::from(to_native() & (native_int)other->val);
+    return Fixnum::from(to_native() & (native_int)other->val());
   }
 
   Integer* Fixnum::bit_or(STATE, Fixnum* other) {
@@ -290,7 +290,7 @@ namespace rubinius {
   }
 
   Integer* Fixnum::bit_or(STATE, Float* other) {
-    return Fixnum::from(to_native() | (native_int)other->val);
+    return Fixnum::from(to_native() | (native_int)other->val());
   }
 
   Integer* Fixnum::bit_xor(STATE, Fixnum* other) {
@@ -302,7 +302,7 @@ namespace rubinius {
   }
 
   Integer* Fixnum::bit_xor(STATE, Float* other) {
-    return Fixnum::from(to_native() ^ (native_int)other->val);
+    return Fixnum::from(to_native() ^ (native_int)other->val());
   }
 
   Integer* Fixnum::invert(STATE) {
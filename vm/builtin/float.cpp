@@ -18,11 +18,22 @@ namespace rubinius {
   void Float::init(STATE) {
     GO(floatpoint).set(state->new_class("Float", G(numeric)));
     G(floatpoint)->set_object_type(state, FloatType);
+
+#ifdef RBX_FLONUM
+    for(size_t i = DATA_TAG_FLONUM; i < SPECIAL_CLASS_SIZE; i += DATA_MASK + 1) {
+      state->globals.special_classes[i] = GO(floatpoint);
+    }
+#endif
   }
 
+  /* Most doubles come back as a flonum, so arithmetic on them doesn't
+   * allocate. The rest (NaN, infinity, -0.0, very large or very small
+   * magnitudes) are boxed. */
   Float* Float::create(STATE, double val) {
+    if(Float* flonum = to_flonum(val)) return flonum;
+
     Float* flt = (Float*)state->new_struct(G(floatpoint), sizeof(Float));
-    flt->val = val;
+    flt->value_ = val;
     return flt;
   }
 
@@ -39,50 +50,50 @@ namespace rubinius {
   }
 
   Float* Float::add(STATE, Float* other) {
-    return Float::create(state, this->val + other->val);
+    return Float::create(state, this->val() + other->val());
   }
 
   Float* Float::add(STATE, Integer* other) {
-    return Float::create(state, this->val + Float::coerce(state, other)->val);
+    return Float::create(state, this->val() + Float::coerce(state, other)->val());
   }
 
   Float* Float::sub(STATE, Float* other) {
-    return Float::create(state, this->val - other->val);
+    return Float::create(state, this->val() - other->val());
   }
 
   Float* Float::sub(STATE, Integer* other) {
-    return Float::create(state, this->val - Float::coerce(state, other)->val);
+    return Float::create(state, this->val() - Float::coerce(state, other)->val());
   }
 
   Float* Float::mul(STATE, Float* other) {
-    return Float::create(state, this->val * other->val);
+    return Float::create(state, this->val() * other->val());
   }
 
   Float* Float::mul(STATE, Integer* other) {
-    return Float::create(state, this->val * Float::coerce(state, other)->val);
+    return Float::create(state, this->val() * Float::coerce(state, other)->val());
   }
 
   Float* Float::fpow(STATE, Float* other) {
-    return Float::create(state, pow(this->val, other->val));
+    return Float::create(state, pow(this->val(), other->val()));
   }
 
   Float* Float::fpow(STATE, Integer* other) {
-    return Float::create(state, pow(this->val, Float::coerce(state, other)->val));
+    return Float::create(state, pow(this->val(), Float::coerce(state, other)->val()));
   }
 
   Float* Float::div(STATE, Float* other) {
-    return Float::create(state, this->val / other->val);
+    return Float::create(state, this->val() / other->val());
   }
 
   Float* Float::div(STATE, Integer* other) {
-    return Float::create(state, this->val / Float::coerce(state, other)->val);
+    return Float::create(state, this->val() / Float::coerce(state, other)->val());
   }
 
   Float* Float::mod(STATE, Float* other) {
-    double res = fmod(this->val, other->val);
-    if((other->val < 0.0 && this->val > 0.0) ||
-       (other->val > 0.0 && this->val < 0.0)) {
-      res += other->val;
+    double res = fmod(this->val(), other->val());
+    if((other->val() < 0.0 && this->val() > 0.0) ||
+       (other->val() > 0.0 && this->val() < 0.0)) {
+      res += other->val();
     }
     return Float::create(state, res);
   }
@@ -93,7 +104,7 @@ namespace rubinius {
 
   Array* Float::divmod(STATE, Float* other) {
     Array* ary = Array::create(state, 2);
-    ary->set(state, 0, Bignum::from_double(state, floor(this->val / other->val) ));
+    ary->set(state, 0, Bignum::from_double(state, floor(this->val() / other->val()) ));
     ary->set(state, 1, mod(state, other));
     return ary;
   }
@@ -103,11 +114,11 @@ namespace rubinius {
   }
 
   Float* Float::neg(STATE) {
-    return Float::create(state, -this->val);
+    return Float::create(state, -this->val());
   }
 
   Object* Float::equal(STATE, Float* other) {
-    if(this->val == other->val) {
+    if(this->val() == other->val()) {
       return Qtrue;
     }
     return Qfalse;
@@ -115,14 +126,14 @@ namespace rubinius {
 
   Object* Float::equal(STATE, Integer* other) {
     Float* o = Float::coerce(state, other);
-    if(this->val == o->val) {
+    if(this->val() == o->val()) {
       return Qtrue;
     }
     return Qfalse;
   }
 
   Object* Float::eql(STATE, Float* other) {
-    if(this->val == other->val) {
+    if(this->val() == other->val()) {
       return Qtrue;
     }
     return Qfalse;
@@ -133,9 +144,9 @@ namespace rubinius {
   }
 
   Fixnum* Float::compare(STATE, Float* other) {
-    if(this->val == other->val) {
+    if(this->val() == other->val()) {
       return Fixnum::from(0);
-    } else if(this->val > other->val) {
+    } else if(this->val() > other->val()) {
       return Fixnum::from(1);
     } else {
       return Fixnum::from(-1);
@@ -144,9 +155,9 @@ namespace rubinius {
 
   Fixnum* Float::compare(STATE, Integer* other) {
     Float* o = Float::coerce(state, other);
-    if(this->val == o->val) {
+    if(this->val() == o->val()) {
       return Fixnum::from(0);
-    } else if(this->val > o->val) {
+    } else if(this->val() > o->val()) {
       return Fixnum::from(1);
     } else {
       return Fixnum::from(-1);
@@ -154,63 +165,63 @@ namespace rubinius {
   }
 
   Object* Float::gt(STATE, Float* other) {
-    return this->val > other->val ? Qtrue : Qfalse;
+    return this->val() > other->val() ? Qtrue : Qfalse;
   }
 
   Object* Float::gt(STATE, Integer* other) {
-    return this->val > Float::coerce(state, other)->val ? Qtrue : Qfalse;
+    return this->val() > Float::coerce(state, other)->val() ? Qtrue : Qfalse;
   }
 
   Object* Float::ge(STATE, Float* other) {
-    return this->val >= other->val ? Qtrue : Qfalse;
+    return this->val() >= other->val() ? Qtrue : Qfalse;
   }
 
   Object* Float::ge(STATE, Integer* other) {
-    return this->val >= Float::coerce(state, other)->val ? Qtrue : Qfalse;
+    return this->val() >= Float::coerce(state, other)->val() ? Qtrue : Qfalse;
   }
 
   Object* Float::lt(STATE, Float* other) {
-    return this->val < other->val ? Qtrue : Qfalse;
+    return this->val() < other->val() ? Qtrue : Qfalse;
   }
 
   Object* Float::lt(STATE, Integer* other) {
-    return this->val < Float::coerce(state, other)->val ? Qtrue : Qfalse;
+    return this->val() < Float::coerce(state, other)->val() ? Qtrue : Qfalse;
   }
 
   Object* Float::le(STATE, Float* other) {
-    return this->val <= other->val ? Qtrue : Qfalse;
+    return this->val() <= other->val() ? Qtrue : Qfalse;
   }
 
   Object* Float::le(STATE, Integer* other) {
-    return this->val <= Float::coerce(state, other)->val ? Qtrue : Qfalse;
+    return this->val() <= Float::coerce(state, other)->val() ? Qtrue : Qfalse;
   }
 
   Object* Float::fisinf(STATE) {
-    if(std::isinf(this->val) != 0) {
-      return this->val < 0 ? Fixnum::from(-1) : Fixnum::from(1);
+    if(std::isinf(this->val()) != 0) {
+      return this->val() < 0 ? Fixnum::from(-1) : Fixnum::from(1);
     } else {
       return Qnil;
     }
   }
 
   Object* Float::fisnan(STATE) {
-    return std::isnan(this->val) == 1 ? Qtrue : Qfalse;
+    return std::isnan(this->val()) == 1 ? Qtrue : Qfalse;
   }
 
   Integer* Float::fround(STATE) {
-    double value = this->val;
+    double value = this->val();
     if (value > 0.0) value = floor(value+0.5);
     if (value < 0.0) value = ceil(value-0.5);
     return Bignum::from_double(state, value);
   }
 
   Integer* Float::to_i(STATE) {
-    if(this->val > 0.0) {
-      return Bignum::from_double(state, floor(this->val));
-    } else if(this->val < 0.0) {
-      return Bignum::from_double(state, ceil(this->val));
+    if(this->val() > 0.0) {
+      return Bignum::from_double(state, floor(this->val()));
+    } else if(this->val() < 0.0) {
+      return Bignum::from_double(state, ceil(this->val()));
     }
-    return Bignum::from_double(state, this->val);
+    return Bignum::from_double(state, this->val());
   }
 
 #define FLOAT_TO_S_STRLEN   1024
@@ -218,7 +229,7 @@ namespace rubinius {
   String* Float::to_s_formatted(STATE, String* format) {
     char str[FLOAT_TO_S_STRLEN];
 
-    size_t size = snprintf(str, FLOAT_TO_S_STRLEN, format->c_str(), val);
+    size_t size = snprintf(str, FLOAT_TO_S_STRLEN, format->c_str(), val());
 
     if(size >= FLOAT_TO_S_STRLEN) {
       std::ostringstream msg;
@@ -230,14 +241,14 @@ namespace rubinius {
   }
 
   void Float::into_string(STATE, char* buf, size_t sz) {
-    snprintf(buf, sz, "%+.17e", val);
+    snprintf(buf, sz, "%+.17e", val());
   }
 
   void Float::Info::mark(Object* t, ObjectMark& mark) { }
 
   void Float::Info::show(STATE, Object* self, int level) {
     Float* f = as<Float>(self);
-    std::cout << f->val << std::endl;
+    std::cout << f->val() << std::endl;
   }
 
   void Float::Info::show_simple(STATE, Object* self, int level) {
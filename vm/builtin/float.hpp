@@ -23,15 +23,28 @@ namespace rubinius {
     const static object_type type = FloatType;
 
     static bool is_a(Object* obj) {
-      return obj->obj_type == FloatType;
+      return FLONUM_P(obj) || obj->obj_type == FloatType;
     }
 
-    double val;
+    /* Only valid in a boxed Float, use val(). */
+    double value_;
 
     static void init(STATE);
     static Float* create(STATE, double val);
     static Float* coerce(STATE, Object* value);
-    double to_double(STATE) { return val; }
+
+    /* The immediate encoding of val, or NULL if val can't be one. */
+    static Float* to_flonum(double val);
+    double flonum_value() const;
+
+    double val() const {
+#ifdef RBX_FLONUM
+      if(FLONUM_P(this)) return flonum_value();
+#endif
+      return value_;
+    }
+
+    double to_double(STATE) { return val(); }
     void into_string(STATE, char* buf, size_t sz);
 
     // Ruby.primitive! :float_add
@@ -142,6 +155,51 @@ namespace rubinius {
       virtual void show_simple(STATE, Object* self, int level);
     };
   };
+
+#ifdef RBX_FLONUM
+  /* A flonum keeps the sign and mantissa of a double and the low 8 bits
+   * of its exponent, so doubles with a binary exponent from -127 to 128
+   * fit. 0.0 takes over the encoding 2**-127 would have, which is boxed
+   * instead. The bits are rotated left by 4, putting the sign on bit 3
+   * just above the tag and the lowest kept exponent bit on bit 63; the
+   * three dropped exponent bits follow from that one. */
+  const static uint64_t cFlonumZero = 0x8000000000000007ULL;
+  const static uint64_t cFlonumZeroCollision = 0x3800000000000000ULL;
+
+  inline Float* Float::to_flonum(double val) {
+    union { double d; uint64_t u; } bits;
+    bits.d = val;
+
+    unsigned int exp = (unsigned int)(bits.u >> 59) & 0xf;
+    if((exp == 0x7 || exp == 0x8) && bits.u != cFlonumZeroCollision) {
+      uint64_t rot = (bits.u << 4) | (bits.u >> 60);
+      return reinterpret_cast<Float*>((rot & ~(uint64_t)DATA_MASK) | DATA_TAG_FLONUM);
+    } else if(bits.u == 0) {
+      return reinterpret_cast<Float*>(cFlonumZero);
+    }
+
+    return NULL;
+  }
+
+  inline double Float::flonum_value() const {
+    uint64_t v = reinterpret_cast<uintptr_t>(this);
+    if(v == cFlonumZero) return 0.0;
+
+    uint64_t rot = (v & ~(uint64_t)DATA_MASK) | ((v >> 63) ? 0x3 : 0x4);
+
+    union { double d; uint64_t u; } bits;
+    bits.u = (rot >> 4) | (rot << 60);
+    return bits.d;
+  }
+#else
+  inline Float* Float::to_flonum(double val) {
+    return NULL;
+  }
+
+  inline double Float::flonum_value() const {
+    return 0.0;
+  }
+#endif
 }
 
 #endif
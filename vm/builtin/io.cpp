@@ -1,11 +1,22 @@
 #include <iostream>
 
+#include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
+
+#include "detection.hpp"
+
+#ifdef USE_SENDFILE
+#include <sys/sendfile.h>
+#endif
 
 #include "builtin/io.hpp"
+#include "builtin/array.hpp"
 #include "builtin/bytearray.hpp"
 #include "builtin/channel.hpp"
 #include "builtin/class.hpp"
@@ -222,17 +233,150 @@ namespace rubinius {
     return Integer::from(state, cnt);
   }
 
+#ifndef IOV_MAX
+#define IOV_MAX 16
+#endif
+
+  Object* IO::write_vector(STATE, Array* strings, Integer* offset) {
+    struct iovec iov[IOV_MAX];
+    size_t skip = offset->to_native();
+    size_t count = 0;
+
+    for(size_t i = 0; i < strings->size() && count < IOV_MAX; i++) {
+      String* str = as<String>(strings->get(state, i));
+      size_t bytes = str->size();
+
+      // Skip whatever a previous short write already took care of.
+      if(skip >= bytes) {
+        skip -= bytes;
+        continue;
+      }
+
+      iov[count].iov_base = str->byte_address() + skip;
+      iov[count].iov_len = bytes - skip;
+      skip = 0;
+      count++;
+    }
+
+    if(count == 0) return Fixnum::from(0);
+
+    ssize_t cnt;
+    while((cnt = ::writev(this->to_fd(), iov, count)) == -1) {
+      if(errno == EINTR) continue;
+      if(errno == EAGAIN || errno == EWOULDBLOCK) return Qnil;
+
+      Exception::errno_error(state);
+    }
+
+    return Integer::from(state, cnt);
+  }
+
+  static Object* copy_by_read_write(STATE, int in, int out, size_t bytes, off_t* offset) {
+    char buf[IOBUFFER_SIZE];
+    if(bytes > sizeof(buf)) bytes = sizeof(buf);
+
+    ssize_t cnt;
+    while((cnt = offset ? ::pread(in, buf, bytes, *offset) : ::read(in, buf, bytes)) == -1) {
+      if(errno == EINTR) continue;
+      if(errno == EAGAIN || errno == EWOULDBLOCK) return Qfalse;
+
+      Exception::errno_error(state);
+    }
+
+    ssize_t written = 0;
+    while(written < cnt) {
+      ssize_t w = ::write(out, buf + written, cnt - written);
+
+      if(w >= 0) {
+        written += w;
+        continue;
+      }
+
+      if(errno == EINTR) continue;
+      if(errno != EAGAIN && errno != EWOULDBLOCK) Exception::errno_error(state);
+
+      // The destination is full. Give back what was not written so the
+      // caller can wait and resume.
+      if(offset || ::lseek(in, written - cnt, SEEK_CUR) != -1) {
+        return written > 0 ? (Object*)Integer::from(state, written) : Qnil;
+      }
+
+      // The source can't rewind, so hand the rest to the caller to
+      // write once the destination drains.
+      Array* partial = Array::create(state, 2);
+      partial->set(state, 0, Integer::from(state, written));
+      partial->set(state, 1, String::create(state, buf + written, cnt - written));
+      return partial;
+    }
+
+    return Integer::from(state, cnt);
+  }
+
+  Object* IO::copy_to(STATE, IO* dest, Fixnum* count, Object* offset) {
+    int in = this->to_fd();
+    int out = dest->to_fd();
+    size_t bytes = count->to_native();
+
+    off_t position;
+    off_t* pos = NULL;
+
+    if(Integer* off = try_as<Integer>(offset)) {
+      position = off->to_long_long();
+      pos = &position;
+    }
+
+#ifdef USE_SENDFILE
+    ssize_t cnt;
+    while((cnt = ::sendfile(out, in, pos, bytes)) == -1) {
+      if(errno == EINTR) continue;
+      if(errno == EAGAIN) return Qnil;
+
+      // The source is not something sendfile can map, e.g. a pipe or
+      // socket. Fall back to copying it ourselves.
+      if(errno == EINVAL || errno == ENOSYS) break;
+
+      Exception::errno_error(state);
+    }
+
+    if(cnt >= 0) return Integer::from(state, cnt);
+#endif
+
+    return copy_by_read_write(state, in, out, bytes, pos);
+  }
+
   Object* IO::blocking_read(STATE, Fixnum* bytes) {
+    // poll(2) ignores a negative fd, which would look like no data yet
+    // and leave the caller waiting on the event loop for a closed IO.
+    ensure_open(state);
+
+    struct pollfd pfd;
+    pfd.fd = this->to_fd();
+    pfd.events = POLLIN;
+
+    // Never let ::read block the whole VM. If nothing is available yet
+    // the caller waits on the event loop, which only parks the current
+    // Thread, and tries again.
+    int ready;
+    while((ready = ::poll(&pfd, 1, 0)) == -1) {
+      if(errno != EINTR) Exception::errno_error(state);
+    }
+
+    if(ready == 0) return Qfalse;
+
     String* str = String::create(state, bytes);
 
-    ssize_t cnt = ::read(this->to_fd(), str->data()->bytes, bytes->to_native());
-    if(cnt == -1) {
+    ssize_t cnt;
+    while((cnt = ::read(this->to_fd(), str->data()->bytes, bytes->to_native())) == -1) {
+      if(errno == EINTR) continue;
+      if(errno == EAGAIN || errno == EWOULDBLOCK) return Qfalse;
+
       Exception::errno_error(state);
-    } else if(cnt == 0) {
-      return Qnil;
     }
 
+    if(cnt == 0) return Qnil;
+
     str->num_bytes(state, Fixnum::from(cnt));
+    str->characters(state, Fixnum::from(cnt));
 
     return str;
   }
@@ -5,6 +5,7 @@
 #include "type_info.hpp"
 
 namespace rubinius {
+  class Array;
   class ByteArray;
   class Channel;
   class String;
@@ -58,6 +59,35 @@ namespace rubinius {
     // Ruby.primitive :io_write
     Object* write(STATE, String* buf);
 
+    /**
+     *  Write the contents of every String in +strings+ with a single
+     *  writev(2), skipping the first +offset+ bytes that an earlier
+     *  call already wrote.
+     *
+     *  Returns the number of bytes written, which may be less than
+     *  requested, or nil if the descriptor is non-blocking and the
+     *  write would block. The caller is expected to wait for the
+     *  descriptor to become writable and call again.
+     */
+    // Ruby.primitive :io_writev
+    Object* write_vector(STATE, Array* strings, Integer* offset);
+
+    /**
+     *  Copy up to +count+ bytes from this IO to +dest+ without passing
+     *  them through the object heap. Uses sendfile(2) where available,
+     *  otherwise a read/write loop over a native buffer. If +offset+ is
+     *  an Integer the source is read from that position and its file
+     *  position is left unchanged.
+     *
+     *  Returns the number of bytes copied, 0 at end of file, nil if
+     *  +dest+ would block or false if this IO has nothing to read yet.
+     *  If +dest+ fills up partway and this IO can't seek back, such as
+     *  a pipe, returns [bytes copied, String of the bytes read but not
+     *  written] for the caller to write once +dest+ is writable.
+     */
+    // Ruby.primitive :io_copy_to
+    Object* copy_to(STATE, IO* dest, Fixnum* count, Object* offset);
+
     // Ruby.primitive :io_open
     static Fixnum* open(STATE, String* path, Fixnum* mode, Fixnum* perm);
 
@@ -77,6 +107,14 @@ namespace rubinius {
     // Ruby.primitive :io_shutdown
     Object* shutdown(STATE, Fixnum* how);
 
+    /**
+     *  Read up to +count+ bytes if the descriptor has data available.
+     *
+     *  Returns the String read, nil at end of file, or false if the
+     *  read would block, in which case the caller should wait for the
+     *  descriptor to become readable and try again. Raises IOError if
+     *  the IO is closed.
+     */
     // Ruby.primitive :io_blocking_read
     Object* blocking_read(STATE, Fixnum* count);
 
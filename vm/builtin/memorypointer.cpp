@@ -97,7 +97,7 @@ namespace rubinius {
   }
 
   Float* MemoryPointer::write_float(STATE, Float* flt) {
-    *(double*)pointer = flt->val;
+    *(double*)pointer = flt->val();
     return flt;
   }
 
@@ -3,6 +3,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <alloca.h>
 #include <unistd.h>
 #include <sys/stat.h>
 #include <dlfcn.h>
@@ -287,178 +288,128 @@ namespace rubinius {
     return func;
   }
 
-  void **NativeFunction::marshal_arguments(STATE, Message* msg) {
-    void **values;
+  void NativeFunction::marshal_arguments(STATE, Message* msg, void** values,
+                                         ffi_value* storage) {
     Object* obj;
     struct ffi_stub *stub = (struct ffi_stub*)data_->pointer;
 
-    values = ALLOC_N(void*, stub->arg_count);
-
     for(size_t i = 0; i < stub->arg_count; i++) {
+      ffi_value* tmp = &storage[i];
+      values[i] = tmp;
+
       switch(stub->arg_types[i]) {
-      case RBX_FFI_TYPE_CHAR: {
-        char *tmp = (char*)malloc(sizeof(char));
+      case RBX_FFI_TYPE_CHAR:
         obj = msg->get_argument(i);
         type_assert(state, obj, FixnumType, "converting to char");
-        *tmp = (char)as<Fixnum>(obj)->to_native();
-        values[i] = tmp;
+        tmp->c = (char)as<Fixnum>(obj)->to_native();
         break;
-      }
-      case RBX_FFI_TYPE_UCHAR: {
-        unsigned char *tmp = (unsigned char*)malloc(sizeof(char));
+      case RBX_FFI_TYPE_UCHAR:
         obj = msg->get_argument(i);
         type_assert(state, obj, FixnumType, "converting to char");
-        *tmp = (unsigned char)as<Fixnum>(obj)->to_native();
-        values[i] = tmp;
+        tmp->uc = (unsigned char)as<Fixnum>(obj)->to_native();
         break;
-      }
-      case RBX_FFI_TYPE_SHORT: {
-        short *tmp = (short*)malloc(sizeof(short));
+      case RBX_FFI_TYPE_SHORT:
         obj = msg->get_argument(i);
         type_assert(state, obj, FixnumType, "converting to char");
-        *tmp = (short)as<Fixnum>(obj)->to_native();
-        values[i] = tmp;
+        tmp->s = (short)as<Fixnum>(obj)->to_native();
         break;
-      }
-      case RBX_FFI_TYPE_USHORT: {
-        unsigned short *tmp = (unsigned short*)malloc(sizeof(short));
+      case RBX_FFI_TYPE_USHORT:
         obj = msg->get_argument(i);
         type_assert(state, obj, FixnumType, "converting to char");
-        *tmp = (unsigned short)as<Fixnum>(obj)->to_native();
-        values[i] = tmp;
+        tmp->us = (unsigned short)as<Fixnum>(obj)->to_native();
         break;
-      }
-      case RBX_FFI_TYPE_INT: {
-        int *tmp = (int*)malloc(sizeof(int));
+      case RBX_FFI_TYPE_INT:
         obj = msg->get_argument(i);
         if(FIXNUM_P(obj)) {
-          *tmp = as<Fixnum>(obj)->to_int();
+          tmp->i = as<Fixnum>(obj)->to_int();
         } else {
           type_assert(state, obj, BignumType, "converting to int");
-          *tmp = as<Bignum>(obj)->to_int();
+          tmp->i = as<Bignum>(obj)->to_int();
         }
-        values[i] = tmp;
         break;
-      }
-      case RBX_FFI_TYPE_UINT: {
-        unsigned int *tmp = (unsigned int*)malloc(sizeof(unsigned int));
+      case RBX_FFI_TYPE_UINT:
         obj = msg->get_argument(i);
         if(FIXNUM_P(obj)) {
-          *tmp = as<Fixnum>(obj)->to_uint();
+          tmp->ui = as<Fixnum>(obj)->to_uint();
         } else {
           type_assert(state, obj, BignumType, "converting to unsigned int");
-          *tmp = as<Bignum>(obj)->to_uint();
+          tmp->ui = as<Bignum>(obj)->to_uint();
         }
-        values[i] = tmp;
         break;
-      }
-      case RBX_FFI_TYPE_LONG: {
-        long *tmp = (long*)malloc(sizeof(long));
+      case RBX_FFI_TYPE_LONG:
         obj = msg->get_argument(i);
         if(FIXNUM_P(obj)) {
-          *tmp = as<Fixnum>(obj)->to_long();
+          tmp->l = as<Fixnum>(obj)->to_long();
         } else {
           type_assert(state, obj, BignumType, "converting to long");
-          *tmp = as<Bignum>(obj)->to_long();
+          tmp->l = as<Bignum>(obj)->to_long();
         }
-        values[i] = tmp;
         break;
-      }
-      case RBX_FFI_TYPE_ULONG: {
-        unsigned long *tmp = (unsigned long*)malloc(sizeof(long));
+      case RBX_FFI_TYPE_ULONG:
         obj = msg->get_argument(i);
         if(FIXNUM_P(obj)) {
-          *tmp = as<Fixnum>(obj)->to_ulong();
+          tmp->ul = as<Fixnum>(obj)->to_ulong();
         } else {
           type_assert(state, obj, BignumType, "converting to unsigned long");
-          *tmp = as<Bignum>(obj)->to_ulong();
+          tmp->ul = as<Bignum>(obj)->to_ulong();
         }
-        values[i] = tmp;
         break;
-      }
-      case RBX_FFI_TYPE_FLOAT: {
-        float *tmp = (float*)malloc(sizeof(float));
+      case RBX_FFI_TYPE_FLOAT:
         obj = msg->get_argument(i);
         type_assert(state, obj, FloatType, "converting to float");
-        *tmp = (float)as<Float>(obj)->to_double(state);
-        values[i] = tmp;
+        tmp->f = (float)as<Float>(obj)->to_double(state);
         break;
-      }
-      case RBX_FFI_TYPE_DOUBLE: {
-        double *tmp = (double*)malloc(sizeof(double));
+      case RBX_FFI_TYPE_DOUBLE:
         obj = msg->get_argument(i);
         type_assert(state, obj, FloatType, "converting to double");
-        *tmp = as<Float>(obj)->to_double(state);
-        values[i] = tmp;
+        tmp->d = as<Float>(obj)->to_double(state);
         break;
-      }
-      case RBX_FFI_TYPE_LONG_LONG: {
-        long long *tmp = (long long*)malloc(sizeof(long long));
+      case RBX_FFI_TYPE_LONG_LONG:
         obj = msg->get_argument(i);
         if(FIXNUM_P(obj)) {
-          *tmp = as<Fixnum>(obj)->to_long_long();
+          tmp->ll = as<Fixnum>(obj)->to_long_long();
         } else {
           type_assert(state, obj, BignumType, "converting to long long");
-          *tmp = as<Bignum>(obj)->to_long_long();
+          tmp->ll = as<Bignum>(obj)->to_long_long();
         }
-        values[i] = tmp;
         break;
-      }
-      case RBX_FFI_TYPE_ULONG_LONG: {
-        unsigned long long *tmp = (unsigned long long*)malloc(sizeof(long long));
+      case RBX_FFI_TYPE_ULONG_LONG:
         obj = msg->get_argument(i);
         if(FIXNUM_P(obj)) {
-          *tmp = as<Fixnum>(obj)->to_ulong_long();
+          tmp->ull = as<Fixnum>(obj)->to_ulong_long();
         } else {
           type_assert(state, obj, BignumType, "converting to unsigned long long");
-          *tmp = as<Bignum>(obj)->to_ulong_long();
+          tmp->ull = as<Bignum>(obj)->to_ulong_long();
         }
-        values[i] = tmp;
         break;
-      }
-      case RBX_FFI_TYPE_STATE: {
-        VM **tmp = (VM**)malloc(sizeof(VM*));
-        *tmp = state;
-        values[i] = tmp;
+      case RBX_FFI_TYPE_STATE:
+        tmp->ptr = state;
         break;
-      }
-      case RBX_FFI_TYPE_OBJECT: {
-        Object* *tmp = (Object**)malloc(sizeof(Object*));
-        obj = msg->get_argument(i);
-        *tmp = obj;
-        values[i] = tmp;
+      case RBX_FFI_TYPE_OBJECT:
+        tmp->ptr = msg->get_argument(i);
         break;
-      }
-      case RBX_FFI_TYPE_PTR: {
-        void **tmp = (void**)malloc(sizeof(void*));
+      case RBX_FFI_TYPE_PTR:
         obj = msg->get_argument(i);
         if(NIL_P(obj)) {
-          *tmp = NULL;
+          tmp->ptr = NULL;
         } else {
           MemoryPointer *mp = as<MemoryPointer>(obj);
           type_assert(state, obj, MemoryPointerType, "converting to pointer");
-          *tmp = mp->pointer;
+          tmp->ptr = mp->pointer;
         }
-        values[i] = tmp;
         break;
-      }
-      case RBX_FFI_TYPE_STRING: {
+      case RBX_FFI_TYPE_STRING:
         /** @todo String should be copied? --rue */
-        char** tmp = (char**)malloc(sizeof(char*));
         obj = msg->get_argument(i);
         if(NIL_P(obj)) {
-          *tmp = NULL;
+          tmp->ptr = NULL;
         } else {
           String* so = as<String>(obj);
-          *tmp = const_cast<char*>(so->c_str());
+          tmp->ptr = const_cast<char*>(so->c_str());
         }
-        values[i] = tmp;
         break;
       }
-      }
     }
-
-    return values;
   }
 
   Object* NativeFunction::call(STATE, Message* msg) {
@@ -466,7 +417,10 @@ namespace rubinius {
 
     struct ffi_stub *stub = (struct ffi_stub*)data_->pointer;
 
-    void **values = marshal_arguments(state, msg);
+    void** values = (void**)alloca(sizeof(void*) * stub->arg_count);
+    ffi_value* storage = (ffi_value*)alloca(sizeof(ffi_value) * stub->arg_count);
+
+    marshal_arguments(state, msg, values, storage);
 
     // @todo Remove this condition once the tests are cleaned
     // up to setup Message properly.
@@ -600,15 +554,6 @@ namespace rubinius {
     }
     }
 
-    /* @todo fix marshal_argumets to not malloc memory for every arg.
-     * use a single block. */
-    /* Free the memory used to store the args */
-    for(size_t i = 0; i < stub->arg_count; i++) {
-      free(values[i]);
-    }
-
-    free(values);
-
     return ret;
   }
 
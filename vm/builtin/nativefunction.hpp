@@ -40,8 +40,31 @@ namespace rubinius {
     // Ruby.primitive :nativefunction_bind
     static NativeFunction* bind(STATE, Object* library, String* name, Array* args, Object* ret);
 
+    /** Storage for one marshalled argument, large enough for any FFI type. */
+    union ffi_value {
+      char c;
+      unsigned char uc;
+      short s;
+      unsigned short us;
+      int i;
+      unsigned int ui;
+      long l;
+      unsigned long ul;
+      long long ll;
+      unsigned long long ull;
+      float f;
+      double d;
+      void* ptr;
+    };
+
     void bind(STATE, int arg_count, int *arg_types, int ret_type, void* func);
-    void **marshal_arguments(STATE, Message *msg);
+
+    /**
+     *  Convert the arguments in +msg+ into +storage+ and point each
+     *  entry of +values+ at its slot. Both arrays are supplied by the
+     *  caller, so a call does not touch the heap.
+     */
+    void marshal_arguments(STATE, Message *msg, void** values, ffi_value* storage);
     Object* call(STATE, Message* msg);
 
     struct ffi_stub {
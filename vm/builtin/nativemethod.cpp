@@ -62,10 +62,16 @@ namespace rubinius {
       break;  /* Never reached */
 
     case NativeMethodContext::RETURN_FROM_C:
+      /* Back on the VM stack, so the native one can be reused. */
+      context->release_frame();
       context->task()->native_return(context->return_value());
       NativeMethodContext::current_context_is(NULL);
       break;
 
+    case NativeMethodContext::ERROR_RAISED:
+      context->release_frame();
+      break;
+
     case NativeMethodContext::SEGFAULT_DETECTED:
       break;
 
@@ -155,6 +161,7 @@ namespace rubinius {
         message->clear_caller();
 
         Handle ret_handle = context->method()->functor_as<ArgcFunctor>()(message->args(), args, receiver);
+        delete [] args;
 
         context = NativeMethodContext::current();
         context->return_value(context->object_from(ret_handle));
@@ -279,6 +286,7 @@ namespace rubinius {
       goto leave;
     }
 
+    context->flush_cached_data();
     context->action(NativeMethodContext::RETURN_FROM_C);
 
   leave:
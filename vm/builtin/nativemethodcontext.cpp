@@ -1,9 +1,11 @@
 #include <cstdlib>
+#include <cstring>
 
 #include "objectmemory.hpp"
 #include "vm.hpp"
 
 #include "builtin/array.hpp"
+#include "builtin/bytearray.hpp"
 #include "builtin/class.hpp"
 #include "builtin/string.hpp"
 #include "builtin/symbol.hpp"
@@ -12,6 +14,7 @@
 #include "builtin/nativemethodcontext.hpp"
 
 #include "message.hpp"
+#include "native_thread.hpp"
 
 namespace rubinius {
 
@@ -20,11 +23,33 @@ namespace rubinius {
 
 
   /**
-   *  Currently active NativeMethodContext access.
-   *
-   *  @todo use thread-local.
+   *  Currently active NativeMethodContext access, per native thread.
+   */
+  static native::ThreadLocal<NativeMethodContext*> hidden_current_native_context;
+
+  static void free_global_handles(void* handles) {
+    delete static_cast<HandleStorage*>(handles);
+  }
+
+  static void free_frame_pool(void* pool) {
+    std::vector<NativeFrame*>* frames = static_cast<std::vector<NativeFrame*>*>(pool);
+
+    for(std::size_t i = 0; i < frames->size(); i++) {
+      delete [] static_cast<char*>((*frames)[i]->stack);
+      delete (*frames)[i]->message;
+      delete (*frames)[i];
+    }
+
+    delete frames;
+  }
+
+  /**
+   *  Global handles and pooled frames, per native thread. The handles
+   *  point into the heap of the VM running on the thread and are updated
+   *  by its GC, so they can't be shared with other VMs.
    */
-  static NativeMethodContext* hidden_current_native_context = NULL;
+  static native::ThreadLocal<HandleStorage*> hidden_global_handles(free_global_handles);
+  static native::ThreadLocal<std::vector<NativeFrame*>*> hidden_frame_pool(free_frame_pool);
 
 
   /* Class methods */
@@ -47,10 +72,8 @@ namespace rubinius {
                                                    Task* task,
                                                    NativeMethod* method)
   {
-    static std::size_t context_size = sizeof(NativeMethodContext) + DEFAULT_STACK_SIZE;
-
     NativeMethodContext* nmc = static_cast<NativeMethodContext*>(state->new_struct(G(nativectx),
-                                                                 context_size));
+                                                                 sizeof(NativeMethodContext)));
 
     /* MethodContext stuff. */
     MethodContext* sender = task->active();
@@ -66,28 +89,25 @@ namespace rubinius {
     nmc->cm(state, reinterpret_cast<CompiledMethod*>(Qnil));
     nmc->vmm = NULL;
 
-    /* Instead of storing the memory within as MethodContexts, we heap-allocate. */
-    nmc->stack_size = DEFAULT_STACK_SIZE;
+    /* MethodContext's stk is unused, the C stack comes from the frame. */
+    nmc->stack_size = 0;
+
+    NativeFrame* frame = acquire_frame(state);
 
     nmc->action_          = ORIGINAL_CALL;
-    nmc->handles_         = new HandleStorage();
+    nmc->frame_           = frame;
+    nmc->handles_         = &frame->handles;
     nmc->message_         = msg;
-    nmc->message_from_c_  = new Message(state);
+    nmc->message_from_c_  = frame->message;
     nmc->method_          = method;
     nmc->return_value_    = Qnil;
-    nmc->stack_           = static_cast<void*>(new char[nmc->stack_size]);
+    nmc->stack_           = frame->stack;
     nmc->state_           = state;
     nmc->task_            = task;
 
-    nmc->current_file_    = ::strdup("<no file set>");
+    nmc->current_file_    = "<no file set>";
     nmc->current_line_    = 0;
 
-    /* Add the basic Handles. Always crossref with ruby.h when changing. */
-    nmc->handles_->push_back(Qfalse);
-    nmc->handles_->push_back(Qtrue);
-    nmc->handles_->push_back(Qnil);
-    nmc->handles_->push_back(Qundef);
-
     nmc->message_from_c_->set_caller(nmc);
 
     return nmc;
@@ -99,17 +119,58 @@ namespace rubinius {
 
   void NativeMethodContext::current_context_is(NativeMethodContext* context)
   {
-    hidden_current_native_context = context;
+    hidden_current_native_context.set(context);
   }
 
   NativeMethodContext* NativeMethodContext::current()
   {
-     return hidden_current_native_context;
+     return hidden_current_native_context.get();
   }
 
   HandleStorage& NativeMethodContext::global_handles() {
-    static HandleStorage our_global_handles;
-    return our_global_handles;
+    HandleStorage* handles = hidden_global_handles.get();
+
+    if(!handles) {
+      handles = new HandleStorage();
+      hidden_global_handles.set(handles);
+    }
+
+    return *handles;
+  }
+
+  std::vector<NativeFrame*>& NativeMethodContext::frame_pool() {
+    std::vector<NativeFrame*>* pool = hidden_frame_pool.get();
+
+    if(!pool) {
+      pool = new std::vector<NativeFrame*>();
+      hidden_frame_pool.set(pool);
+    }
+
+    return *pool;
+  }
+
+  NativeFrame* NativeMethodContext::acquire_frame(VM* state) {
+    std::vector<NativeFrame*>& pool = frame_pool();
+    NativeFrame* frame;
+
+    if(pool.empty()) {
+      frame = new NativeFrame();
+      frame->stack = static_cast<void*>(new char[DEFAULT_STACK_SIZE]);
+      frame->message = new Message(state);
+
+      /* Add the basic Handles. Always crossref with ruby.h when changing. */
+      frame->handles.push_back(Qfalse);
+      frame->handles.push_back(Qtrue);
+      frame->handles.push_back(Qnil);
+      frame->handles.push_back(Qundef);
+    } else {
+      frame = pool.back();
+      pool.pop_back();
+
+      *frame->message = Message(state);
+    }
+
+    return frame;
   }
 
 
@@ -135,11 +196,9 @@ namespace rubinius {
     return current_line_;
   }
 
+  /** The file name is always __FILE__ from ruby.h, so it is not copied. */
   void NativeMethodContext::current_location(const char* file, std::size_t line) {
-    if(current_file_) {
-      free(current_file_);
-    }
-    current_file_ = ::strdup(file);
+    current_file_ = file;
     current_line_ = line;
   }
 
@@ -148,8 +207,10 @@ namespace rubinius {
   }
 
   /**
-   *  NOTE: Unlike object_for(), this is _always_ a local Handle.
-   *        @see handle_for_global() instead.
+   *  NOTE: Unlike object_for(), this is a local Handle except for
+   *        false, true, nil and undef, which always get the same
+   *        global Handles so that RTEST() and NIL_P() can compare
+   *        Handles directly. @see handle_for_global() instead.
    *
    *  @todo Currently, a Handle may have an entry _both_ in local
    *        handles as well as globals. This should hopefully not
@@ -157,10 +218,14 @@ namespace rubinius {
    *        global object must always be available. The extras are
    *        unlikely to impede here, since the object itself is
    *        guarded against collection.
-   *
-   *  @todo Concurrency.
    */
   Handle NativeMethodContext::handle_for(Object* object) {
+    /* The special objects always use their fixed global handles, see ruby.h. */
+    if(object == Qfalse) return -1;
+    if(object == Qtrue)  return -2;
+    if(object == Qnil)   return -3;
+    if(object == Qundef) return -4;
+
     handles_->push_back(object);
     return (handles_->size() - 1);
   }
@@ -172,8 +237,6 @@ namespace rubinius {
    *
    *  @todo Should the objects be remembered or set
    *        mature here? Unlikely, but needs verification.
-   *
-   *  @todo Concurrency.
    */
   Handle NativeMethodContext::handle_for_global(Object* object) {
     HandleStorage& globals = NativeMethodContext::global_handles();
@@ -190,13 +253,40 @@ namespace rubinius {
     return (0 - globals.size());
   }
 
-  void NativeMethodContext::mark_handles(ObjectMark& mark) {
-    for (HandleStorage::iterator it = handles_->begin(); it != handles_->end(); ++it) {
-      Object* marked = mark.call(*it);
+  void NativeMethodContext::release_frame() {
+    if(!frame_) return;
 
-      if (marked) {
-        *it = marked;
-        mark.just_set(this, marked);
+    NativeFrame* frame = frame_;
+    std::vector<NativeFrame*>& pool = frame_pool();
+
+    frame_ = NULL;
+    handles_ = NULL;
+    message_from_c_ = NULL;
+    stack_ = NULL;
+
+    if(pool.size() >= MAX_POOLED_FRAMES) {
+      delete [] static_cast<char*>(frame->stack);
+      delete frame->message;
+      delete frame;
+      return;
+    }
+
+    /* Drop the local handles but keep the arena's capacity. */
+    frame->handles.resize(BASIC_HANDLES);
+    frame->strings.clear();
+    frame->arrays.clear();
+    pool.push_back(frame);
+  }
+
+  void NativeMethodContext::mark_handles(ObjectMark& mark) {
+    if(handles_) {
+      for (HandleStorage::iterator it = handles_->begin(); it != handles_->end(); ++it) {
+        Object* marked = mark.call(*it);
+
+        if (marked) {
+          *it = marked;
+          mark.just_set(this, marked);
+        }
       }
     }
 
@@ -234,13 +324,187 @@ namespace rubinius {
 
 
 
+/* Cached views for RSTRING() and RARRAY() */
+
+
+  /** Elements that are still the same object keep their Handle, so refills do not grow the arena. */
+  static void fill_array(NativeMethodContext* context, CachedArray& view, Array* array) {
+    std::size_t size = array->size();
+    std::size_t known = view.valid ? view.storage.size() : 0;
+
+    view.storage.resize(size);
+
+    for(std::size_t i = 0; i < size; ++i) {
+      Object* element = array->get(context->state(), i);
+
+      if(i >= known || context->object_from(view.storage[i]) != element) {
+        view.storage[i] = context->handle_for(element);
+      }
+    }
+
+    view.snapshot = view.storage;
+
+    view.len = size;
+    view.ptr = (size > 0) ? &view.storage[0] : NULL;
+    view.valid = true;
+  }
+
+  /** Untouched views are found with a memcmp against the snapshot and skipped. */
+  static void write_back_array(NativeMethodContext* context, CachedArray& view, Array* array) {
+    std::size_t len = (view.len > 0) ? view.len : 0;
+    Handle* own = view.storage.empty() ? NULL : &view.storage[0];
+
+    if(view.ptr == own && len == view.snapshot.size() &&
+        (len == 0 || std::memcmp(own, &view.snapshot[0], len * sizeof(Handle)) == 0)) {
+      return;
+    }
+
+    for(std::size_t i = 0; i < len; ++i) {
+      array->set(context->state(), i, context->object_from(view.ptr[i]));
+    }
+
+    if(len < array->size()) {
+      array->total(context->state(), Fixnum::from(len));
+    }
+  }
+
+  static void fill_string(NativeMethodContext* context, CachedString& view, String* string) {
+    if(string->shared()->true_p()) string->unshare(context->state());
+
+    view.len = string->size();
+    view.ptr = string->byte_address();
+    view.valid = true;
+  }
+
+  /**
+   *  Writes through ptr went straight into the data, so that only
+   *  needs handling if C code pointed ptr elsewhere or cut len.
+   *  The C code keeps ownership of a ptr it supplied.
+   */
+  static void write_back_string(NativeMethodContext* context, CachedString& view, String* string) {
+    std::size_t len = (view.len > 0) ? view.len : 0;
+
+    if(view.ptr != string->byte_address()) {
+      ByteArray* data = ByteArray::create(context->state(), len + 1);
+
+      if(view.ptr) std::memcpy(data->bytes, view.ptr, len);
+      data->bytes[len] = '\0';
+
+      string->data(context->state(), data);
+      string->shared(context->state(), Qfalse);
+    }
+    else if(len < string->size()) {
+      string->data()->bytes[len] = '\0';
+    }
+    else {
+      len = string->size();
+    }
+
+    Integer* bytes = Integer::from(context->state(), len);
+
+    string->num_bytes(context->state(), bytes);
+    string->characters(context->state(), bytes);
+    string->hash_value(context->state(), reinterpret_cast<Integer*>(Qnil));
+  }
+
+  /**
+   *  handle_for() gives out a new Handle each time, so the view of the
+   *  object may be under another Handle already. Objects can move while
+   *  the VM runs, so the keys are Handles and this compares the objects
+   *  behind them; a call rarely has more than a few views.
+   */
+  template <typename Cache>
+  static typename Cache::iterator find_view(NativeMethodContext* context,
+                                            Cache& cache, Handle handle) {
+    Object* object = context->object_from(handle);
+
+    for(typename Cache::iterator it = cache.begin(); it != cache.end(); ++it) {
+      if(context->object_from(it->first) == object) return it;
+    }
+
+    return cache.end();
+  }
+
+  CachedArray* NativeMethodContext::cached_array(Handle handle) {
+    ArrayCache::iterator it = find_view(this, frame_->arrays, handle);
+    if(it == frame_->arrays.end()) {
+      it = frame_->arrays.insert(std::make_pair(handle, CachedArray())).first;
+    }
+
+    CachedArray& view = it->second;
+
+    if(!view.valid) {
+      fill_array(this, view, as<Array>(object_from(handle)));
+    }
+
+    return &view;
+  }
+
+  CachedString* NativeMethodContext::cached_string(Handle handle) {
+    StringCache::iterator it = find_view(this, frame_->strings, handle);
+    if(it == frame_->strings.end()) {
+      it = frame_->strings.insert(std::make_pair(handle, CachedString())).first;
+    }
+
+    CachedString& view = it->second;
+
+    if(!view.valid) {
+      fill_string(this, view, as<String>(object_from(handle)));
+    }
+
+    return &view;
+  }
+
+  void NativeMethodContext::flush_cached_data() {
+    for(ArrayCache::iterator it = frame_->arrays.begin(); it != frame_->arrays.end(); ++it) {
+      if(it->second.valid) {
+        write_back_array(this, it->second, as<Array>(object_from(it->first)));
+      }
+    }
+
+    for(StringCache::iterator it = frame_->strings.begin(); it != frame_->strings.end(); ++it) {
+      if(it->second.valid) {
+        write_back_string(this, it->second, as<String>(object_from(it->first)));
+      }
+    }
+  }
+
+  void NativeMethodContext::invalidate_cached(Handle handle) {
+    ArrayCache::iterator array = find_view(this, frame_->arrays, handle);
+
+    if(array != frame_->arrays.end() && array->second.valid) {
+      write_back_array(this, array->second, as<Array>(object_from(handle)));
+      array->second.valid = false;
+    }
+
+    StringCache::iterator string = find_view(this, frame_->strings, handle);
+
+    if(string != frame_->strings.end() && string->second.valid) {
+      write_back_string(this, string->second, as<String>(object_from(handle)));
+      string->second.valid = false;
+    }
+  }
+
+  void NativeMethodContext::update_cached_data() {
+    for(ArrayCache::iterator it = frame_->arrays.begin(); it != frame_->arrays.end(); ++it) {
+      if(it->second.valid) {
+        fill_array(this, it->second, as<Array>(object_from(it->first)));
+      }
+    }
+
+    for(StringCache::iterator it = frame_->strings.begin(); it != frame_->strings.end(); ++it) {
+      if(it->second.valid) {
+        fill_string(this, it->second, as<String>(object_from(it->first)));
+      }
+    }
+  }
+
+
+
 /* Info stuff */
 
   void NativeMethodContext::Info::cleanup(Object* object) {
-    NativeMethodContext* context = as<NativeMethodContext>(object);
-
-    delete [] static_cast<char*>(context->stack_);
-    context->stack_ = NULL;
+    as<NativeMethodContext>(object)->release_frame();
   }
 
   void NativeMethodContext::Info::mark(Object* self, ObjectMark& mark) {
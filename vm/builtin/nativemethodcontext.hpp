@@ -2,6 +2,7 @@
 #define RBX_BUILTIN_NATIVEMETHODCONTEXT_HPP
 
 /* Std */
+#include <map>
 #include <sstream>
 #include <vector>
 
@@ -30,6 +31,60 @@ namespace rubinius {
   typedef intptr_t Handle;
 
 
+  /**
+   *  C view of a String handed out by RSTRING().
+   *
+   *  The first two members must match struct RString in subtend/ruby.h.
+   */
+  struct CachedString {
+    long            len;
+    char*           ptr;
+    bool            valid;
+  };
+
+  /**
+   *  C view of an Array handed out by RARRAY(). The elements are
+   *  Handles kept in +storage+ and written back to the Array when
+   *  control goes back to the VM, unless they still match +snapshot+.
+   *
+   *  The first two members must match struct RArray in subtend/ruby.h.
+   */
+  struct CachedArray {
+    long                len;
+    Handle*             ptr;
+    bool                valid;
+    std::vector<Handle> storage;
+    std::vector<Handle> snapshot;
+  };
+
+  /**
+   *  Views by the first Handle they were asked for. There is only one
+   *  view per object, whichever Handle reaches it, so that flushing one
+   *  view can't undo writes made through another. std::map so that their
+   *  addresses stay put.
+   */
+  typedef std::map<Handle, CachedString> StringCache;
+  typedef std::map<Handle, CachedArray>  ArrayCache;
+
+
+  /**
+   *  Per-call native resources: the separate C stack, the handle
+   *  arena and the Message used for calls back into the VM.
+   *
+   *  These are kept in a pool and reused so that a call into an
+   *  extension does not have to allocate any of them. The handle
+   *  arena keeps its capacity and is only truncated back to the
+   *  basic handles when the frame is returned to the pool.
+   */
+  struct NativeFrame {
+    void*           stack;
+    HandleStorage   handles;
+    Message*        message;
+    StringCache     strings;
+    ArrayCache      arrays;
+  };
+
+
   /**
   *   Method context for C-implemented methods.
   *
@@ -83,6 +138,12 @@ namespace rubinius {
     /** 64KiB -- Do NOT decrease this, ucontext will fail. */
     static const std::size_t DEFAULT_STACK_SIZE = 1024 * 64;
 
+    /** Frames beyond this many are freed rather than pooled. */
+    static const std::size_t MAX_POOLED_FRAMES = 32;
+
+    /** Number of basic Handles at the start of each arena, see ruby.h. */
+    static const std::size_t BASIC_HANDLES = 4;
+
 
   public:   /* Ctors */
 
@@ -104,9 +165,15 @@ namespace rubinius {
     /** Access currently active NativeMethodContext. */
     static NativeMethodContext* current();
 
-    /** Global handles. @todo Concurrency. */
+    /** Global handles of the VM on the calling native thread. */
     static HandleStorage&       global_handles();
 
+    /** Frames available for reuse on the calling native thread. */
+    static std::vector<NativeFrame*>& frame_pool();
+
+    /** Take a frame from the pool or allocate a new one. */
+    static NativeFrame*         acquire_frame(VM* state);
+
 
   public:   /* Primitives */
 
@@ -131,7 +198,7 @@ namespace rubinius {
     NativeMethod*   method()                    const { return method_; }
     Object*         return_value()              const { return return_value_; }
     void            return_value(Object* obj)         { return_value_ = obj; }
-    std::size_t     stacksize()                 const { return stack_size; }
+    std::size_t     stacksize()                 const { return DEFAULT_STACK_SIZE; }
     void*           stack()                           { return stack_; }
     VM*             state()                     const { return state_; }
     Task*           task()                      const { return task_; }
@@ -141,6 +208,36 @@ namespace rubinius {
 
   public:   /* Interface */
 
+    /**
+     *  RARRAY() view of the Array behind the handle. Every handle to
+     *  the same Array gets the same view.
+     *
+     *  The view lives until the call returns, so C code may hold on
+     *  to it. Writes through it reach the Array on the next call back
+     *  into the VM or on return.
+     */
+    CachedArray*  cached_array(Handle handle);
+
+    /**
+     *  RSTRING() view of the String behind the handle.
+     *
+     *  The String is unshared first so that writes through ptr do
+     *  not leak into other Strings. Same lifetime as cached_array().
+     */
+    CachedString* cached_string(Handle handle);
+
+    /** Write changes made through the cached views back into the objects. */
+    void        flush_cached_data();
+
+    /**
+     *  Write back the view of this handle's object, if any, and mark
+     *  it out of date. Used before the object is changed directly.
+     */
+    void        invalidate_cached(Handle handle);
+
+    /** Refresh the cached views after the VM may have changed or moved the objects. */
+    void        update_cached_data();
+
     /** Whatever file information we have last been updated with. */
     const char* current_file() const;
 
@@ -159,6 +256,15 @@ namespace rubinius {
     /** Generate a global handle to refer to the given object from C */
     Handle      handle_for_global(Object* obj);
 
+    /**
+     *  Give the native stack, handles and Message back to the pool.
+     *
+     *  Must only be called once control is back on the VM stack.
+     *  Calling it again, or on a context that never got a frame,
+     *  does nothing.
+     */
+    void        release_frame();
+
     /** Mark handles for GC, including the global handle set. */
     void        mark_handles(ObjectMark& mark);
 
@@ -183,13 +289,14 @@ namespace rubinius {
     DECLARE_POINT_VARIABLE(inside_c_method_point_);
 
     Action          action_;            /**< Action for the VMNativeMethod to perform. */
-    char*           current_file_;      /**< Last updated file name in extension. */
+    const char*     current_file_;      /**< Last updated file name in extension. */
     std::size_t     current_line_;      /**< Last updated line number in extension. */
     Handle          c_return_value_;    /**< Return value for a call back to VM. */
     Message*        message_;           /**< Message representing this call. */
     Message*        message_from_c_;    /**< Message for calls back from the method. */
     NativeMethod*   method_;            /**< Function-like object that actually implements the method. */
     HandleStorage*  handles_;           /**< Object handles for this call. */
+    NativeFrame*    frame_;             /**< Pooled resources backing this call. */
     Object*         return_value_;      /**< Return value from the call. */
     void*           stack_;             /**< Stack for executing the C method. */
     VM*             state_;             /**< VM state for this invocation. */
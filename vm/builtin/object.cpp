@@ -49,6 +49,9 @@ namespace rubinius {
   }
 
   Object* Object::clone(STATE) {
+    // A flonum is its own value, with no header or body to copy.
+    if(!reference_p()) return this;
+
     Object* other = dup(state);
 
     other->copy_internal_state_from(state, this);
@@ -59,6 +62,9 @@ namespace rubinius {
   void Object::copy_flags(STATE, Object* source) {
     this->obj_type        = source->obj_type;
     this->StoresBytes     = source->StoresBytes;
+    if(source->RequiresCleanup && !this->RequiresCleanup) {
+      state->om->track_cleanup(this);
+    }
     this->RequiresCleanup = source->RequiresCleanup;
     this->IsBlockContext  = source->IsBlockContext;
     this->IsMeta          = source->IsMeta;
@@ -78,11 +84,15 @@ namespace rubinius {
   }
 
   Object* Object::dup(STATE) {
+    if(!reference_p()) return this;
+
     Object* other = state->om->allocate_object(this->num_fields());
 
     other->initialize_copy(this, age);
     other->copy_body(this);
 
+    if(other->RequiresCleanup) state->om->track_cleanup(other);
+
     // Set the dup's class this's class
     other->klass(state, class_object(state));
 
@@ -188,6 +198,7 @@ namespace rubinius {
     if(reference_p()) return obj_type;
     if(fixnum_p()) return FixnumType;
     if(symbol_p()) return SymbolType;
+    if(FLONUM_P(this)) return FloatType;
     if(nil_p()) return NilType;
     if(true_p()) return TrueType;
     if(false_p()) return FalseType;
@@ -198,7 +209,12 @@ namespace rubinius {
     hashval hsh;
     hsh = (hashval)(uintptr_t)this;
 
-    if(!reference_p()) {
+    if(Float* flt = try_as<Float>(this)) {
+      /* Hash the double itself so the hash doesn't depend on whether
+       * the Float is a flonum or boxed. */
+      double val = flt->val();
+      hsh = String::hash_str((unsigned char *)&val, sizeof(double));
+    } else if(!reference_p()) {
       /* Get rid of the tag part (i.e. the part that indicate nature of self */
       if(fixnum_p()) {
         native_int val = as<Integer>(this)->to_native();
@@ -213,8 +229,6 @@ namespace rubinius {
         hsh = string->hash_string(state);
       } else if(Bignum* bignum = try_as<Bignum>(this)) {
         hsh = bignum->hash_bignum(state);
-      } else if(Float* flt = try_as<Float>(this)) {
-        hsh = String::hash_str((unsigned char *)(&(flt->val)), sizeof(double));
       } else {
         hsh = id(state)->to_native();
       }
@@ -244,6 +258,21 @@ namespace rubinius {
 
       return as<Integer>(id);
     } else {
+#ifdef RBX_FLONUM
+      /* A flonum uses every bit of the word, so its id is computed in a
+       * Bignum rather than shifted out of a Fixnum's range. */
+      if(FLONUM_P(this)) {
+        mp_int id;
+        mp_init_copy(&id, Bignum::from(state, (unsigned long long)(uintptr_t)this)->mp_val());
+        mp_mul_2(&id, &id);
+        mp_add_d(&id, 1, &id);
+
+        Integer* result = Bignum::normalize(state, &id);
+        mp_clear(&id);
+        return result;
+      }
+#endif
+
       /* All non-references have an odd object_id */
       return Fixnum::from(((uintptr_t)this << 1) | 1);
     }
@@ -231,7 +231,8 @@ namespace rubinius {
      *  Ruby #dup.
      *
      *  Creates and returns a new Object that is a copy of this one
-     *  except for internal state.
+     *  except for internal state. An immediate, such as a flonum, is
+     *  returned as is.
      *
      *  @see  clone()
      */
@@ -1,5 +1,9 @@
 #include "oniguruma.h" // Must be first.
 
+#include <cstring>
+#include <map>
+#include <string>
+
 #include "builtin/regexp.hpp"
 #include "builtin/class.hpp"
 #include "builtin/integer.hpp"
@@ -8,6 +12,8 @@
 #include "builtin/symbol.hpp"
 #include "builtin/tuple.hpp"
 
+#include "native_thread.hpp"
+
 #include "vm.hpp"
 #include "vm/object_utils.hpp"
 #include "objectmemory.hpp"
@@ -26,9 +32,230 @@
 
 namespace rubinius {
 
+  /* Compiled pattern cache */
+
+  namespace {
+    /** Identifies a compiled pattern. */
+    struct PatternKey {
+      std::string     source;
+      OnigOptionType  options;
+      OnigEncoding    encoding;
+
+      bool operator<(const PatternKey& other) const {
+        if(options != other.options) return options < other.options;
+        if(encoding != other.encoding) return encoding < other.encoding;
+        return source < other.source;
+      }
+    };
+
+    struct CachedPattern {
+      regex_t*        reg;
+      std::size_t     references;   /**< Regexps currently using reg. */
+      std::size_t     last_use;
+      std::string     prefix;       /**< Literal every match starts with. */
+    };
+
+    typedef std::map<PatternKey, CachedPattern> PatternCache;
+    typedef std::map<regex_t*, PatternCache::iterator> PatternOwners;
+  }
+
+  /** Patterns beyond this many are compiled without caching. */
+  static const std::size_t cMaxCachedPatterns = 256;
+
+  /**
+   *  Shared by every VM in the process, behind pattern_lock. Compiled
+   *  patterns are only read while searching, so a cached one can be used
+   *  by several VMs at once.
+   */
+  static PatternCache  pattern_cache;
+  static PatternOwners pattern_owners;
+  static std::size_t   pattern_clock = 0;
+  static native::Mutex pattern_lock;
+
+  /**
+   *  Returns the literal bytes every match of the pattern must start
+   *  with, or an empty string. Only plain ASCII characters at the very
+   *  start of a pattern without top level alternation qualify, and only
+   *  for encodings where ASCII bytes never appear inside a multibyte
+   *  character.
+   */
+  static std::string literal_prefix(const std::string& source, OnigOptionType opts, OnigEncoding enc) {
+    const char* metas = "\\^$.|?*+()[]{}";
+    std::size_t size = source.size();
+    std::size_t len = 0;
+
+    if(opts & (ONIG_OPTION_IGNORECASE | ONIG_OPTION_EXTEND)) return "";
+    if(enc != ONIG_ENCODING_ASCII && enc != ONIG_ENCODING_UTF8) return "";
+
+    while(len < size) {
+      unsigned char c = source[len];
+      if(c == 0 || c >= 0x80 || std::strchr(metas, c)) break;
+      len++;
+    }
+
+    /* The last character is optional or repeated, as in "ab?" or "ab{0,2}". */
+    if(len > 0 && len < size && std::strchr("?*{", source[len])) len--;
+    if(len == 0) return "";
+
+    int depth = 0;
+
+    for(std::size_t i = len; i < size; i++) {
+      switch(source[i]) {
+      case '\\':
+        i++;
+        break;
+      case '[':
+        /* Skip the class, a leading ] or ^] is part of it. */
+        if(i + 1 < size && source[i + 1] == '^') i++;
+        if(i + 1 < size && source[i + 1] == ']') i++;
+        for(i++; i < size && source[i] != ']'; i++) {
+          if(source[i] == '\\') i++;
+        }
+        break;
+      case '(':
+        depth++;
+        break;
+      case ')':
+        depth--;
+        break;
+      case '|':
+        if(depth <= 0) return "";
+        break;
+      }
+    }
+
+    return source.substr(0, len);
+  }
+
+  /** Frees the least recently used pattern that no Regexp refers to. */
+  static bool evict_unused_pattern() {
+    PatternCache::iterator victim = pattern_cache.end();
+
+    for(PatternCache::iterator it = pattern_cache.begin(); it != pattern_cache.end(); ++it) {
+      if(it->second.references > 0) continue;
+
+      if(victim == pattern_cache.end() || it->second.last_use < victim->second.last_use) {
+        victim = it;
+      }
+    }
+
+    if(victim == pattern_cache.end()) return false;
+
+    pattern_owners.erase(victim->second.reg);
+    onig_free(victim->second.reg);
+    pattern_cache.erase(victim);
+
+    return true;
+  }
+
+  /**
+   *  Returns the compiled form of the pattern, from the cache if an
+   *  identical source/options/encoding was compiled before. Each
+   *  pattern returned must be handed back to release_pattern().
+   */
+  static int compile_pattern(regex_t** reg, const UChar* pat, const UChar* end,
+                             OnigOptionType opts, OnigEncoding enc, OnigErrorInfo* err_info) {
+    PatternKey key;
+    key.source.assign((const char*)pat, end - pat);
+    key.options  = opts;
+    key.encoding = enc;
+
+    native::LockGuard guard(pattern_lock);
+    PatternCache::iterator found = pattern_cache.find(key);
+
+    if(found != pattern_cache.end()) {
+      found->second.references++;
+      found->second.last_use = ++pattern_clock;
+      *reg = found->second.reg;
+      return ONIG_NORMAL;
+    }
+
+    int err = onig_new(reg, pat, end, opts, enc, ONIG_SYNTAX_RUBY, err_info);
+    if(err != ONIG_NORMAL) return err;
+
+    if(pattern_cache.size() >= cMaxCachedPatterns && !evict_unused_pattern()) {
+      return ONIG_NORMAL;
+    }
+
+    CachedPattern entry;
+    entry.reg        = *reg;
+    entry.references = 1;
+    entry.last_use   = ++pattern_clock;
+    entry.prefix     = literal_prefix(key.source, opts, enc);
+
+    pattern_owners[*reg] = pattern_cache.insert(std::make_pair(key, entry)).first;
+
+    return ONIG_NORMAL;
+  }
+
+  /** Unused cached patterns stay compiled until evicted. */
+  static void release_pattern(regex_t* reg) {
+    native::LockGuard guard(pattern_lock);
+    PatternOwners::iterator owner = pattern_owners.find(reg);
+
+    if(owner == pattern_owners.end()) {
+      onig_free(reg);
+    } else {
+      owner->second->second.references--;
+    }
+  }
+
+  /** Literal prefix of a cached pattern, or NULL if none is known. */
+  static const std::string* pattern_prefix(regex_t* reg) {
+    native::LockGuard guard(pattern_lock);
+    PatternOwners::iterator owner = pattern_owners.find(reg);
+
+    if(owner == pattern_owners.end()) return NULL;
+
+    const std::string& prefix = owner->second->second.prefix;
+    return prefix.empty() ? NULL : &prefix;
+  }
+
+  /** First occurrence of the literal in [from, limit), memchr finding the candidates. */
+  static const UChar* find_literal(const UChar* from, const UChar* limit, const std::string& literal) {
+    const UChar* pat = (const UChar*)literal.data();
+    std::size_t len = literal.size();
+
+    if(limit - from < (long)len) return NULL;
+
+    const UChar* last = limit - len;
+
+    for(const UChar* p = from; p <= last; p++) {
+      p = (const UChar*)std::memchr(p, pat[0], last - p + 1);
+      if(!p) return NULL;
+
+      if(std::memcmp(p + 1, pat + 1, len - 1) == 0) return p;
+    }
+
+    return NULL;
+  }
+
+  static void free_region(void* region) {
+    onig_region_free(static_cast<OnigRegion*>(region), 1);
+  }
+
+  static native::ThreadLocal<OnigRegion*> regions(free_region);
+
+  /**
+   *  Region reused by every search on this native thread. Matches never
+   *  overlap because a VM runs its Ruby code on a single native thread.
+   */
+  static OnigRegion* shared_region() {
+    OnigRegion* region = regions.get();
+
+    if(!region) {
+      region = onig_region_new();
+      regions.set(region);
+    }
+
+    return region;
+  }
+
   void Regexp::Info::cleanup(Object* regexp) {
-    onig_free(as<Regexp>(regexp)->onig_data);
-    as<Regexp>(regexp)->onig_data = NULL;
+    Regexp* re = as<Regexp>(regexp);
+
+    if(re->onig_data) release_pattern(re->onig_data);
+    re->onig_data = NULL;
   }
 
   void Regexp::init(STATE) {
@@ -127,7 +354,7 @@ namespace rubinius {
     enc   = get_enc_from_kcode(kcode);
     opts &= OPTION_MASK;
 
-    err = onig_new(&this->onig_data, pat, end, opts, enc, ONIG_SYNTAX_RUBY, &err_info);
+    err = compile_pattern(&this->onig_data, pat, end, opts, enc, &err_info);
 
     if(err != ONIG_NORMAL) {
       UChar onig_err_buf[ONIG_MAX_ERROR_MESSAGE_LEN];
@@ -175,15 +402,16 @@ namespace rubinius {
     return Integer::from(state, ((int)(option & OPTION_MASK) | get_kcode_from_enc(enc)));
   }
 
+  /**
+   *  The capture offsets go into one flat Tuple, begin and end of
+   *  each group in turn. MatchData pairs them up only when asked.
+   */
   static Object* _md_region_to_tuple(STATE, OnigRegion *region, int max) {
     int i;
-    Tuple* sub;
-    Tuple* tup = Tuple::create(state, region->num_regs - 1);
+    Tuple* tup = Tuple::create(state, (region->num_regs - 1) * 2);
     for(i = 1; i < region->num_regs; i++) {
-      sub = Tuple::create(state, 2);
-      sub->put(state, 0, Integer::from(state, region->beg[i]));
-      sub->put(state, 1, Integer::from(state, region->end[i]));
-      tup->put(state, i - 1, sub);
+      tup->put(state, (i - 1) * 2,     Fixnum::from(region->beg[i]));
+      tup->put(state, (i - 1) * 2 + 1, Fixnum::from(region->end[i]));
     }
     return tup;
   }
@@ -193,8 +421,8 @@ namespace rubinius {
     md->source(state, string->string_dup(state));
     md->regexp(state, regexp);
     Tuple* tup = Tuple::create(state, 2);
-    tup->put(state, 0, Integer::from(state, region->beg[0]));
-    tup->put(state, 1, Integer::from(state, region->end[0]));
+    tup->put(state, 0, Fixnum::from(region->beg[0]));
+    tup->put(state, 1, Fixnum::from(region->end[0]));
 
     md->full(state, tup);
     md->region(state, (Tuple*)_md_region_to_tuple(state, region, max));
@@ -207,7 +435,7 @@ namespace rubinius {
     OnigRegion *region;
     Object* md;
 
-    region = onig_region_new();
+    region = shared_region();
 
     max = string->size();
     str = (UChar*)string->c_str();
@@ -215,16 +443,24 @@ namespace rubinius {
     if(!RTEST(forward)) {
       beg = onig_search(onig_data, str, str + max, str + end->to_native(), str + start->to_native(), region, ONIG_OPTION_NONE);
     } else {
-      beg = onig_search(onig_data, str, str + max, str + start->to_native(), str + end->to_native(), region, ONIG_OPTION_NONE);
+      const UChar* from = str + start->to_native();
+      const UChar* range = str + end->to_native();
+      const std::string* prefix = pattern_prefix(onig_data);
+
+      /* Skip ahead to where the literal prefix occurs, or give up early. */
+      if(prefix && from >= str && from <= str + max) {
+        from = find_literal(from, str + max, *prefix);
+        if(!from || from > range) return Qnil;
+      }
+
+      beg = onig_search(onig_data, str, str + max, from, range, region, ONIG_OPTION_NONE);
     }
 
     if(beg == ONIG_MISMATCH) {
-      onig_region_free(region, 1);
       return Qnil;
     }
 
     md = get_match_data(state, region, string, this, max);
-    onig_region_free(region, 1);
     return md;
   }
 
@@ -234,7 +470,7 @@ namespace rubinius {
     OnigRegion *region;
     Object* md = Qnil;
 
-    region = onig_region_new();
+    region = shared_region();
 
     max = string->size();
     str = (UChar*)string->c_str();
@@ -246,7 +482,6 @@ namespace rubinius {
       md = get_match_data(state, region, string, this, max);
     }
 
-    onig_region_free(region, 1);
     return md;
   }
 }
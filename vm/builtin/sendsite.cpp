@@ -21,8 +21,10 @@ namespace rubinius {
         msg.method = msg.send_site->method();
 
         msg.send_site->hits++;
+        state->metrics.send_site_hits++;
       } else {
         msg.send_site->misses++;
+        state->metrics.send_site_misses++;
         return basic_performer(state, task, msg);
       }
 
@@ -39,8 +41,10 @@ namespace rubinius {
         msg.method = msg.send_site->method();
 
         msg.send_site->hits++;
+        state->metrics.send_site_hits++;
       } else {
         msg.send_site->misses++;
+        state->metrics.send_site_misses++;
         return basic_performer(state, task, msg);
       }
 
@@ -226,10 +230,12 @@ keep_looking:
         msg.module = entry->module;
         msg.method_missing = entry->method_missing;
 
+        state->metrics.global_cache_hits++;
         return true;
       }
     }
 
+    state->metrics.global_cache_misses++;
     if(HierarchyResolver::resolve(state, msg)) {
       state->global_cache->retain(state, msg.lookup_from, msg.name,
           msg.module, msg.method, msg.method_missing);
@@ -246,10 +252,12 @@ keep_looking:
       msg.method_missing = msg.send_site->method_missing;
 
       msg.send_site->hits++;
+      state->metrics.send_site_hits++;
       return true;
     }
 
     msg.send_site->misses++;
+    state->metrics.send_site_misses++;
     if(GlobalCacheResolver::resolve(state, msg)) {
       msg.send_site->module(state, msg.module);
       msg.send_site->method(state, msg.method);
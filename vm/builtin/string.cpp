@@ -8,6 +8,7 @@
 #include "builtin/integer.hpp"
 
 #include "parser/grammar.hpp"
+#include "native_thread.hpp"
 
 #include "vm.hpp"
 #include "vm/object_utils.hpp"
@@ -18,6 +19,7 @@
 
 #include <unistd.h>
 #include <iostream>
+#include <string>
 
 #define HashPrime 16777619
 #define MASK_28 (((unsigned int)1<<28)-1)
@@ -143,7 +145,13 @@ namespace rubinius {
     String* other = as<String>(b);
 
     if(self->num_bytes() != other->num_bytes()) return false;
-    if(strncmp(self->byte_address(), other->byte_address(), self->num_bytes()->to_native())) {
+
+    // Shared Strings (see string_dup) point at the same ByteArray.
+    if(self->data() == other->data()) return true;
+
+    // memcmp rather than strncmp so that embedded NUL bytes are compared
+    // and libc can use its vectorized implementation.
+    if(std::memcmp(self->byte_address(), other->byte_address(), self->size())) {
       return false;
     }
 
@@ -180,25 +188,37 @@ namespace rubinius {
     return append(state, other, std::strlen(other));
   }
 
+  /* Returns the smallest power of two that is at least +bytes+. Used to
+   * grow the ByteArray geometrically so that repeated appends are
+   * amortized O(1) instead of copying the whole String each time.
+   */
+  static size_t append_capacity(size_t bytes) {
+    size_t capacity = bytes - 1;
+
+    capacity |= capacity >> 1;
+    capacity |= capacity >> 2;
+    capacity |= capacity >> 4;
+    capacity |= capacity >> 8;
+    capacity |= capacity >> 16;
+#if __WORDSIZE == 64
+    capacity |= capacity >> 32;
+#endif
+
+    return capacity + 1;
+  }
+
   String* String::append(STATE, const char* other, std::size_t length) {
     size_t new_size = size() + length;
-    size_t capacity = data_->size();
-    
-    if(capacity <= (new_size + 1)) {      
-      // capacity needs one extra byte of room for the trailing null
-      while(capacity < (new_size + 1)) {
-        capacity = (capacity + 1) * 2;
-      }
-
-      // No need to call unshare and duplicate a ByteArray
-      // just to throw it away.
-      if(shared_) shared(state, Qfalse);
 
-      ByteArray *ba = ByteArray::create(state, capacity);
+    // capacity needs one extra byte of room for the trailing null.
+    // A shared ByteArray must be copied anyway, so grow it in the same
+    // step rather than duplicating it exactly and reallocating again
+    // on the next append.
+    if(data_->size() <= new_size || shared_->true_p()) {
+      ByteArray *ba = ByteArray::create(state, append_capacity(new_size + 1));
       std::memcpy(ba->bytes, data_->bytes, size());
       data(state, ba);
-    } else {
-      if(shared_) unshare(state);
+      shared(state, Qfalse);
     }
 
     // Append on top of the null byte at the end of s1, not after it
@@ -444,7 +464,10 @@ namespace rubinius {
     const char* str = c_str();
     int base = fix_base->to_native();
     bool negative = false;
-    Integer* value = Fixnum::from(0);
+    Integer* value;
+    native_int small = 0;
+    std::string digits;
+    static const char* radix_chars = "0123456789abcdefghijklmnopqrstuvwxyz";
 
     if(base < 0 || base == 1 || base > 36) return (Integer*)Qnil;
     // Strict mode can only be invoked from Ruby via Kernel#Integer()
@@ -567,6 +590,8 @@ namespace rubinius {
         chr -= ('A' - 10);
       } else if(chr >= 'a' && chr <= 'z') {
         chr -= ('a' - 10);
+      } else {
+        chr = 36;
       }
 
       // Bail if the current chr is greater or equal to the base,
@@ -579,19 +604,20 @@ namespace rubinius {
         }
       }
 
-      if(value != Fixnum::from(0)) {
-        if(Fixnum *fix = try_as<Fixnum>(value)) {
-          value = fix->mul(state, Fixnum::from(base));
-        } else {
-          value = as<Bignum>(value)->mul(state, Fixnum::from(base));
-        }
+      if(digits.empty() && small <= (FIXNUM_MAX - chr) / base) {
+        small = small * base + chr;
+        continue;
       }
 
-      if(Fixnum *fix = try_as<Fixnum>(value)) {
-        value = fix->add(state, Fixnum::from(chr));
-      } else {
-        value = as<Bignum>(value)->add(state, Fixnum::from(chr));
+      // Too big for a Fixnum. Collect the digits, starting with those
+      // seen so far, and convert them all at once at the end.
+      if(digits.empty()) {
+        for(native_int rest = small; rest > 0; rest /= base) {
+          digits.insert(digits.begin(), radix_chars[rest % base]);
+        }
       }
+
+      digits.push_back(radix_chars[(int)chr]);
     }
 
     // If we last saw an underscore and we're strict, bail.
@@ -600,6 +626,12 @@ namespace rubinius {
     }
 
 return_value:
+    if(digits.empty()) {
+      value = Fixnum::from(small);
+    } else {
+      value = Bignum::from_string(state, digits.c_str(), base);
+    }
+
     if(negative) {
       if(Fixnum* fix = try_as<Fixnum>(value)) {
         value = fix->neg(state);
@@ -618,7 +650,11 @@ return_value:
     return val;
   }
 
+  /* The parser keeps its state in globals, so VMs take turns. */
+  static native::Mutex parser_lock;
+
   Object* String::parse(STATE, String* name, Fixnum* line) {
+    native::LockGuard guard(parser_lock);
     bstring str = blk2bstr(byte_address(), size());
     return parser::syd_compile_string(state, name->c_str(), str, line->to_native());
   }
@@ -8,6 +8,7 @@
 #include <sstream>
 
 #include <unistd.h>
+#include <time.h>
 
 #include "vm/object_utils.hpp"
 #include "vm/vm.hpp"
@@ -16,6 +17,10 @@
 #include "objectmemory.hpp"
 #include "global_cache.hpp"
 #include "config.hpp"
+#include "sampler.hpp"
+#include "instruction_stats.hpp"
+#include "environment.hpp"
+#include "mailbox.hpp"
 
 #include "builtin/array.hpp"
 #include "builtin/exception.hpp"
@@ -33,6 +38,7 @@
 #include "builtin/float.hpp"
 
 #include "builtin/system.hpp"
+#include "builtin/channel.hpp"
 
 
 namespace rubinius {
@@ -172,9 +178,92 @@ namespace rubinius {
     return path;
   }
 
+  Object* System::vm_start_instruction_stats(STATE) {
+    delete state->instruction_stats;
+    state->instruction_stats = new InstructionStats();
+    return Qtrue;
+  }
+
+  Object* System::vm_stop_instruction_stats(STATE, String* path) {
+    InstructionStats* stats = state->instruction_stats;
+    if(!stats) return Primitives::failure();
+
+    state->instruction_stats = NULL;
+
+    std::ofstream stream(path->c_str());
+    stats->print_csv(stream);
+    delete stats;
+
+    return path;
+  }
+
+  Object* System::vm_metrics(STATE) {
+    return state->metrics.to_lookup_table(state);
+  }
+
+  Object* System::sampler_activate(STATE, Fixnum* hz) {
+    // SIGPROF only reaches the VM on the default loop.
+    if(!state->owns_default_loop) return Primitives::failure();
+
+    if(!state->sampler) state->sampler = new Sampler(state);
+
+    state->sampler->start(hz->to_native());
+    return Integer::from(state, clock());
+  }
+
+  Object* System::sampler_stop(STATE) {
+    Sampler* sampler = state->sampler;
+    if(!sampler) return Primitives::failure();
+
+    sampler->stop();
+    sampler->process_samples();
+
+    Array* ary = Array::create(state, 3);
+    ary->set(state, 0, sampler->results());
+    ary->set(state, 1, Integer::from(state, clock()));
+    ary->set(state, 2, Integer::from(state, sampler->gc_samples()));
+
+    return ary;
+  }
+
   Object* System::vm_write_error(STATE, String* str) {
     std::cerr << str->c_str() << std::endl;
     return Qnil;
   }
 
+  Object* System::machine_new(STATE, Array* args) {
+    std::vector<std::string> argv;
+
+    for(std::size_t i = 0; i < args->size(); i++) {
+      argv.push_back(as<String>(args->get(state, i))->c_str());
+    }
+
+    int id = Environment::spawn(argv);
+    if(id == 0) return Primitives::failure();
+
+    return Fixnum::from(id);
+  }
+
+  Object* System::machine_join(STATE, Fixnum* id, Channel* chan) {
+    size_t event = Environment::join(state, id->to_native(), new ChannelCallback(state, chan));
+    if(event == 0) return Primitives::failure();
+
+    return Fixnum::from(event);
+  }
+
+  Object* System::machine_send_message(STATE, Fixnum* id, Object* msg) {
+    if(!Mailbox::send(state, id->to_native(), msg)) return Primitives::failure();
+    return Qtrue;
+  }
+
+  Object* System::machine_get_message(STATE) {
+    Object* msg = state->mailbox->receive(state);
+    return msg ? msg : Qnil;
+  }
+
+  Object* System::machine_listen(STATE, Channel* chan) {
+    state->mailbox->listen(state, new ChannelCallback(state, chan));
+    return chan;
+  }
+
 }
@@ -10,6 +10,7 @@
 namespace rubinius {
 
   class Array;
+  class Channel;
   class Fixnum;
   class String;
 
@@ -128,12 +129,86 @@ namespace rubinius {
     // Ruby.primitive :vm_stop_profiler
     static Object*  vm_stop_profiler(STATE, String* path);
 
+    /**
+     *  Starts counting the instructions run by the interpreter.
+     */
+    // Ruby.primitive :vm_start_instruction_stats
+    static Object*  vm_start_instruction_stats(STATE);
+
+    /**
+     *  Stops counting instructions and writes the counts per
+     *  instruction, per pair of instructions and per method as
+     *  CSV to +path+.
+     */
+    // Ruby.primitive :vm_stop_instruction_stats
+    static Object*  vm_stop_instruction_stats(STATE, String* path);
+
+    /**
+     *  Returns the VM's counters and histograms, as a LookupTable
+     *  of subsystem name to a LookupTable of values.
+     */
+    // Ruby.primitive :vm_metrics
+    static Object*  vm_metrics(STATE);
+
+    /**
+     *  Starts the sampling profiler, taking +hz+ samples per
+     *  second of CPU time. Returns the current CPU clock. Fails
+     *  on a VM started by machine_new, which can't take signals.
+     */
+    // Ruby.primitive :sampler_activate
+    static Object*  sampler_activate(STATE, Fixnum* hz);
+
+    /**
+     *  Stops the sampling profiler.
+     *
+     *  Returns [stacks, clock, gc_samples], stacks being an Array
+     *  of [frames, count] and frames the method names from the
+     *  outermost call in.
+     */
+    // Ruby.primitive :sampler_stop
+    static Object*  sampler_stop(STATE);
+
     /**
      *  Writes String to standard error stream.
      */
     // Ruby.primitive :vm_write_error
     static Object*  vm_write_error(STATE, String* str);
 
+    /**
+     *  Starts a VM on a new native thread with +args+ as its
+     *  command line, the first being the program name. Returns
+     *  the new VM's id.
+     */
+    // Ruby.primitive :machine_new
+    static Object*  machine_new(STATE, Array* args);
+
+    /**
+     *  Sends true to +chan+ once the VM +id+ has exited. Returns
+     *  an event id for use with Scheduler.cancel.
+     */
+    // Ruby.primitive :machine_join
+    static Object*  machine_join(STATE, Fixnum* id, Channel* chan);
+
+    /**
+     *  Copies +msg+ to the mailbox of the VM +id+.
+     */
+    // Ruby.primitive :machine_send_message
+    static Object*  machine_send_message(STATE, Fixnum* id, Object* msg);
+
+    /**
+     *  Takes the oldest message out of this VM's mailbox, or
+     *  returns nil if there are none.
+     */
+    // Ruby.primitive :machine_get_message
+    static Object*  machine_get_message(STATE);
+
+    /**
+     *  Sends the messages in this VM's mailbox to +chan+ as they
+     *  arrive.
+     */
+    // Ruby.primitive :machine_listen
+    static Object*  machine_listen(STATE, Channel* chan);
+
 
   public:   /* Type info */
 
@@ -20,6 +20,8 @@
 
 #include "objectmemory.hpp"
 #include "profiler.hpp"
+#include "safepoint.hpp"
+#include "sampler.hpp"
 #include "message.hpp"
 
 #include <iostream>
@@ -542,6 +544,10 @@ namespace rubinius {
     if(profiler) {
       std::ofstream stream(results);
       profiler->print_results(state, stream);
+
+      std::ofstream callgrind((std::string(results) + ".callgrind").c_str());
+      profiler->print_callgrind(state, callgrind);
+
       delete profiler;
     }
 
@@ -557,6 +563,19 @@ namespace rubinius {
         // Should we inspect the other interrupts?
         if(state->interrupts.check) {
           state->interrupts.check = false;
+
+          state->safepoint->park();
+
+          if(state->interrupts.check_samples) {
+            state->interrupts.check_samples = false;
+            if(state->sampler) state->sampler->process_samples();
+          }
+
+          if(state->interrupts.dump_metrics) {
+            state->interrupts.dump_metrics = false;
+            state->metrics.print(state, std::cerr);
+          }
+
           return;
         }
 
@@ -1,67 +1,45 @@
 #include "builtin/thread.hpp"
-#include "builtin/tuple.hpp"
-#include "builtin/list.hpp"
 #include "builtin/class.hpp"
 #include "builtin/fixnum.hpp"
 #include "builtin/symbol.hpp"
 #include "builtin/task.hpp"
 #include "builtin/contexts.hpp"
 #include "builtin/channel.hpp"
+#include "builtin/float.hpp"
+#include "builtin/integer.hpp"
 
 #include "objectmemory.hpp"
 #include "message.hpp"
 
 #include "vm/object_utils.hpp"
 #include "vm.hpp"
+#include "run_queue.hpp"
+#include "native_thread.hpp"
 
 namespace rubinius {
 
   void Thread::init(STATE) {
-    Tuple* tup = Tuple::from(state, 3,
-                             List::create(state),
-                             List::create(state),
-                             List::create(state) );
-
-    GO(scheduled_threads).set(tup);
+    state->run_queue.init(state);
 
     GO(thread).set(state->new_class("Thread", G(object), Thread::fields));
     G(thread)->set_object_type(state, Thread::type);
-
-    G(thread)->set_const(state, "ScheduledThreads", tup);
   }
 
 
 /* Accessor implementation */
 
-  /** @todo   Should we queue thread? Probably unnecessary. --rue */
   void Thread::priority(STATE, Fixnum* new_priority) {
-    /* This gets somewhat ugly to avoid existing lists. */
     if(new_priority->to_native() < 0) {
       Exception::argument_error(state, "Thread priority must be non-negative!");
     }
 
-    Tuple* scheduled = state->globals.scheduled_threads.get();
-
-    std::size_t desired = new_priority->to_ulong();
-    std::size_t existing = scheduled->num_fields();
-
-    if(desired >= existing) {
-      Tuple* replacement = Tuple::create(state, (desired + 1));
-      replacement->copy_from(state, scheduled, Fixnum::from(0),
-			     Fixnum::from(scheduled->num_fields()),
-			     Fixnum::from(0));
-
-      for(std::size_t i = existing - 1; i <= desired; ++i) {
-        if(replacement->at(state, i)->nil_p()) {
-          replacement->put(state, i, List::create(state));
-        }
-      }
-
-      state->globals.scheduled_threads.set(replacement);
-      scheduled = replacement;
+    if(RunQueue::linked_p(this)) {
+      state->run_queue.remove(state, this);
+      priority_ = new_priority;
+      state->run_queue.push(state, this);
+    } else {
+      priority_ = new_priority;
     }
-
-    priority_ = new_priority;
   }
 
 
@@ -72,7 +50,11 @@ namespace rubinius {
 
     thr->alive(state, Qtrue);
     thr->channel(state, reinterpret_cast<Channel*>(Qnil));
+    thr->queue_next(state, reinterpret_cast<Thread*>(Qnil));
+    thr->queue_prev(state, reinterpret_cast<Thread*>(Qnil));
     thr->priority(state, Fixnum::from(2));
+    thr->quantum(state, Fixnum::from(state->config.quantum));
+    thr->cpu_time(state, Fixnum::from(0));
     thr->queued(state, Qfalse);
     thr->sleep(state, Qtrue);
 
@@ -146,6 +128,17 @@ namespace rubinius {
   }
 
 
+  Float* Thread::cpu_time_prim(STATE) {
+    long long usec = cpu_time()->to_long_long();
+
+    if(this == state->globals.current_thread.get()) {
+      usec += native::cpu_time_usec() - state->thread_cpu_mark;
+    }
+
+    return Float::create(state, usec / 1000000.0);
+  }
+
+
 /* Interface */
 
   void Thread::boot_task(STATE) {
@@ -11,6 +11,8 @@ namespace rubinius {
 
   class Channel;
   class Exception;
+  class Float;
+  class Integer;
   class Task;
 
 
@@ -25,7 +27,7 @@ namespace rubinius {
    */
   class Thread : public Object {
   public:
-    const static size_t fields = 6;
+    const static size_t fields = 10;
     const static object_type type = ThreadType;
 
     /** Register class with the VM. */
@@ -36,12 +38,16 @@ namespace rubinius {
 
     attr_accessor(alive, Object);
     attr_accessor(channel, Channel);
+    attr_accessor(cpu_time, Integer);   /* Microseconds, up to the last switch. */
     attr_reader(priority, Fixnum);      /* Yes, reader only. See below. */
     attr_accessor(queued, Object);
+    attr_accessor(queue_next, Thread);
+    attr_accessor(queue_prev, Thread);
+    attr_accessor(quantum, Fixnum);     /* Microseconds, see Configuration. */
     attr_accessor(sleep, Object);
     attr_accessor(task, Task);
 
-    /** Setting priority may need to enlarge ScheduledThreads. */
+    /** A queued Thread is moved to the run queue for its new priority. */
     void priority(STATE, Fixnum* new_priority);
 
 
@@ -104,6 +110,15 @@ namespace rubinius {
     // Ruby.primitive :thread_wakeup
     Thread* wakeup(STATE);
 
+    /**
+     *  The CPU time this Thread has used, in seconds.
+     *
+     *  Time is charged to a Thread when it's switched out, so for
+     *  the current Thread the time since then is added in.
+     */
+    // Ruby.primitive :thread_cpu_time
+    Float* cpu_time_prim(STATE);
+
 
   public:   /* Interface */
 
@@ -125,6 +140,10 @@ namespace rubinius {
     Object*   alive_;     // slot
     Object*   sleep_;     // slot
     Object*   queued_;    // slot
+    Thread*   queue_next_; // slot
+    Thread*   queue_prev_; // slot
+    Fixnum*   quantum_;   // slot
+    Integer*  cpu_time_;  // slot
 
 
   public:   /* TypeInfo */
@@ -347,6 +347,8 @@ void #{@name}::Info::auto_mark(Object* _t, ObjectMark& mark) {
       return "FIXNUM_P(#{what})"
     when "Symbol"
       return "SYMBOL_P(#{what})"
+    when "Float"
+      return "(FLONUM_P(#{what}) || (REFERENCE_P(#{what}) && #{what}->obj_type == FloatType))"
     when "TrueClass"
       return "#{what} == Qtrue"
     when "FalseClass"
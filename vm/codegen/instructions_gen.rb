@@ -335,6 +335,9 @@ CODE
     end
     str << "} instruction_names;\n"
 
+    total = InstructionSet::OpCodes.map { |ins| ins.bytecode }.max + 1
+    str << "const static size_t cTotalInstructions = #{total};\n"
+
     str
   end
 end
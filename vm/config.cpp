@@ -68,6 +68,14 @@ namespace rubinius {
     return i->second;
   }
 
+  long ConfigParser::number(std::string name, long fallback) {
+    ConfigParser::Entry* entry = find(name);
+
+    if(!entry || entry->value.empty() || !entry->is_number()) return fallback;
+
+    return strtol(entry->value.c_str(), NULL, 10);
+  }
+
   ConfigParser::~ConfigParser() {
     ConfigParser::ConfigMap::iterator i = variables.begin();
     while(i != variables.end()) {
@@ -1,3 +1,6 @@
+#ifndef RBX_CONFIG_HPP
+#define RBX_CONFIG_HPP
+
 #include <iostream>
 #include <sstream>
 #include <map>
@@ -25,6 +28,12 @@ namespace rubinius {
     Entry* parse_line(const char* line);
     void   import_stream(std::istream&);
     Entry* find(std::string variable);
+
+    /* The value of +variable+ as a number, or +fallback+ if it's unset
+     * or not a number. */
+    long   number(std::string variable, long fallback);
     EntryList* get_section(std::string prefix);
   };
 }
+
+#endif
@@ -25,4 +25,8 @@
 #define USE_EXECINFO
 #endif
 
+#if defined(__linux__)
+#define USE_SENDFILE
+#endif
+
 #endif
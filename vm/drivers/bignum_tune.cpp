@@ -0,0 +1,12 @@
+#include <iostream>
+
+#include "builtin/bignum.hpp"
+
+using namespace rubinius;
+
+/* Times the Bignum multiply crossovers on this machine and prints them as
+ * rbx.bignum.* settings, to be added to the config the VM boots with. */
+int main(int argc, char** argv) {
+  Bignum::calibrate_multiply(std::cout);
+  return 0;
+}
@@ -13,27 +13,6 @@
 using namespace std;
 using namespace rubinius;
 
-static void load_runtime_kernel(Environment& env, std::string root) {
-  std::string dirs = root + "/index";
-  std::ifstream stream(dirs.c_str());
-  if(!stream) {
-    std::cout << "It appears that " << root << "/index is missing.\n";
-    exit(1);
-  }
-
-  while(!stream.eof()) {
-    std::string line;
-
-    stream >> line;
-    stream.get(); // eat newline
-
-    // skip empty lines
-    if(line.size() == 0) continue;
-
-    env.load_directory(root + "/" + line);
-  }
-}
-
 int main(int argc, char** argv) {
   Environment env;
   env.load_argv(argc, argv);
@@ -54,11 +33,12 @@ int main(int argc, char** argv) {
 
     env.load_platform_conf(root);
 
-    load_runtime_kernel(env, std::string(root));
+    env.load_kernel(root);
 
     std::string loader = root + "/loader.rbc";
 
     env.enable_preemption();
+    env.enable_metrics_dump();
     env.run_file(loader);
     return 0;
 
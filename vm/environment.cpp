@@ -4,10 +4,14 @@
 #include "environment.hpp"
 #include "config.hpp" // HACK rename to config_parser.hpp
 #include "compiled_file.hpp"
+#include "mailbox.hpp"
+#include "native_thread.hpp"
+#include "virtual.hpp"
 
 #include "vm/exception.hpp"
 
 #include "builtin/array.hpp"
+#include "builtin/bignum.hpp"
 #include "builtin/class.hpp"
 #include "builtin/exception.hpp"
 #include "builtin/string.hpp"
@@ -18,13 +22,222 @@
 
 #include <iostream>
 #include <fstream>
+#include <list>
+#include <map>
 #include <sstream>
 #include <string>
+#include <signal.h>
 
 namespace rubinius {
 
-  Environment::Environment() {
-    state = new VM();
+  struct Machine {
+    pthread_t thread;
+    bool exited;
+    std::list<Environment::Joiner*> joiners;
+  };
+
+  // Guards everything below.
+  static native::Mutex machines_lock;
+
+  // Where the first VM loaded the kernel from, for the VMs started by
+  // spawn().
+  static std::string runtime_root;
+
+  static std::map<int, Machine> machines;
+
+  struct SpawnRequest {
+    int id;
+    Mailbox* mailbox;
+    std::string root;
+    std::vector<std::string> argv;
+  };
+
+  /* Tells whoever is joining the VM +id+ that it's done. */
+  static void machine_exited(int id) {
+    native::LockGuard guard(machines_lock);
+
+    std::map<int, Machine>::iterator found = machines.find(id);
+    if(found == machines.end()) return;
+
+    Machine& machine = found->second;
+    machine.exited = true;
+
+    for(std::list<Environment::Joiner*>::iterator i = machine.joiners.begin();
+        i != machine.joiners.end();
+        i++) {
+      ev_async_send((*i)->loop->base, &(*i)->ev);
+    }
+  }
+
+  static void* machine_main(void* arg) {
+    SpawnRequest* request = static_cast<SpawnRequest*>(arg);
+
+    // Signals are handled by the VM on the default loop.
+    sigset_t mask;
+    sigfillset(&mask);
+    pthread_sigmask(SIG_BLOCK, &mask, NULL);
+
+    Environment env(request->mailbox);
+
+    std::vector<char*> argv;
+    for(size_t i = 0; i < request->argv.size(); i++) {
+      argv.push_back(const_cast<char*>(request->argv[i].c_str()));
+    }
+    env.load_argv(argv.size(), &argv[0]);
+
+    try {
+      env.load_platform_conf(request->root);
+      env.load_kernel(request->root);
+      env.enable_preemption();
+      env.run_file(request->root + "/loader.rbc");
+    } catch(Assertion &e) {
+      std::cerr << "VM Assertion:" << std::endl;
+      std::cerr << "  " << e.reason << std::endl;
+      env.state->print_backtrace();
+    } catch(RubyException &e) {
+      e.show(env.state);
+    } catch(std::runtime_error& e) {
+      std::cerr << "Runtime exception: " << e.what() << std::endl;
+    } catch(...) {
+      std::cerr << "Unknown exception detected." << std::endl;
+    }
+
+    machine_exited(request->id);
+
+    delete request;
+    return NULL;
+  }
+
+  int Environment::spawn(const std::vector<std::string>& argv) {
+    if(argv.empty()) return 0;
+
+    native::LockGuard guard(machines_lock);
+
+    if(runtime_root.empty()) return 0;
+
+    SpawnRequest* request = new SpawnRequest;
+    request->mailbox = Mailbox::create();
+    request->id = request->mailbox->id();
+    request->root = runtime_root;
+    request->argv = argv;
+
+    int id = request->id;
+
+    pthread_t thread;
+    if(pthread_create(&thread, NULL, machine_main, request) != 0) {
+      Mailbox::destroy(request->mailbox);
+      delete request;
+      return 0;
+    }
+
+    Machine& machine = machines[id];
+    machine.thread = thread;
+    machine.exited = false;
+    return id;
+  }
+
+  static void joiner_tramp(EV_P_ struct ev_async* ev, int revents) {
+    Environment::Joiner* joiner = static_cast<Environment::Joiner*>(ev->data);
+
+    if(joiner->activated()) {
+      joiner->loop->remove_event(joiner);
+      delete joiner;
+    }
+  }
+
+  size_t Environment::join(STATE, int id, ObjectCallback* chan) {
+    {
+      native::LockGuard guard(machines_lock);
+
+      if(machines.find(id) == machines.end()) {
+        delete chan;
+        return 0;
+      }
+    }
+
+    Joiner* joiner = new Joiner(state, chan, id);
+    state->events->start(joiner);
+    return joiner->id;
+  }
+
+  Environment::Joiner::Joiner(STATE, ObjectCallback* chan, int machine) :
+    Event(state, chan), machine(machine), waiting(false)
+  {
+    ev_async_init(&ev, joiner_tramp);
+    ev.data = this;
+  }
+
+  Environment::Joiner::~Joiner() {
+    stop();
+    delete channel;
+  }
+
+  void Environment::Joiner::start() {
+    native::LockGuard guard(machines_lock);
+
+    ev_async_start(loop->base, &ev);
+
+    std::map<int, Machine>::iterator found = machines.find(machine);
+    if(found == machines.end() || found->second.exited) {
+      // Already gone, or joined by someone else in the meantime.
+      ev_async_send(loop->base, &ev);
+      return;
+    }
+
+    found->second.joiners.push_back(this);
+    waiting = true;
+  }
+
+  void Environment::Joiner::stop() {
+    native::LockGuard guard(machines_lock);
+
+    if(loop) ev_async_stop(loop->base, &ev);
+    if(!waiting) return;
+
+    std::map<int, Machine>::iterator found = machines.find(machine);
+    if(found != machines.end()) found->second.joiners.remove(this);
+    waiting = false;
+  }
+
+  bool Environment::Joiner::activated() {
+    pthread_t thread;
+    bool reap = false;
+
+    {
+      native::LockGuard guard(machines_lock);
+
+      std::map<int, Machine>::iterator found = machines.find(machine);
+      if(found != machines.end()) {
+        Machine& info = found->second;
+        if(!info.exited) return false;
+
+        // The first one to get here reaps the thread, the others are
+        // just told it's done.
+        thread = info.thread;
+        reap = true;
+
+        for(std::list<Joiner*>::iterator i = info.joiners.begin();
+            i != info.joiners.end();
+            i++) {
+          (*i)->waiting = false;
+          if(*i != this) ev_async_send((*i)->loop->base, &(*i)->ev);
+        }
+
+        machines.erase(found);
+      }
+
+      waiting = false;
+    }
+
+    // The thread has finished with the VM, so this doesn't wait long.
+    if(reap) pthread_join(thread, NULL);
+
+    channel->call(Qtrue);
+    return true;
+  }
+
+  Environment::Environment(Mailbox* mailbox) {
+    state = new VM(VM::default_bytes, mailbox);
     TaskProbe* probe = TaskProbe::create(state);
     state->probe.set(probe->parse_env(NULL) ? probe : (TaskProbe*)Qnil);
   }
@@ -37,6 +250,10 @@ namespace rubinius {
     state->setup_preemption();
   }
 
+  void Environment::enable_metrics_dump() {
+    metrics::Metrics::dump_on_signal(state, SIGUSR2);
+  }
+
   void Environment::load_argv(int argc, char** argv) {
     state->set_const("ARG0", String::create(state, argv[0]));
 
@@ -67,6 +284,32 @@ namespace rubinius {
     }
   }
 
+  void Environment::load_kernel(std::string root) {
+    std::string dirs = root + "/index";
+    std::ifstream stream(dirs.c_str());
+    if(!stream) {
+      std::string error = "It appears that " + dirs + " is missing";
+      throw std::runtime_error(error);
+    }
+
+    {
+      native::LockGuard guard(machines_lock);
+      if(runtime_root.empty()) runtime_root = root;
+    }
+
+    while(!stream.eof()) {
+      std::string line;
+
+      stream >> line;
+      stream.get(); // eat newline
+
+      // skip empty lines
+      if(line.size() == 0) continue;
+
+      load_directory(root + "/" + line);
+    }
+  }
+
   void Environment::load_platform_conf(std::string dir) {
     std::string path = dir + "/platform.conf";
     std::ifstream stream(path.c_str());
@@ -76,6 +319,9 @@ namespace rubinius {
     }
 
     state->user_config->import_stream(stream);
+
+    // Before any VM multiplies, the cutoffs are process wide.
+    Bignum::configure_multiply(state->user_config);
   }
 
   void Environment::run_file(std::string file) {
@@ -3,23 +3,69 @@
 
 #include <string>
 #include <stdexcept>
+#include <vector>
 
 #include "vm.hpp"
+#include "event.hpp"
 
 namespace rubinius {
 
+  class Mailbox;
+  class ObjectCallback;
+
   class Environment {
   public:
+    /**
+     *  Sends true to a channel once the VM started by spawn() it's
+     *  waiting on has exited. The exiting VM wakes the joiner's event
+     *  loop through an ev_async, so only the Thread that's joining
+     *  waits.
+     *
+     *  The Joiner deletes its channel callback when it goes.
+     */
+    class Joiner : public event::Event {
+    public:
+      struct ev_async ev;
+      int machine;
+
+      /** Whether it's on the list of the VM's joiners. */
+      bool waiting;
+
+      Joiner(STATE, ObjectCallback* chan, int machine);
+      virtual ~Joiner();
+      virtual void start();
+      virtual void stop();
+      virtual bool activated();
+    };
+
     VM* state;
 
-    Environment();
+    // The VM takes +mailbox+ if given one, see spawn().
+    Environment(Mailbox* mailbox = NULL);
     ~Environment();
 
+    // Starts a VM on a new native thread that boots from the same
+    // runtime as this process and runs the loader with +argv+. Returns
+    // the VM's id, or 0 if no kernel has been loaded to boot from.
+    static int spawn(const std::vector<std::string>& argv);
+
+    // Sends true to +chan+ once the VM +id+ started by spawn() has
+    // exited. Returns the id of the event doing it, or 0 if there's no
+    // such VM. Takes ownership of +chan+.
+    static size_t join(STATE, int id, ObjectCallback* chan);
+
     void load_argv(int argc, char** argv);
     void load_directory(std::string dir);
+
+    // Loads the directories listed in +root+/index.
+    void load_kernel(std::string root);
+
     void load_platform_conf(std::string dir);
     void run_file(std::string path);
     void enable_preemption();
+
+    // Print the VM metrics to stderr on SIGUSR2
+    void enable_metrics_dump();
   };
 
 }
@@ -25,6 +25,8 @@
 #include "builtin/integer.hpp"
 #include "builtin/fixnum.hpp"
 #include "builtin/io.hpp"
+#include "builtin/string.hpp"
+#include "builtin/bytearray.hpp"
 #include "builtin/thread.hpp"
 
 #include "event.hpp"
@@ -70,7 +72,8 @@ namespace rubinius {
       return false;
     }
 
-    Write::Write(STATE, ObjectCallback* chan, int fd) : IO(state, chan) {
+    Write::Write(STATE, ObjectCallback* chan, int ifd) : IO(state, chan) {
+      fd = ifd;
       ev_io_init(&ev, event::tramp<struct ev_io>, fd, EV_WRITE);
       ev.data = this;
     }
@@ -98,16 +101,26 @@ namespace rubinius {
       if(buffer->nil_p()) {
         ret = Integer::from(state, fd);
       } else {
-        /* the + 1 is for the null on the end */
-        size_t bytes_to_read = count + 1;
+        IOBuffer* iobuf = try_as<IOBuffer>(buffer.get());
+        String* str = NULL;
+
+        char* start;
+        size_t bytes_to_read = count;
+
+        /* Always leave room for the null on the end */
+        if(iobuf) {
+          start = iobuf->at_unused();
+          if(iobuf->left() <= bytes_to_read) bytes_to_read = iobuf->left() - 1;
+        } else {
+          str = as<String>(buffer.get());
+          if(str->shared()->true_p()) str->unshare(state);
 
-        if(buffer->left() < bytes_to_read) {
-          bytes_to_read = buffer->left() - 1;
+          start = str->byte_address();
+          if(str->data()->size() <= bytes_to_read) bytes_to_read = str->data()->size() - 1;
         }
 
-        char* start = buffer->at_unused();
         while(1) {
-          int i = read(fd, start, bytes_to_read);
+          ssize_t i = read(fd, start, bytes_to_read);
 
           /* EOF seen */
           if(i == 0) {
@@ -118,13 +131,22 @@ namespace rubinius {
             /* we were interrupted, how rude. go again. */
             if(errno == EINTR) continue;
 
+            /* someone else drained the fd first, keep waiting */
+            if(errno == EAGAIN || errno == EWOULDBLOCK) return false;
+
             /* not sure. Send a system error */
             ret = Tuple::from(state, 2, state->symbol("error"), Fixnum::from(errno));
           } else {
             /* clamp */
             start[i] = 0;
 
-            buffer->read_bytes(state, i);
+            if(iobuf) {
+              iobuf->read_bytes(state, i);
+            } else {
+              str->num_bytes(state, Fixnum::from(i));
+              str->characters(state, Fixnum::from(i));
+              str->hash_value(state, (Integer*)Qnil);
+            }
             ret = Fixnum::from(i);
           }
 
@@ -159,27 +181,238 @@ namespace rubinius {
     }
 
     Timer::Timer(STATE, ObjectCallback* chan, double seconds, Object* obj):
-      Event(state, chan), tag(obj), timer_(NULL)
-    {
-      timer_ = new struct ev_timer;
-      ev_timer_init(timer_, event::tramp<ev_timer>, (ev_tstamp)seconds, 0.);
-      timer_->data = this;
+      Event(state, chan), tag(state, obj), seconds(seconds),
+      owns_channel(false), deadline(0), next(NULL), prev(NULL) { }
+
+    Timer::~Timer() {
+      stop();
+      if(owns_channel) delete channel;
     }
 
     void Timer::start() {
-      ev_timer_start(loop->base, timer_);
+      loop->timers.add(this);
     }
 
     void Timer::stop() {
-      ev_timer_stop(loop->base, timer_);
-      delete timer_;
+      if(loop) loop->timers.remove(this);
     }
 
     bool Timer::activated() {
-      channel->call(tag);
+      channel->call(tag.get());
+      return true;
+    }
+
+
+/* TimerWheel */
+
+
+    const double TimerWheel::cResolution = 0.001;
+
+    static void wheel_tramp(EV_P_ struct ev_timer* ev, int revents) {
+      static_cast<TimerWheel*>(ev->data)->expire();
+    }
+
+    TimerWheel::TimerWheel(Loop* loop) :
+      loop_(loop), watcher_(NULL), current_(0), wakeup_(0)
+    {
+      for(size_t i = 0; i < cSlots; i++) {
+        slots_[i] = NULL;
+      }
+
+      watcher_ = new struct ev_timer;
+      ev_timer_init(watcher_, wheel_tramp, 0., 0.);
+      watcher_->data = this;
+    }
+
+    TimerWheel::~TimerWheel() {
+      clear();
+      delete watcher_;
+    }
+
+    uint64_t TimerWheel::now() {
+      return (uint64_t)(ev_now(loop_->base) / cResolution);
+    }
+
+    void TimerWheel::link(Timer* timer) {
+      Timer*& head = slots_[timer->deadline % cSlots];
+
+      if(!head) {
+        timer->next = timer->prev = timer;
+        head = timer;
+      } else {
+        timer->next = head;
+        timer->prev = head->prev;
+        head->prev->next = timer;
+        head->prev = timer;
+      }
+    }
+
+    void TimerWheel::unlink(Timer* timer) {
+      Timer*& head = slots_[timer->deadline % cSlots];
+
+      if(timer->next == timer) {
+        head = NULL;
+      } else {
+        timer->prev->next = timer->next;
+        timer->next->prev = timer->prev;
+        if(head == timer) head = timer->next;
+      }
+
+      timer->next = timer->prev = NULL;
+    }
+
+    void TimerWheel::add(Timer* timer) {
+      if(timer->next) return;
+
+      if(by_id_.empty()) current_ = now();
+
+      // Round up, a Timer must never fire early.
+      double due = (ev_now(loop_->base) + timer->seconds) / cResolution;
+      timer->deadline = (uint64_t)due;
+      if(timer->deadline < due) timer->deadline++;
+      if(timer->deadline <= current_) timer->deadline = current_ + 1;
+
+      link(timer);
+      by_id_[timer->id] = timer;
+
+      if(wakeup_ == 0 || timer->deadline < wakeup_) {
+        set_wakeup(timer->deadline);
+      }
+    }
+
+    /* The libev timer is left as is unless the wheel is now empty. At
+     * worst it wakes up to find nothing due. */
+    void TimerWheel::remove(Timer* timer) {
+      if(!timer->next) return;
+
+      unlink(timer);
+      by_id_.erase(timer->id);
+
+      if(by_id_.empty()) set_wakeup(0);
+    }
+
+    bool TimerWheel::cancel(size_t id) {
+      std::tr1::unordered_map<size_t, Timer*>::iterator it = by_id_.find(id);
+      if(it == by_id_.end()) return false;
+
+      Timer* timer = it->second;
+      remove(timer);
+      delete timer;
       return true;
     }
 
+    void TimerWheel::clear_by_channel(void* chan) {
+      std::vector<Timer*> found;
+
+      std::tr1::unordered_map<size_t, Timer*>::iterator it;
+      for(it = by_id_.begin(); it != by_id_.end(); it++) {
+        if(it->second->channel == chan) found.push_back(it->second);
+      }
+
+      for(std::vector<Timer*>::iterator i = found.begin(); i != found.end(); i++) {
+        remove(*i);
+        delete *i;
+      }
+    }
+
+    void TimerWheel::clear() {
+      while(!by_id_.empty()) {
+        Timer* timer = by_id_.begin()->second;
+        remove(timer);
+        delete timer;
+      }
+
+      set_wakeup(0);
+    }
+
+    void TimerWheel::expire() {
+      // libev may wake us a hair before the tick we asked for.
+      uint64_t tick = now();
+      if(tick < wakeup_) tick = wakeup_;
+      wakeup_ = 0;
+
+      std::vector<Timer*> due;
+
+      // The clock may have been set back.
+      uint64_t ticks = tick > current_ ? tick - current_ : 0;
+      if(ticks > cSlots) ticks = cSlots;
+
+      for(uint64_t i = 1; i <= ticks; i++) {
+        Timer* head = slots_[(current_ + i) % cSlots];
+        if(!head) continue;
+
+        Timer* timer = head;
+        do {
+          if(timer->deadline <= tick) due.push_back(timer);
+          timer = timer->next;
+        } while(timer != head);
+      }
+
+      if(tick > current_) current_ = tick;
+
+      // Unlink everything first, the callbacks may start or cancel
+      // other Timers.
+      for(std::vector<Timer*>::iterator i = due.begin(); i != due.end(); i++) {
+        unlink(*i);
+        by_id_.erase((*i)->id);
+      }
+
+      for(std::vector<Timer*>::iterator i = due.begin(); i != due.end(); i++) {
+        if((*i)->activated() && (*i)->tracked()) delete *i;
+      }
+
+      schedule();
+    }
+
+    /* Sets the libev timer for the earliest deadline. Slots are looked at
+     * in tick order for one turn of the wheel, which finds it unless
+     * every Timer is further off than that. */
+    void TimerWheel::schedule() {
+      if(by_id_.empty()) {
+        set_wakeup(0);
+        return;
+      }
+
+      uint64_t earliest = 0;
+
+      for(uint64_t tick = current_ + 1; tick <= current_ + cSlots; tick++) {
+        Timer* head = slots_[tick % cSlots];
+        if(!head) continue;
+
+        Timer* timer = head;
+        do {
+          if(timer->deadline == tick) {
+            set_wakeup(tick);
+            return;
+          }
+
+          if(earliest == 0 || timer->deadline < earliest) {
+            earliest = timer->deadline;
+          }
+
+          timer = timer->next;
+        } while(timer != head);
+      }
+
+      set_wakeup(earliest);
+    }
+
+    /* Passing 0 stops the libev timer. */
+    void TimerWheel::set_wakeup(uint64_t tick) {
+      if(wakeup_ != 0 || ev_is_active(watcher_)) {
+        ev_timer_stop(loop_->base, watcher_);
+      }
+
+      wakeup_ = tick;
+      if(tick == 0) return;
+
+      ev_tstamp delay = tick * cResolution - ev_now(loop_->base);
+      if(delay < 0.) delay = 0.;
+
+      ev_timer_set(watcher_, delay, 0.);
+      ev_timer_start(loop_->base, watcher_);
+    }
+
 
 /* SIGCHLD */
 
@@ -269,9 +502,11 @@ namespace rubinius {
 
     /** @todo Fix the options. --rue */
     Loop::Loop(struct ev_loop *loop) :
-      base(loop), event_ids(0), options_(0), owner(false) { }
+      timers(this), base(loop), event_ids(0), options_(0), owner(false) { }
 
-    Loop::Loop(int opts) : event_ids(0), options_(opts), owner(false) {
+    Loop::Loop(int opts) :
+      timers(this), event_ids(0), options_(opts), owner(false)
+    {
       base = ev_default_loop(options_);
 
       /* @todo Should fail here if default returns NULL */
@@ -284,6 +519,9 @@ namespace rubinius {
       ev->id = ++event_ids;
       ev->start();
 
+      // Timers are kept by +timers+ instead.
+      if(dynamic_cast<Timer*>(ev)) return;
+
       // It's important this is last. Signal::start removes older Signal
       // events by looking through +events+ on start. We don't want it
       // to remove itself, so we do this after the event has actually
@@ -299,6 +537,8 @@ namespace rubinius {
           delete *it;
         }
 
+        timers.clear();
+
         if(base != ev_default_loop(0)) {
           ev_loop_destroy(base);
         }
@@ -306,7 +546,7 @@ namespace rubinius {
     }
 
     size_t Loop::num_of_events() {
-      return events.size();
+      return events.size() + timers.size();
     }
 
     size_t Loop::loop_count() {
@@ -334,6 +574,8 @@ namespace rubinius {
     }
 
     void Loop::clear_by_channel(void* chan) {
+      timers.clear_by_channel(chan);
+
       std::vector<Event*>::iterator it;
       for(it = events.begin(); it != events.end();) {
         if((*it)->channel == chan) {
@@ -346,6 +588,8 @@ namespace rubinius {
     }
 
     void Loop::clear_by_id(size_t id) {
+      if(timers.cancel(id)) return;
+
       std::vector<Event*>::iterator it;
       for(it = events.begin(); it != events.end();) {
         if((*it)->id == id) {
@@ -2,6 +2,7 @@
 #define RBX_EVENT_HPP
 
 #include <list>
+#include <tr1/unordered_map>
 
 #include <sys/wait.h>
 #include <sys/signal.h>
@@ -26,7 +27,7 @@ namespace rubinius {
       STATE;
       ObjectCallback* channel;
       size_t id;
-      TypedRoot<IOBuffer*> buffer;
+      TypedRoot<Object*> buffer;
       Loop* loop;
 
       Event(STATE, ObjectCallback* chan);
@@ -59,6 +60,12 @@ namespace rubinius {
       virtual bool activated();
     };
 
+    /**
+     *  Waits for the fd to become readable. If given a buffer, which
+     *  may be an IOBuffer or a String, up to count bytes are read
+     *  directly into its storage and the byte count is sent to the
+     *  channel; otherwise the fd itself is sent.
+     */
     class Read : public IO {
     public:
       size_t count;
@@ -82,26 +89,98 @@ namespace rubinius {
     };
 
     /**
-     *  @note   Unlike other Events, we use a dynamically allocated
-     *          ev_timer here because some evil shit libev does makes
-     *          the compiler think there may be something wrong with
-     *          ev_timer_init. I could not be bothered to figure out
-     *          whether the warning was for cause. And no, casting
-     *          does not work because it would potentially create a
-     *          temporary. --rue
+     *  Sends +tag+ to the channel after +seconds+.
+     *
+     *  Timers aren't registered with libev one by one. Starting one puts
+     *  it into its Loop's TimerWheel, which is woken by a single libev
+     *  timer.
      */
     class Timer : public Event {
     public:
-      Object* tag;
-      struct ev_timer* timer_;
+      TypedRoot<Object*> tag;
+      double seconds;
+
+      /** Whether the channel is deleted along with the Timer. */
+      bool owns_channel;
+
+      /* Maintained by the TimerWheel. */
+      uint64_t deadline;
+      Timer* next;
+      Timer* prev;
 
       Timer(STATE, ObjectCallback* chan, double seconds, Object* obj = Qnil);
-      virtual ~Timer() { stop(); }
+      virtual ~Timer();
       virtual void start();
       virtual void stop();
       virtual bool activated();
     };
 
+    /**
+     *  A hashed timing wheel holding the Timers of a Loop.
+     *
+     *  Time is cut into ticks of cResolution seconds. A Timer is linked
+     *  into the slot for the tick it's due on, modulo cSlots, so arming
+     *  and cancelling a Timer take constant time however many there are.
+     *  Only the one libev timer is registered, set for the earliest tick
+     *  known to have a Timer. When it fires, the slots for the ticks that
+     *  have passed are swept and the next non-empty slot is looked up.
+     *
+     *  @note   The libev timer is allocated dynamically for the reason
+     *          given by rue for Timer before: ev_timer_init upsets the
+     *          compiler when used on a member.
+     */
+    class TimerWheel {
+    public:
+      static const size_t cSlots = 512;
+      static const double cResolution;
+
+    private:
+      Loop* loop_;
+      Timer* slots_[cSlots];
+      std::tr1::unordered_map<size_t, Timer*> by_id_;
+      struct ev_timer* watcher_;
+
+      /** The last tick swept. */
+      uint64_t current_;
+
+      /** The tick the libev timer is set for, 0 if it isn't running. */
+      uint64_t wakeup_;
+
+    public:
+      TimerWheel(Loop* loop);
+
+      /** Deletes the Timers still waiting. */
+      ~TimerWheel();
+
+      void add(Timer* timer);
+      void remove(Timer* timer);
+
+      /** Removes and deletes the Timer with +id+, if it's here. */
+      bool cancel(size_t id);
+
+      /** Removes and deletes the Timers for +chan+. */
+      void clear_by_channel(void* chan);
+
+      /** Removes and deletes every Timer. */
+      void clear();
+
+      /** Fires the Timers that are due. Called by the libev timer. */
+      void expire();
+
+      size_t size() {
+        return by_id_.size();
+      }
+
+      /** The current time in ticks, per the Loop. */
+      uint64_t now();
+
+    private:
+      void link(Timer* timer);
+      void unlink(Timer* timer);
+      void set_wakeup(uint64_t tick);
+      void schedule();
+    };
+
     /**
      *  Slightly different, since these events are not
      *  tracked discretely by libev. Instead, we abstract
@@ -227,6 +306,7 @@ namespace rubinius {
 
     public:   /* Instance vars */
 
+      TimerWheel          timers;
       struct ev_loop*     base;
       std::vector<Event*> events;
       size_t              event_ids;
@@ -18,6 +18,9 @@ namespace rubinius {
   {
     current = &heap_a;
     next = &heap_b;
+
+    buffer_bytes_ = bytes / 8;
+    if(buffer_bytes_ > cBufferBytes) buffer_bytes_ = cBufferBytes;
   }
 
   BakerGC::~BakerGC() { }
@@ -68,11 +71,46 @@ namespace rubinius {
     return next->fully_scanned_p();
   }
 
+  /* Retires the current buffer and carves a new one, of at least +bytes+,
+   * off the young heap. Returns false if the heap can't fit +bytes+. */
+  bool BakerGC::refill_buffer(size_t bytes) {
+    retire_buffer();
+
+    size_t take = buffer_bytes_ < bytes ? bytes : buffer_bytes_;
+    size_t left = current->remaining();
+
+    if(left < take) {
+      // Use up the end of the heap, as long as the tail stays fillable.
+      if(left != bytes && left < bytes + sizeof(ObjectHeader)) return false;
+      take = left;
+    }
+
+    buffer.current = current->allocate(take);
+    buffer.limit = current->current;
+    return true;
+  }
+
+  /* Gives up the rest of the buffer, covering it with a header sized to
+   * fit so the heap can still be walked object by object. */
+  void BakerGC::retire_buffer() {
+    size_t left = buffer.remaining();
+
+    if(left > 0) {
+      Object* filler = (Object*)buffer.current;
+      filler->init_header(YoungObjectZone,
+          (left - sizeof(ObjectHeader)) / SIZE_OF_OBJECT);
+    }
+
+    buffer.current = buffer.limit = 0;
+  }
+
   /* Perform garbage collection on the young objects. */
   void BakerGC::collect(Roots &roots) {
     Object* tmp;
     ObjectArray *current_rs = object_memory->remember_set;
 
+    retire_buffer();
+
     object_memory->remember_set = new ObjectArray(0);
     total_objects = 0;
 
@@ -172,6 +210,8 @@ namespace rubinius {
   }
 
   void BakerGC::clear_marks() {
+    retire_buffer();
+
     Object* obj = current->first_object();
     while(obj < current->current) {
       obj->clear_mark();
@@ -186,6 +226,8 @@ namespace rubinius {
   }
 
   void BakerGC::free_objects() {
+    retire_buffer();
+
     Object* obj = current->first_object();
     while(obj < current->current) {
       delete_object(obj);
@@ -200,12 +242,33 @@ namespace rubinius {
     }
   }
 
+  void BakerGC::track_cleanup(Object* obj) {
+    requires_cleanup_.push_back(obj);
+  }
+
+  /* Runs cleanup for the tracked objects that didn't survive. Survivors
+   * still in the young generation are tracked at their new address;
+   * promoted ones are the mature collector's problem now. */
   void BakerGC::find_lost_souls() {
-    Object* obj = current->first_object();
-    while(obj < current->current) {
-      if(!obj->forwarded_p()) delete_object(obj);
-      obj = next_object(obj);
+    ObjectArray survivors;
+
+    for(ObjectArray::iterator i = requires_cleanup_.begin();
+        i != requires_cleanup_.end();
+        i++) {
+      Object* obj = *i;
+
+      if(!obj->forwarded_p()) {
+        delete_object(obj);
+        continue;
+      }
+
+      Object* copy = obj->forward();
+      if(copy->young_object_p() && copy->RequiresCleanup) {
+        survivors.push_back(copy);
+      }
     }
+
+    requires_cleanup_.swap(survivors);
   }
 
   // HACK todo test this!
@@ -15,6 +15,25 @@ namespace rubinius {
 
   class ObjectMemory;
 
+  /**
+   *  A stretch of the young heap set aside for bump allocation.
+   *
+   *  Most allocations come through ObjectMemory::new_object and are small,
+   *  so rather than checking the heap for every one, BakerGC hands out a
+   *  buffer at a time and objects are carved off the front of it. Only
+   *  when a buffer runs out is the heap consulted again.
+   */
+  struct AllocationBuffer {
+    address current;
+    address limit;
+
+    AllocationBuffer() : current(0), limit(0) { }
+
+    size_t remaining() {
+      return (uintptr_t)limit - (uintptr_t)current;
+    }
+  };
+
   class BakerGC : public GarbageCollector {
     public:
 
@@ -25,6 +44,13 @@ namespace rubinius {
     Heap *next;
     size_t lifetime;
     size_t total_objects;
+    AllocationBuffer buffer;
+
+    /* The most taken from the heap for a buffer at once. */
+    static const size_t cBufferBytes = 8192;
+
+    /* Objects bigger than this don't go through the buffer. */
+    static const size_t cMaxBufferedBytes = 512;
 
     /* Inline methods */
     Object* allocate(size_t fields, bool *collect_now) {
@@ -51,9 +77,41 @@ namespace rubinius {
       return obj;
     }
 
+    /* Allocates out of +buffer+, refilling it from the heap when it runs
+     * out. Returns NULL for large objects and when the heap is full, and
+     * the caller falls back on allocate(). The fields are not cleared.
+     *
+     * What's left of a buffer is always either nothing or room for at
+     * least a header, so retire_buffer() can fill it in. */
+    Object* local_allocate(size_t fields) {
+      size_t bytes = SIZE_IN_BYTES_FIELDS(fields);
+      size_t left = buffer.remaining();
+
+      if(left != bytes && left < bytes + sizeof(ObjectHeader)) {
+        if(bytes > cMaxBufferedBytes || !refill_buffer(bytes)) return NULL;
+      }
+
+      Object* obj = (Object*)buffer.current;
+      buffer.current = (address)((uintptr_t)buffer.current + bytes);
+
+      total_objects++;
+      obj->init_header(YoungObjectZone, fields);
+      return obj;
+    }
+
   private:
     ObjectArray* promoted_;
 
+    /* Young objects with RequiresCleanup set. After a collection only
+     * these are checked for death, rather than the whole heap. */
+    ObjectArray requires_cleanup_;
+
+    /* How much a new buffer takes from the heap, a small part of it so
+     * the last buffers before a collection don't leave much unused. */
+    size_t buffer_bytes_;
+
+    bool    refill_buffer(size_t bytes);
+
   public:
     /* Prototypes */
     BakerGC(ObjectMemory *om, size_t size);
@@ -66,7 +124,9 @@ namespace rubinius {
     void    clear_marks();
     Object*  next_object(Object* obj);
     void    find_lost_souls();
+    void    track_cleanup(Object* obj);
     void    clean_weakrefs();
+    void    retire_buffer();
 
     ObjectPosition validate_object(Object* obj);
   };
@@ -0,0 +1,107 @@
+#include "vm/instruction_stats.hpp"
+
+#include "vm/object_utils.hpp"
+#include "vm/vm.hpp"
+#include "vmmethod.hpp"
+
+#include "builtin/compiledmethod.hpp"
+#include "builtin/module.hpp"
+#include "builtin/staticscope.hpp"
+#include "builtin/symbol.hpp"
+
+#include <sstream>
+
+namespace rubinius {
+
+  static uint64_t next_stats_id = 1;
+
+  InstructionStats::InstructionStats()
+    : id_(next_stats_id++)
+    , pairs_(cTotal * cTotal, 0)
+  {
+    for(size_t i = 0; i < cTotal; i++) {
+      counts_[i] = 0;
+    }
+  }
+
+  size_t InstructionStats::method_index(STATE, VMMethod* vmm) {
+    if(vmm->instruction_stats_id == id_) return vmm->instruction_stats_index;
+
+    CompiledMethod* cm = vmm->original.get();
+    Method meth;
+
+    meth.name = "";
+    if(StaticScope* scope = try_as<StaticScope>(cm->scope())) {
+      if(Symbol* mod = try_as<Symbol>(scope->module()->name())) {
+        meth.name = std::string(mod->c_str(state)) + "#";
+      }
+    }
+
+    if(Symbol* name = try_as<Symbol>(cm->name())) {
+      meth.name += name->c_str(state);
+    } else {
+      meth.name += "<unknown>";
+    }
+
+    if(Symbol* file = try_as<Symbol>(cm->file())) {
+      meth.file = file->c_str(state);
+    }
+
+    meth.line = cm->start_line(state);
+    meth.count = 0;
+
+    methods_.push_back(meth);
+
+    vmm->instruction_stats_id = id_;
+    vmm->instruction_stats_index = methods_.size() - 1;
+    return vmm->instruction_stats_index;
+  }
+
+  static const char* instruction_name(size_t op) {
+    // Skip the op_ prefix.
+    return InstructionSequence::get_instruction_name(op) + 3;
+  }
+
+  static std::string csv_field(const std::string& str) {
+    if(str.find_first_of(",\"\n") == std::string::npos) return str;
+
+    std::string quoted = "\"";
+    for(size_t i = 0; i < str.size(); i++) {
+      if(str[i] == '"') quoted += '"';
+      quoted += str[i];
+    }
+
+    return quoted + "\"";
+  }
+
+  void InstructionStats::print_csv(std::ostream& stream) {
+    stream << "kind,name,detail,count\n";
+
+    for(size_t op = 0; op < cTotal; op++) {
+      if(counts_[op] == 0) continue;
+      stream << "instruction," << instruction_name(op) << ",," << counts_[op] << "\n";
+    }
+
+    for(size_t first = 0; first < cTotal; first++) {
+      for(size_t second = 0; second < cTotal; second++) {
+        uint64_t count = pair_count(first, second);
+        if(count == 0) continue;
+
+        stream << "pair," << instruction_name(first) << ","
+               << instruction_name(second) << "," << count << "\n";
+      }
+    }
+
+    for(std::vector<Method>::iterator i = methods_.begin();
+        i != methods_.end();
+        i++) {
+      if(i->count == 0) continue;
+
+      std::ostringstream position;
+      position << i->file << ":" << i->line;
+
+      stream << "method," << csv_field(i->name) << ","
+             << csv_field(position.str()) << "," << i->count << "\n";
+    }
+  }
+}
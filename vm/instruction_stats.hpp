@@ -0,0 +1,91 @@
+#ifndef RBX_INSTRUCTION_STATS_HPP
+#define RBX_INSTRUCTION_STATS_HPP
+
+#include <stdint.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "builtin/iseq.hpp"
+
+namespace rubinius {
+  class VM;
+  class VMMethod;
+
+  /**
+   *  Counts of the instructions run by the interpreter, collected while
+   *  VM::instruction_stats is set: how often each instruction ran, how
+   *  often each pair of instructions ran one after the other in the same
+   *  method, and how many instructions each method ran.
+   *
+   *  Everything is kept in flat arrays indexed by opcode, so counting an
+   *  instruction is three increments. Methods are numbered when first
+   *  seen, the number being cached on the VMMethod.
+   */
+  class InstructionStats {
+  public:
+    static const size_t cTotal = InstructionSequence::cTotalInstructions;
+
+    /* Passed as the previous instruction for the first one run by a
+     * resume, which doesn't make a pair with the one before it. */
+    static const size_t cNoPrevious = cTotal;
+
+    struct Method {
+      std::string name;
+      std::string file;
+      int line;
+      uint64_t count;
+    };
+
+  private:
+    uint64_t id_;
+    uint64_t counts_[cTotal];
+    std::vector<uint64_t> pairs_;
+    std::vector<Method> methods_;
+
+  public:
+    InstructionStats();
+
+    uint64_t id() {
+      return id_;
+    }
+
+    /* Counts +op+, run by +method+ right after +previous+. */
+    void record(size_t previous, size_t op, size_t method) {
+      counts_[op]++;
+      if(previous != cNoPrevious) pairs_[previous * cTotal + op]++;
+      methods_[method].count++;
+    }
+
+    /* The number +vmm+ is counted under. */
+    size_t method_index(VM* state, VMMethod* vmm);
+
+    uint64_t count(size_t op) {
+      return counts_[op];
+    }
+
+    /* The number of times +second+ ran right after +first+. */
+    uint64_t pair_count(size_t first, size_t second) {
+      return pairs_[first * cTotal + second];
+    }
+
+    Method& method(size_t index) {
+      return methods_[index];
+    }
+
+    size_t number_of_methods() {
+      return methods_.size();
+    }
+
+    /* Writes the non-zero counts as CSV rows of kind,name,detail,count:
+     *
+     *   instruction,push_nil,,120
+     *   pair,push_nil,send_stack,45
+     *   method,Foo#bar,foo.rb:12,300
+     */
+    void print_csv(std::ostream& stream);
+  };
+}
+
+#endif
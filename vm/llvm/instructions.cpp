@@ -21,6 +21,7 @@
 
 #include "objectmemory.hpp"
 #include "message.hpp"
+#include "instruction_stats.hpp"
 
 #define USE_JUMP_TABLE
 
@@ -161,6 +162,11 @@ CODE
 #define RETURN(val) if((val) == cExecuteRestart) { return; } else { continue; }
 
 void VMMethod::resume(Task* task, MethodContext* ctx) {
+  if(unlikely(state->instruction_stats)) {
+    resume_counting(task, ctx);
+    return;
+  }
+
   VMMethod* const vmm = this;
   opcode* stream = ctx->vmm->opcodes;
 #ifdef USE_JUMP_TABLE
@@ -199,3 +205,48 @@ CODE
   }
 #endif // USE_JUMP_TABLE
 }
+
+/* Kept apart from resume so that the jump table version pays a single
+ * check per resume, rather than one per instruction, when not counting.
+ *
+ * A primitive run by an instruction can stop or restart the counting,
+ * freeing +stats+, so the VM's stats are checked before each instruction.
+ * If they've gone or been replaced, this returns and the next resume
+ * picks the right loop. The id tells a new InstructionStats apart from
+ * the old one should it land at the same address.
+ *
+ * Pairs are only counted within a resume. Sends, returns and Thread
+ * switches all leave it, so the instruction after one of those isn't
+ * paired with one from another method. */
+void VMMethod::resume_counting(Task* task, MethodContext* ctx) {
+  VMMethod* const vmm = this;
+  opcode* stream = ctx->vmm->opcodes;
+  InstructionStats* stats = state->instruction_stats;
+  uint64_t stats_id = stats->id();
+  size_t method = stats->method_index(state, ctx->vmm);
+  size_t previous = InstructionStats::cNoPrevious;
+  opcode op;
+
+#undef RETURN
+#define RETURN(val) if((val) == cExecuteRestart) { return; } else { \
+  if(unlikely(state->interrupts.check)) return; \
+  continue; \
+}
+
+  for(;;) {
+    InstructionStats* current = state->instruction_stats;
+    if(unlikely(current != stats || current->id() != stats_id)) return;
+
+    op = stream[ctx->ip++];
+    stats->record(previous, op, method);
+    previous = op;
+
+#ruby <<CODE
+io = StringIO.new
+si.generate_decoder_switch impl, io, true
+puts io.string
+CODE
+
+    if(unlikely(state->interrupts.check)) return;
+  }
+}
@@ -0,0 +1,129 @@
+#include "vm/mailbox.hpp"
+
+#include "vm.hpp"
+#include "marshal.hpp"
+#include "native_thread.hpp"
+#include "virtual.hpp"
+
+#include <map>
+#include <sstream>
+
+namespace rubinius {
+
+  static native::Mutex lock;
+  static std::map<int, Mailbox*> mailboxes;
+  static int next_id = 1;
+
+  static void listener_tramp(EV_P_ struct ev_async* ev, int revents) {
+    static_cast<Mailbox::Listener*>(ev->data)->activated();
+  }
+
+  Mailbox::Listener::Listener(STATE, ObjectCallback* chan, Mailbox* mailbox) :
+    Event(state, chan), mailbox(mailbox)
+  {
+    ev_async_init(&ev, listener_tramp);
+    ev.data = this;
+  }
+
+  Mailbox::Listener::~Listener() {
+    stop();
+    delete channel;
+  }
+
+  void Mailbox::Listener::start() {
+    native::LockGuard guard(lock);
+
+    ev_async_start(loop->base, &ev);
+    if(!mailbox) return;
+
+    mailbox->listener_ = this;
+
+    // Deliver what came in before anyone was listening.
+    if(!mailbox->messages_.empty()) ev_async_send(loop->base, &ev);
+  }
+
+  void Mailbox::Listener::stop() {
+    native::LockGuard guard(lock);
+
+    if(loop) ev_async_stop(loop->base, &ev);
+    if(mailbox && mailbox->listener_ == this) mailbox->listener_ = NULL;
+  }
+
+  bool Mailbox::Listener::activated() {
+    if(!mailbox) return false;
+
+    while(Object* msg = mailbox->receive(state)) {
+      channel->call(msg);
+    }
+
+    return false;
+  }
+
+  Mailbox::Mailbox(int id) : id_(id), listener_(NULL) { }
+
+  Mailbox* Mailbox::create() {
+    native::LockGuard guard(lock);
+
+    Mailbox* mailbox = new Mailbox(next_id++);
+    mailboxes[mailbox->id_] = mailbox;
+    return mailbox;
+  }
+
+  void Mailbox::destroy(Mailbox* mailbox) {
+    {
+      native::LockGuard guard(lock);
+
+      mailboxes.erase(mailbox->id_);
+      if(mailbox->listener_) mailbox->listener_->mailbox = NULL;
+    }
+
+    delete mailbox;
+  }
+
+  bool Mailbox::send(STATE, int id, Object* msg) {
+    // Marshal before taking the lock, it may raise.
+    std::ostringstream stream;
+    Marshaller marshaller(state, stream);
+    marshaller.marshal(msg);
+
+    native::LockGuard guard(lock);
+
+    std::map<int, Mailbox*>::iterator found = mailboxes.find(id);
+    if(found == mailboxes.end()) return false;
+
+    Mailbox* mailbox = found->second;
+    mailbox->messages_.push_back(stream.str());
+
+    if(Listener* listener = mailbox->listener_) {
+      ev_async_send(listener->loop->base, &listener->ev);
+    }
+
+    return true;
+  }
+
+  Object* Mailbox::receive(STATE) {
+    std::string message;
+
+    {
+      native::LockGuard guard(lock);
+
+      if(messages_.empty()) return NULL;
+      message = messages_.front();
+      messages_.pop_front();
+    }
+
+    std::istringstream stream(message);
+    UnMarshaller unmarshaller(state, stream);
+    return unmarshaller.unmarshal();
+  }
+
+  size_t Mailbox::size() {
+    native::LockGuard guard(lock);
+    return messages_.size();
+  }
+
+  void Mailbox::listen(STATE, ObjectCallback* chan) {
+    if(listener_) state->events->clear_by_id(listener_->id);
+    state->events->start(new Listener(state, chan, this));
+  }
+}
@@ -0,0 +1,83 @@
+#ifndef RBX_MAILBOX_HPP
+#define RBX_MAILBOX_HPP
+
+#include <list>
+#include <string>
+
+#include "prelude.hpp"
+#include "event.hpp"
+
+namespace rubinius {
+  class Object;
+  class ObjectCallback;
+
+  /**
+   *  The messages sent to a VM by the other VMs in the process.
+   *
+   *  VMs share no objects, so a message is marshalled into a string on
+   *  the sending VM and unmarshalled into the receiver's heap when it is
+   *  taken out. Only what Marshaller understands can be sent: nil, true,
+   *  false, numbers, Strings, Symbols and Arrays and Tuples of those.
+   *
+   *  Mailboxes are numbered from 1 and found by number through a table
+   *  shared by the whole process. One lock guards the table and the
+   *  messages in every Mailbox.
+   */
+  class Mailbox {
+  public:
+    /**
+     *  Sends the messages to a channel as they arrive. The sending VM
+     *  wakes the receiver's event loop through an ev_async, which is the
+     *  one libev watcher that may be poked from another native thread.
+     *
+     *  The Listener deletes its channel callback when it goes.
+     */
+    class Listener : public event::Event {
+    public:
+      struct ev_async ev;
+      Mailbox* mailbox;
+
+      Listener(STATE, ObjectCallback* chan, Mailbox* mailbox);
+      virtual ~Listener();
+      virtual void start();
+      virtual void stop();
+      virtual bool activated();
+    };
+
+  private:
+    int id_;
+    std::list<std::string> messages_;
+    Listener* listener_;
+
+    Mailbox(int id);
+
+  public:
+    /** A new, empty Mailbox, with the next free number. */
+    static Mailbox* create();
+
+    /** Unregisters +mailbox+ and deletes it with any messages left. */
+    static void destroy(Mailbox* mailbox);
+
+    /**
+     *  Marshals +msg+ into the Mailbox numbered +id+. Returns false if
+     *  there's no such Mailbox. Raises TypeError if +msg+ can't be sent.
+     */
+    static bool send(STATE, int id, Object* msg);
+
+    int id() {
+      return id_;
+    }
+
+    /** Takes out the oldest message, or returns NULL if there are none. */
+    Object* receive(STATE);
+
+    /** The number of messages waiting. */
+    size_t size();
+
+    /** Sends the messages to +chan+ from now on, in place of any earlier
+     * channel. */
+    void listen(STATE, ObjectCallback* chan);
+  };
+}
+
+#endif
@@ -145,7 +145,7 @@ namespace rubinius {
   }
 
   void Marshaller::set_float(Float* flt) {
-    stream << "d" << endl << flt->val << endl;
+    stream << "d" << endl << flt->val() << endl;
   }
 
   Float* UnMarshaller::get_float() {
@@ -0,0 +1,203 @@
+#include "vm/metrics.hpp"
+
+#include "vm/vm.hpp"
+#include "objectmemory.hpp"
+#include "event.hpp"
+
+#include "builtin/array.hpp"
+#include "builtin/integer.hpp"
+#include "builtin/lookuptable.hpp"
+#include "builtin/symbol.hpp"
+
+#include <signal.h>
+#include <time.h>
+#include <sys/time.h>
+
+namespace rubinius {
+  namespace metrics {
+
+    uint64_t current_us() {
+#ifdef CLOCK_MONOTONIC
+      timespec tp;
+      if(clock_gettime(CLOCK_MONOTONIC, &tp) == 0) {
+        return tp.tv_sec * 1000000ULL + tp.tv_nsec / 1000;
+      }
+#endif
+      timeval tv;
+      gettimeofday(&tv, NULL);
+      return tv.tv_sec * 1000000ULL + tv.tv_usec;
+    }
+
+    void Histogram::clear() {
+      for(size_t i = 0; i < cBuckets; i++) {
+        buckets_[i] = 0;
+      }
+
+      count_ = total_ = max_ = 0;
+    }
+
+    size_t Histogram::bucket_for(uint64_t value) {
+      size_t bucket = 0;
+
+      while(value && bucket < cBuckets - 1) {
+        value >>= 1;
+        bucket++;
+      }
+
+      return bucket;
+    }
+
+    LookupTable* Histogram::to_lookup_table(STATE) {
+      size_t used = cBuckets;
+      while(used > 0 && buckets_[used - 1] == 0) used--;
+
+      Array* buckets = Array::create(state, used);
+      for(size_t i = 0; i < used; i++) {
+        buckets->set(state, i, Integer::from(state, buckets_[i]));
+      }
+
+      LookupTable* tbl = LookupTable::create(state);
+      tbl->store(state, state->symbol("count"), Integer::from(state, count_));
+      tbl->store(state, state->symbol("total"), Integer::from(state, total_));
+      tbl->store(state, state->symbol("max"), Integer::from(state, max_));
+      tbl->store(state, state->symbol("buckets"), buckets);
+
+      return tbl;
+    }
+
+    void Metrics::clear() {
+      young_collections = 0;
+      mature_collections = 0;
+      young_pause_us.clear();
+      mature_pause_us.clear();
+      context_heap_overflows = 0;
+
+      global_cache_hits = 0;
+      global_cache_misses = 0;
+      send_site_hits = 0;
+      send_site_misses = 0;
+
+      thread_switches = 0;
+    }
+
+    /* Everything the metrics report, so that the LookupTable and the
+     * printed dump can't disagree. */
+    class Visitor {
+    public:
+      virtual ~Visitor() { }
+      virtual void section(const char* name) = 0;
+      virtual void value(const char* name, uint64_t val) = 0;
+      virtual void histogram(const char* name, Histogram& hist) = 0;
+    };
+
+    static void visit(STATE, Metrics& m, Visitor& v) {
+      ObjectMemory* om = state->om;
+
+      v.section("gc");
+      v.value("young_collections", m.young_collections);
+      v.histogram("young_pause_us", m.young_pause_us);
+      v.value("mature_collections", m.mature_collections);
+      v.histogram("mature_pause_us", m.mature_pause_us);
+
+      v.section("memory");
+      v.value("young_bytes_used", om->young.current->used());
+      v.value("young_bytes", om->young.current->size);
+      v.value("mature_bytes", om->mature.allocated_bytes);
+      v.value("mature_objects", om->mature.allocated_objects);
+      v.value("context_bytes_used", om->contexts.used());
+      v.value("context_heap_overflows", m.context_heap_overflows);
+
+      v.section("dispatch");
+      v.value("global_cache_hits", m.global_cache_hits);
+      v.value("global_cache_misses", m.global_cache_misses);
+      v.value("send_site_hits", m.send_site_hits);
+      v.value("send_site_misses", m.send_site_misses);
+
+      v.section("scheduler");
+      v.value("thread_switches", m.thread_switches);
+      v.value("event_loop_iterations", state->events->loop_count());
+    }
+
+    class TableVisitor : public Visitor {
+      VM* state;
+      LookupTable* section_;
+
+    public:
+      LookupTable* table;
+
+      TableVisitor(STATE) :
+        state(state), section_(NULL), table(LookupTable::create(state)) { }
+
+      void section(const char* name) {
+        section_ = LookupTable::create(state);
+        table->store(state, state->symbol(name), section_);
+      }
+
+      void value(const char* name, uint64_t val) {
+        section_->store(state, state->symbol(name), Integer::from(state, val));
+      }
+
+      void histogram(const char* name, Histogram& hist) {
+        section_->store(state, state->symbol(name), hist.to_lookup_table(state));
+      }
+    };
+
+    class PrintVisitor : public Visitor {
+      std::ostream& stream_;
+      const char* section_;
+
+    public:
+      PrintVisitor(std::ostream& stream) : stream_(stream), section_("") { }
+
+      void section(const char* name) {
+        section_ = name;
+      }
+
+      void value(const char* name, uint64_t val) {
+        stream_ << section_ << "." << name << ": " << val << "\n";
+      }
+
+      void histogram(const char* name, Histogram& hist) {
+        stream_ << section_ << "." << name << ": count=" << hist.count()
+                << " total=" << hist.total() << " max=" << hist.max();
+
+        for(size_t i = 0; i < Histogram::cBuckets; i++) {
+          if(hist.bucket(i) == 0) continue;
+          stream_ << " <" << (1ULL << i) << "=" << hist.bucket(i);
+        }
+
+        stream_ << "\n";
+      }
+    };
+
+    LookupTable* Metrics::to_lookup_table(STATE) {
+      TableVisitor visitor(state);
+      visit(state, *this, visitor);
+      return visitor.table;
+    }
+
+    void Metrics::print(STATE, std::ostream& stream) {
+      PrintVisitor visitor(stream);
+      visit(state, *this, visitor);
+      stream.flush();
+    }
+
+    static VM* dump_state = NULL;
+
+    static void dump_signal_handler(int sig) {
+      if(!dump_state) return;
+      dump_state->interrupts.dump_metrics = true;
+      dump_state->interrupts.check = true;
+    }
+
+    void Metrics::dump_on_signal(STATE, int sig) {
+      dump_state = state;
+
+      struct sigaction action;
+      action.sa_handler = dump_signal_handler;
+      action.sa_flags = SA_RESTART;
+      sigemptyset(&action.sa_mask);
+      sigaction(sig, &action, NULL);
+    }
+  }
+}
@@ -0,0 +1,127 @@
+#ifndef RBX_METRICS_HPP
+#define RBX_METRICS_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <iostream>
+
+namespace rubinius {
+  class VM;
+  class Object;
+  class LookupTable;
+
+  namespace metrics {
+
+    /* Microseconds on a monotonic clock. */
+    uint64_t current_us();
+
+    /**
+     *  Counts values by their order of magnitude: bucket 0 holds zeros,
+     *  and bucket n the values from 2^(n-1) up to 2^n - 1. The last
+     *  bucket also takes anything bigger.
+     */
+    class Histogram {
+    public:
+      static const size_t cBuckets = 32;
+
+    private:
+      uint64_t buckets_[cBuckets];
+      uint64_t count_;
+      uint64_t total_;
+      uint64_t max_;
+
+    public:
+      Histogram() {
+        clear();
+      }
+
+      void clear();
+
+      static size_t bucket_for(uint64_t value);
+
+      void record(uint64_t value) {
+        buckets_[bucket_for(value)]++;
+        count_++;
+        total_ += value;
+        if(value > max_) max_ = value;
+      }
+
+      uint64_t bucket(size_t index) {
+        return buckets_[index];
+      }
+
+      uint64_t count() {
+        return count_;
+      }
+
+      uint64_t total() {
+        return total_;
+      }
+
+      uint64_t max() {
+        return max_;
+      }
+
+      /* A LookupTable of :count, :total, :max and :buckets, an Array of
+       * the counts up to the last non-empty bucket. */
+      LookupTable* to_lookup_table(VM* state);
+    };
+
+    /* Records the time from its creation to its destruction. */
+    class Timer {
+      Histogram& histogram_;
+      uint64_t start_;
+
+    public:
+      Timer(Histogram& histogram) :
+        histogram_(histogram), start_(current_us()) { }
+
+      ~Timer() {
+        histogram_.record(current_us() - start_);
+      }
+    };
+
+    /**
+     *  Always on counters kept by the VM. Everything here is a plain
+     *  increment on a path that's already doing more work than that;
+     *  values that can be read off the VM when asked, like heap usage,
+     *  aren't kept here but added by to_lookup_table.
+     */
+    class Metrics {
+    public:
+      /* ObjectMemory */
+      uint64_t young_collections;
+      uint64_t mature_collections;
+      Histogram young_pause_us;
+      Histogram mature_pause_us;
+      uint64_t context_heap_overflows;
+
+      /* Method dispatch */
+      uint64_t global_cache_hits;
+      uint64_t global_cache_misses;
+      uint64_t send_site_hits;
+      uint64_t send_site_misses;
+
+      /* Scheduling */
+      uint64_t thread_switches;
+
+      Metrics() {
+        clear();
+      }
+
+      void clear();
+
+      /* A LookupTable of subsystem name to a LookupTable of its values. */
+      LookupTable* to_lookup_table(VM* state);
+
+      void print(VM* state, std::ostream& stream);
+
+      /* Makes +sig+ print the metrics of +state+ to stderr the next time
+       * it checks its interrupts. */
+      static void dump_on_signal(VM* state, int sig);
+    };
+  }
+}
+
+#endif
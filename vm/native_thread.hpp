@@ -0,0 +1,128 @@
+#ifndef RBX_NATIVE_THREAD_HPP
+#define RBX_NATIVE_THREAD_HPP
+
+#include <pthread.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/resource.h>
+
+namespace rubinius {
+  namespace native {
+
+    /**
+     *  A pointer with a separate value on every native thread, for the
+     *  little state that belongs to the VM running on a thread but is
+     *  reached without a VM at hand.
+     *
+     *  Meant to be a static. The optional +cleanup+ is called with the
+     *  value when a thread holding one exits.
+     */
+    template <typename T>
+    class ThreadLocal {
+      pthread_key_t key_;
+
+    public:
+      ThreadLocal(void (*cleanup)(void*) = NULL) {
+        pthread_key_create(&key_, cleanup);
+      }
+
+      T get() {
+        return static_cast<T>(pthread_getspecific(key_));
+      }
+
+      void set(T value) {
+        pthread_setspecific(key_, value);
+      }
+    };
+
+    /** A mutex, for the few structures shared by all VMs in a process. */
+    class Mutex {
+      pthread_mutex_t mutex_;
+
+    public:
+      Mutex() {
+        pthread_mutex_init(&mutex_, NULL);
+      }
+
+      ~Mutex() {
+        pthread_mutex_destroy(&mutex_);
+      }
+
+      void lock() {
+        pthread_mutex_lock(&mutex_);
+      }
+
+      void unlock() {
+        pthread_mutex_unlock(&mutex_);
+      }
+
+      pthread_mutex_t* native() {
+        return &mutex_;
+      }
+    };
+
+    /** A condition variable, waited on with a Mutex held. */
+    class Condition {
+      pthread_cond_t cond_;
+
+    public:
+      Condition() {
+        pthread_cond_init(&cond_, NULL);
+      }
+
+      ~Condition() {
+        pthread_cond_destroy(&cond_);
+      }
+
+      void wait(Mutex& mutex) {
+        pthread_cond_wait(&cond_, mutex.native());
+      }
+
+      /** Waits until signalled or the wall clock reaches +deadline+.
+       * Returns false if the deadline passed. */
+      bool wait_until(Mutex& mutex, const struct timespec* deadline) {
+        return pthread_cond_timedwait(&cond_, mutex.native(), deadline) == 0;
+      }
+
+      void signal() {
+        pthread_cond_signal(&cond_);
+      }
+
+      void broadcast() {
+        pthread_cond_broadcast(&cond_);
+      }
+    };
+
+    /** Holds a Mutex for the rest of the scope, exceptions included. */
+    class LockGuard {
+      Mutex& mutex_;
+
+    public:
+      LockGuard(Mutex& mutex) : mutex_(mutex) {
+        mutex_.lock();
+      }
+
+      ~LockGuard() {
+        mutex_.unlock();
+      }
+    };
+
+    /** The CPU time used so far by the calling native thread, in
+     * microseconds. Falls back on the whole process where there's no
+     * per thread clock. */
+    inline uint64_t cpu_time_usec() {
+#ifdef CLOCK_THREAD_CPUTIME_ID
+      struct timespec ts;
+      if(clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+        return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+      }
+#endif
+      struct rusage usage;
+      getrusage(RUSAGE_SELF, &usage);
+      return (uint64_t)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 +
+        usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+    }
+  }
+}
+
+#endif
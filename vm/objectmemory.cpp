@@ -21,6 +21,8 @@ namespace rubinius {
 
     collect_young_now = false;
     collect_mature_now = false;
+    collecting = false;
+    collections = 0;
     large_object_threshold = 2700;
     young.lifetime = 6;
     last_object_id = 0;
@@ -77,17 +79,30 @@ namespace rubinius {
   }
 
   void ObjectMemory::collect_young(Roots &roots) {
-    static int collect_times = 0;
-    young.collect(roots);
-    collect_times++;
+    metrics::Timer timer(state->metrics.young_pause_us);
+    state->metrics.young_collections++;
+
+    collecting = true;
+    collections++;
 
+    young.collect(roots);
     contexts.reset();
+
+    collecting = false;
   }
 
   void ObjectMemory::collect_mature(Roots &roots) {
+    metrics::Timer timer(state->metrics.mature_pause_us);
+    state->metrics.mature_collections++;
+
+    collecting = true;
+    collections++;
+
     mature.collect(roots);
     young.clear_marks();
     clear_context_marks();
+
+    collecting = false;
   }
 
   void ObjectMemory::add_type_info(TypeInfo* ti) {
@@ -115,6 +130,12 @@ namespace rubinius {
     }
   }
 
+  /* Called once RequiresCleanup has been set on +obj+, so that a young
+   * collection can find it without walking every object. */
+  void ObjectMemory::track_cleanup(Object* obj) {
+    if(obj->young_object_p()) young.track_cleanup(obj);
+  }
+
   // DEPRECATED
   void ObjectMemory::store_object(Object* target, size_t index, Object* val) {
     ((Tuple*)target)->field[index] = val;
@@ -150,13 +171,21 @@ namespace rubinius {
   }
 
   Object* ObjectMemory::new_object(Class* cls, size_t fields) {
-    Object* obj;
+    Object* obj = NULL;
+
+    if(fields <= large_object_threshold) obj = young.local_allocate(fields);
+
+    if(obj) {
+      obj->clear_fields();
+    } else {
+      obj = allocate_object(fields);
+    }
 
-    obj = allocate_object(fields);
     set_class(obj, cls);
 
     obj->obj_type = (object_type)cls->instance_type()->to_native();
     obj->RequiresCleanup = type_info[obj->obj_type]->instances_need_cleanup;
+    if(obj->RequiresCleanup) track_cleanup(obj);
 
     return obj;
   }
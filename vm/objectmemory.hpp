@@ -40,6 +40,11 @@ namespace rubinius {
     bool collect_young_now;
     bool collect_mature_now;
 
+    /* Set while a collection runs, and the number of collections started.
+     * Read from the Sampler's signal handler. */
+    volatile bool collecting;
+    volatile size_t collections;
+
     STATE;
     ObjectArray *remember_set;
     BakerGC young;
@@ -56,6 +61,7 @@ namespace rubinius {
 
     void remember_object(Object* target);
     void unremember_object(Object* target);
+    void track_cleanup(Object* obj);
 
     void store_object(Object* target, size_t index, Object* val);
     void set_class(Object* target, Object* obj);
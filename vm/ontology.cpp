@@ -37,6 +37,8 @@
 #include "builtin/tuple.hpp"
 #include "builtin/taskprobe.hpp"
 
+#include "mailbox.hpp"
+
 #define SPECIAL_CLASS_MASK 0x1f
 #define SPECIAL_CLASS_SIZE 32
 #define CUSTOM_CLASS GO(object)
@@ -276,6 +278,9 @@ namespace rubinius {
 
     G(rubinius)->set_const(state, "WORDSIZE", Fixnum::from(sizeof(void*) * 8));
 
+    // The number other VMs send messages to this one with.
+    G(rubinius)->set_const(state, "VM_ID", Fixnum::from(mailbox->id()));
+
 #if defined(__ppc__) || defined(__POWERPC__) || defined(_POWER)
     G(rubinius)->set_const(state, "PLATFORM", symbol("ppc"));
 #elif defined(__amd64__)
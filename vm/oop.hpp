@@ -15,6 +15,11 @@ namespace rubinius {
    * if tag == 01, the data is a fixnum
    * if tag == 10, the data is a literal
    * if tag == 11, the data is any data, using the DATA_* macros
+   *
+   * DATA uses a third tag bit:
+   * if tag == 011, the data is a symbol
+   * if tag == 111, the data is a flonum, a Float stored in the OOP itself
+   *                (64 bit platforms only, see Float::create)
    */
 
 #define TAG_MASK    0x3
@@ -36,14 +41,18 @@ namespace rubinius {
 #define DATA_SHIFT  3
 
 #define DATA_TAG_SYMBOL 0x3
-#define DATA_TAG_CUSTOM 0x7
+#define DATA_TAG_FLONUM 0x7
 
 #define DATA_TAG(v) ((intptr_t)(v) & DATA_MASK)
 #define DATA_APPLY_TAG(v, tag) (Object*)((v << DATA_SHIFT) | tag)
 #define DATA_STRIP_TAG(v) (((intptr_t)v) >> DATA_SHIFT)
 
 #define SYMBOL_P(v) (DATA_TAG(v) == DATA_TAG_SYMBOL)
-#define CUSTOM_P(v) (DATA_TAG(v) == DATA_TAG_CUSTOM)
+#define FLONUM_P(v) (DATA_TAG(v) == DATA_TAG_FLONUM)
+
+#if __WORDSIZE == 64
+#define RBX_FLONUM 1
+#endif
 
   /* How many bits of data are available in fixnum, not including
      the sign. */
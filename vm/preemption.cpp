@@ -0,0 +1,105 @@
+#include "vm/preemption.hpp"
+
+#include "vm/vm.hpp"
+
+#include <signal.h>
+#include <sys/time.h>
+
+namespace rubinius {
+
+  static bool passed_p(const struct timespec& deadline) {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+
+    if(now.tv_sec != deadline.tv_sec) return now.tv_sec > deadline.tv_sec;
+    return (long)now.tv_usec * 1000 >= deadline.tv_nsec;
+  }
+
+  static void* preemption_tramp(void* arg) {
+    static_cast<PreemptionTimer*>(arg)->run();
+    return NULL;
+  }
+
+  PreemptionTimer::PreemptionTimer(VM* state)
+    : state_(state)
+    , running_(false)
+    , stop_(false)
+    , armed_(false)
+    , fired_(0)
+  { }
+
+  PreemptionTimer::~PreemptionTimer() {
+    if(!running_) return;
+
+    {
+      native::LockGuard guard(lock_);
+      stop_ = true;
+      cond_.signal();
+    }
+
+    pthread_join(thread_, NULL);
+  }
+
+  bool PreemptionTimer::start() {
+    if(running_) return true;
+
+    running_ = pthread_create(&thread_, NULL, preemption_tramp, this) == 0;
+    return running_;
+  }
+
+  void PreemptionTimer::arm(uint64_t usec) {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+
+    uint64_t nsec = (uint64_t)now.tv_usec * 1000 + usec * 1000;
+
+    native::LockGuard guard(lock_);
+
+    deadline_.tv_sec = now.tv_sec + nsec / 1000000000;
+    deadline_.tv_nsec = nsec % 1000000000;
+    armed_ = true;
+
+    cond_.signal();
+  }
+
+  void PreemptionTimer::disarm() {
+    native::LockGuard guard(lock_);
+
+    // Not signalled, the timer thread finds out when it next wakes.
+    armed_ = false;
+  }
+
+  bool PreemptionTimer::armed_p() {
+    native::LockGuard guard(lock_);
+    return armed_;
+  }
+
+  void PreemptionTimer::run() {
+    // Signals are for the VM's own thread.
+    sigset_t mask;
+    sigfillset(&mask);
+    pthread_sigmask(SIG_BLOCK, &mask, NULL);
+
+    native::LockGuard guard(lock_);
+
+    while(!stop_) {
+      if(!armed_) {
+        cond_.wait(lock_);
+        continue;
+      }
+
+      // Woken early means re-armed, disarmed or stopped, so look again.
+      if(cond_.wait_until(lock_, &deadline_)) continue;
+      if(!armed_ || !passed_p(deadline_)) continue;
+
+      armed_ = false;
+      fired_++;
+
+      if(state_->interrupts.enable_preempt) {
+        state_->interrupts.reschedule = true;
+        state_->interrupts.check_events = true;
+        state_->interrupts.check = true;
+      }
+    }
+  }
+}
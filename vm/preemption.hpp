@@ -0,0 +1,63 @@
+#ifndef RBX_PREEMPTION_HPP
+#define RBX_PREEMPTION_HPP
+
+#include <stdint.h>
+#include <pthread.h>
+
+#include "native_thread.hpp"
+
+namespace rubinius {
+  class VM;
+
+  /**
+   *  Ends the current Thread's time slice by asking the VM to reschedule.
+   *
+   *  A native thread per VM sleeps on a condition variable. While the
+   *  timer is disarmed it never wakes. Once armed it sleeps until the
+   *  deadline, then sets the VM's interrupts and disarms itself. The
+   *  VM arms it while some other Thread is waiting to run, or less often
+   *  while Threads wait on the event loop, so that it gets polled. A VM
+   *  with a single Thread and nothing to wait for, or an idle one, takes
+   *  no timer wakeups at all.
+   */
+  class PreemptionTimer {
+    VM* state_;
+    pthread_t thread_;
+    native::Mutex lock_;
+    native::Condition cond_;
+
+    bool running_;
+    bool stop_;
+    bool armed_;
+    struct timespec deadline_;
+
+    /* The number of times the timer has fired. */
+    volatile size_t fired_;
+
+  public:
+    PreemptionTimer(VM* state);
+
+    /* Stops the timer thread and waits for it. */
+    ~PreemptionTimer();
+
+    /* Starts the timer thread. Returns false if it couldn't be created. */
+    bool start();
+
+    /* Fires once, +usec+ microseconds from now, replacing any earlier
+     * deadline. */
+    void arm(uint64_t usec);
+
+    void disarm();
+
+    bool armed_p();
+
+    size_t fired() {
+      return fired_;
+    }
+
+    /* The body of the timer thread. */
+    void run();
+  };
+}
+
+#endif
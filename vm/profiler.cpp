@@ -14,7 +14,19 @@
   #define USE_MACH_TIME
 #endif
 
-#ifdef USE_MACH_TIME
+#if defined(__i386__) || defined(__x86_64__)
+
+// The time stamp counter is by far the cheapest clock to read. Ticks are
+// converted to nanoseconds only when results are printed.
+static inline uint64_t current_time() {
+  uint32_t lo, hi;
+  __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+  return ((uint64_t)hi << 32) | lo;
+}
+#define METHOD "rdtsc"
+#define USE_TICKS
+
+#elif defined(USE_MACH_TIME)
 
 #include <mach/mach_time.h>
 #define current_time() mach_absolute_time()
@@ -58,19 +70,42 @@ namespace rubinius {
     }
 
     void Invocation::stop() {
-      leaf_->add_total_time(current_time() - start_time_);
+      leaf().add_total_time(current_time() - start_time_);
     }
 
-    Method::~Method() {
-      for(Leaves::iterator i = leaves_.begin();
-          i != leaves_.end();
-          i++) {
-        delete i->second;
+#ifdef USE_TICKS
+    static uint64_t clock_ns() {
+      timespec tp;
+      clock_gettime(CLOCK_MONOTONIC, &tp);
+      return tp.tv_sec * 1000000000ULL + tp.tv_nsec;
+    }
+
+    /* The tick rate isn't known up front, so it's measured against the
+     * monotonic clock the first time it's needed. */
+    static double ns_per_tick() {
+      static double ratio = 0.0;
+
+      if(ratio == 0.0) {
+        uint64_t start_ns = clock_ns();
+        uint64_t start = current_time();
+
+        uint64_t end_ns;
+        do {
+          end_ns = clock_ns();
+        } while(end_ns - start_ns < 5000000ULL);
+
+        uint64_t ticks = current_time() - start;
+        ratio = ticks ? (double)(end_ns - start_ns) / ticks : 1.0;
       }
+
+      return ratio;
     }
+#endif
 
     static uint64_t in_nanoseconds(uint64_t time) {
-#ifdef USE_MACH_TIME
+#if defined(USE_TICKS)
+      return (uint64_t)(time * ns_per_tick());
+#elif defined(USE_MACH_TIME)
       static mach_timebase_info_data_t timebase = {0, 0};
 
       if(timebase.denom == 0) {
@@ -88,20 +123,33 @@ namespace rubinius {
       return in_nanoseconds(total_time_);
     }
 
+    uint64_t Method::self_time() {
+      uint64_t callees = 0;
+
+      for(Leaves::iterator i = leaves_.begin(); i != leaves_.end(); i++) {
+        callees += i->total_time();
+      }
+
+      // Recursive calls are counted in both, so this can come out negative.
+      return callees < total_time_ ? total_time_ - callees : 0;
+    }
+
     uint64_t Leaf::total_time_in_ns() {
       return in_nanoseconds(total_time_);
     }
 
-    Leaf* Method::find_leaf(Method* callee) {
-      Leaves::iterator i = leaves_.find(callee);
+    size_t Method::find_leaf(Method* callee) {
+      // A method usually calls the same one several times in a row.
+      if(last_leaf_ < leaves_.size() && leaves_[last_leaf_].method() == callee) {
+        return last_leaf_;
+      }
 
-      if(i != leaves_.end()) {
-        return i->second;
+      for(size_t i = 0; i < leaves_.size(); i++) {
+        if(leaves_[i].method() == callee) return last_leaf_ = i;
       }
 
-      Leaf* leaf = new Leaf(callee);
-      leaves_[callee] = leaf;
-      return leaf;
+      leaves_.push_back(Leaf(callee));
+      return last_leaf_ = leaves_.size() - 1;
     }
 
     void Leaf::add_total_time(uint64_t diff) {
@@ -109,41 +157,53 @@ namespace rubinius {
       method_->add_total_time(diff);
     }
 
-    Profiler::Profiler() {
-      top_ = new Method(0, 0, false);
+    static uint64_t next_profiler_id = 1;
+
+    Profiler::Profiler()
+      : id_(next_profiler_id++)
+    {
+      top_ = new Method(0, 0, 0);
       current_ = top_;
     }
 
     Profiler::~Profiler() {
-      for(MethodMap::iterator i = methods_.begin();
-          i != methods_.end();
+      for(std::vector<Method*>::iterator i = all_methods_.begin();
+          i != all_methods_.end();
           i++) {
-        delete i->second;
+        delete *i;
       }
 
       delete top_;
     }
 
-    Method* Profiler::enter_method(Symbol* name, Object* container, Kind kind) {
+    Method* Profiler::find_method(Symbol* name, Object* container, Kind kind) {
       Key key(name, container, kind);
 
-      Method* meth;
-
-      meth = find_key(key);
+      Method* meth = find_key(key);
       if(!meth) {
-        meth = new Method(methods_.size(), name, container, kind);
+        meth = new Method(all_methods_.size(), name, container, kind);
         methods_[key] = meth;
+        all_methods_.push_back(meth);
       }
 
-      Leaf* leaf = current_->find_leaf(meth);
+      return meth;
+    }
 
-      current_ = meth;
+    Method* Profiler::enter_method(Symbol* name, Object* container, Kind kind) {
+      return enter_method(find_method(name, container, kind));
+    }
+
+    Method* Profiler::enter_method(Method* meth) {
+      Method* caller = current_;
+      size_t leaf = caller->find_leaf(meth);
 
+      caller->leaf(leaf).called();
       meth->called();
 
-      Invocation invoke(leaf);
-      invoke.start();
-      running_.push(invoke);
+      current_ = meth;
+
+      running_.push_back(Invocation(caller, leaf));
+      running_.back().start();
 
       return meth;
     }
@@ -151,20 +211,18 @@ namespace rubinius {
     void Profiler::leave_method() {
       assert(!running_.empty());
 
-      Invocation& invoke = running_.top();
-      invoke.stop();
-
-      running_.pop();
+      running_.back().stop();
+      running_.pop_back();
 
       if(running_.empty()) {
         current_ = top_;
       } else {
-        current_ = running_.top().leaf()->method();
+        current_ = running_.back().leaf().method();
       }
     }
 
     size_t Profiler::number_of_entries() {
-      return methods_.size();
+      return all_methods_.size();
     }
 
     size_t Profiler::depth() {
@@ -172,25 +230,40 @@ namespace rubinius {
     }
 
     Method* Profiler::find_key(Key& key) {
-      return methods_[key];
+      MethodMap::iterator i = methods_.find(key);
+      if(i == methods_.end()) return NULL;
+      return i->second;
     }
 
     static bool method_cmp(Method* a, Method* b) {
       return a->total_time() > b->total_time();
     }
 
-    void Profiler::print_results(STATE, std::ostream& stream) {
-      std::vector<Method*> all_methods(0);
+    static void print_method_name(STATE, std::ostream& stream, Method* meth) {
+      if(Symbol* klass = try_as<Symbol>(meth->container())) {
+        stream << klass->c_str(state);
+      } else {
+        stream << "unknown";
+      }
 
-      for(MethodMap::iterator i = methods_.begin();
-          i != methods_.end();
-          i++) {
-        all_methods.push_back(i->second);
+      Kind kind = meth->kind();
+      if(kind == kNormal) {
+        stream << ".";
+      } else if(kind == kSingleton) {
+        stream << "#";
+      } else if(kind == kBlock) {
+        stream << "#.";
       }
 
+      stream << meth->method()->c_str(state);
+    }
+
+    void Profiler::print_results(STATE, std::ostream& stream) {
+      std::vector<Method*> all_methods(all_methods_);
+
       std::sort(all_methods.begin(), all_methods.end(), method_cmp);
 
-      stream << "<profile methods='" << methods_.size() <<
+      stream << "<profile methods='" << all_methods.size() <<
         "' method='" << METHOD << "'>\n";
 
       for(std::vector<Method*>::iterator i = all_methods.begin();
@@ -199,22 +272,7 @@ namespace rubinius {
         Method* meth = *i;
         stream << "<method id='" << meth->id() << "' name='";
 
-        if(Symbol* klass = try_as<Symbol>(meth->container())) {
-          stream << klass->c_str(state);
-        } else {
-          stream << "unknown";
-        }
-
-        Kind kind = meth->kind();
-        if(kind == kNormal) {
-          stream << ".";
-        } else if(kind == kSingleton) {
-          stream << "#";
-        } else if(kind == kBlock) {
-          stream << "#.";
-        }
-
-        stream << meth->method()->c_str(state);
+        print_method_name(state, stream, meth);
 
         stream << "' total='" << meth->total_time_in_ns() <<
           "' called='" << meth->called_times();
@@ -226,10 +284,9 @@ namespace rubinius {
 
         stream << "'>\n";
 
-        for(Leaves::iterator li = meth->leaves_begin();
-            li != meth->leaves_end();
-            li++) {
-          Leaf* leaf = li->second;
+        for(Leaves::iterator leaf = meth->leaves_begin();
+            leaf != meth->leaves_end();
+            leaf++) {
           stream << "  <leaf id='" << leaf->method()->id() <<
             "' total='" << leaf->total_time_in_ns() << "'/>\n";
         }
@@ -238,5 +295,46 @@ namespace rubinius {
 
       stream << "</profile>\n";
     }
+
+    static void print_callgrind_file(STATE, std::ostream& stream, Method* meth) {
+      if(meth->file()) {
+        stream << meth->file()->c_str(state);
+      } else {
+        stream << "unknown";
+      }
+    }
+
+    void Profiler::print_callgrind(STATE, std::ostream& stream) {
+      stream << "version: 1\n";
+      stream << "creator: rubinius\n";
+      stream << "positions: line\n";
+      stream << "events: ns\n";
+
+      for(std::vector<Method*>::iterator i = all_methods_.begin();
+          i != all_methods_.end();
+          i++) {
+        Method* meth = *i;
+
+        stream << "\nfl=";
+        print_callgrind_file(state, stream, meth);
+        stream << "\nfn=";
+        print_method_name(state, stream, meth);
+        stream << "\n" << meth->line() << " "
+               << in_nanoseconds(meth->self_time()) << "\n";
+
+        for(Leaves::iterator leaf = meth->leaves_begin();
+            leaf != meth->leaves_end();
+            leaf++) {
+          Method* callee = leaf->method();
+
+          stream << "cfl=";
+          print_callgrind_file(state, stream, callee);
+          stream << "\ncfn=";
+          print_method_name(state, stream, callee);
+          stream << "\ncalls=" << leaf->called_times() << " " << callee->line()
+                 << "\n" << meth->line() << " " << leaf->total_time_in_ns() << "\n";
+        }
+      }
+    }
   }
 }
@@ -4,9 +4,8 @@
 #include <stdint.h>
 #include <stdio.h>
 
-#include <stack>
 #include <tr1/unordered_map>
-#include <map>
+#include <vector>
 #include <iostream>
 
 namespace rubinius {
@@ -37,13 +36,17 @@ namespace rubinius {
     };
 
     class Method;
+
+    /* An edge of the call graph: the time spent in calls to +method_+
+     * from the Method holding this Leaf. */
     class Leaf {
     private:
       Method* method_;
       uint64_t total_time_;
+      uint64_t called_times_;
 
     public:
-      Leaf(Method* meth) : method_(meth), total_time_(0) { }
+      Leaf(Method* meth) : method_(meth), total_time_(0), called_times_(0) { }
 
       Method* method() {
         return method_;
@@ -56,9 +59,19 @@ namespace rubinius {
       }
 
       uint64_t total_time_in_ns();
+
+      void called() {
+        called_times_++;
+      }
+
+      uint64_t called_times() {
+        return called_times_;
+      }
     };
 
-    typedef std::map<Method*, Leaf*> Leaves;
+    /* Most methods call only a handful of others, so a vector searched
+     * linearly beats a map here. */
+    typedef std::vector<Leaf> Leaves;
 
     class Method {
     private:
@@ -68,6 +81,7 @@ namespace rubinius {
       Kind     kind_;
       uint64_t total_time_;
       Leaves leaves_;
+      size_t last_leaf_;
       uint64_t called_times_;
       Symbol*  file_;
       int      line_;
@@ -79,13 +93,12 @@ namespace rubinius {
         container_(container),
         kind_(kind),
         total_time_(0),
+        last_leaf_(0),
         called_times_(0),
         file_(0),
         line_(0)
       { }
 
-      ~Method();
-
       uint64_t id() {
         return id_;
       }
@@ -129,11 +142,19 @@ namespace rubinius {
 
       uint64_t total_time_in_ns();
 
+      /* Time spent in this method itself, not in the methods it called. */
+      uint64_t self_time();
+
       void add_total_time(uint64_t diff) {
         total_time_ += diff;
       }
 
-      Leaf* find_leaf(Method* meth);
+      /* Index of the Leaf for calls to +meth+, added if needed. */
+      size_t find_leaf(Method* meth);
+
+      Leaf& leaf(size_t index) {
+        return leaves_[index];
+      }
 
       size_t number_of_leaves() {
         return leaves_.size();
@@ -148,18 +169,21 @@ namespace rubinius {
       }
     };
 
+    /* A call in progress. The Leaf is kept as an index because the
+     * caller's Leaves may grow, and move, before the call returns. */
     class Invocation {
     private:
+      Method* caller_;
+      size_t leaf_;
       uint64_t start_time_;
-      Leaf* leaf_;
 
     public:
-      Invocation(Leaf* meth) : leaf_(meth) { }
+      Invocation(Method* caller, size_t leaf) : caller_(caller), leaf_(leaf) { }
       void start();
       void stop();
 
-      Leaf* leaf() {
-        return leaf_;
+      Leaf& leaf() {
+        return caller_->leaf(leaf_);
       }
     };
   }
@@ -179,25 +203,50 @@ namespace std {
 namespace rubinius {
 
   namespace profiler {
+    /**
+     *  Instrumenting profiler, fed by the VM on every method entry and
+     *  return.
+     *
+     *  Looking a Method up by Key costs a hash lookup, so callers are
+     *  expected to cache the result (VMMethod does) and use the
+     *  enter_method(Method*) fast path. Profilers are numbered so that a
+     *  cache filled by an earlier Profiler can be recognized as stale.
+     */
     class Profiler {
       typedef std::tr1::unordered_map<Key, Method*> MethodMap;
 
     private:
+      uint64_t id_;
       MethodMap methods_;
-      std::stack<Invocation> running_;
+      std::vector<Method*> all_methods_;
+      std::vector<Invocation> running_;
       Method* top_;
       Method* current_;
 
     public:
       Profiler();
       ~Profiler();
+
+      uint64_t id() {
+        return id_;
+      }
+
+      /* Returns the Method for this name, container and kind, creating it
+       * if needed. */
+      Method* find_method(Symbol* meth, Object* container, Kind kind = kNormal);
+
       Method* enter_method(Symbol* meth, Object* container, Kind kind = kNormal);
+      Method* enter_method(Method* meth);
       void leave_method();
       size_t number_of_entries();
       Method* find_key(Key& key);
       size_t depth();
       void   print_results(VM* state, std::ostream& stream);
 
+      /* Writes the call graph in the format read by callgrind_annotate
+       * and KCachegrind. */
+      void   print_callgrind(VM* state, std::ostream& stream);
+
       Method* current_method() {
         return current_;
       }
@@ -0,0 +1,101 @@
+#include "vm/run_queue.hpp"
+
+#include "vm/object_utils.hpp"
+#include "vm/vm.hpp"
+
+#include "builtin/fixnum.hpp"
+#include "builtin/thread.hpp"
+#include "builtin/tuple.hpp"
+
+namespace rubinius {
+
+  RunQueue::RunQueue(Roots* roots)
+    : heads_(roots)
+    , ready_(0)
+  { }
+
+  void RunQueue::init(STATE) {
+    heads_.set(Tuple::create(state, cMaxPriority + 1));
+    ready_ = 0;
+  }
+
+  size_t RunQueue::priority_of(Thread* thread) {
+    size_t priority = thread->priority()->to_native();
+    return priority > cMaxPriority ? cMaxPriority : priority;
+  }
+
+  bool RunQueue::linked_p(Thread* thread) {
+    return !thread->queue_next()->nil_p();
+  }
+
+  void RunQueue::push(STATE, Thread* thread) {
+    if(linked_p(thread)) return;
+
+    size_t priority = priority_of(thread);
+    Tuple* heads = heads_.get();
+    Object* head_obj = heads->at(state, priority);
+
+    if(head_obj->nil_p()) {
+      thread->queue_next(state, thread);
+      thread->queue_prev(state, thread);
+      heads->put(state, priority, thread);
+      ready_ |= (1ULL << priority);
+    } else {
+      Thread* head = as<Thread>(head_obj);
+      Thread* tail = head->queue_prev();
+
+      tail->queue_next(state, thread);
+      thread->queue_prev(state, tail);
+      thread->queue_next(state, head);
+      head->queue_prev(state, thread);
+    }
+  }
+
+  void RunQueue::remove(STATE, Thread* thread) {
+    if(!linked_p(thread)) return;
+
+    size_t priority = priority_of(thread);
+    Tuple* heads = heads_.get();
+    Thread* next = thread->queue_next();
+
+    if(next == thread) {
+      heads->put(state, priority, Qnil);
+      ready_ &= ~(1ULL << priority);
+    } else {
+      Thread* prev = thread->queue_prev();
+      prev->queue_next(state, next);
+      next->queue_prev(state, prev);
+
+      if(heads->at(state, priority) == thread) {
+        heads->put(state, priority, next);
+      }
+    }
+
+    thread->queue_next(state, reinterpret_cast<Thread*>(Qnil));
+    thread->queue_prev(state, reinterpret_cast<Thread*>(Qnil));
+  }
+
+  Thread* RunQueue::pop(STATE) {
+    if(ready_ == 0) return NULL;
+
+    size_t priority = 63 - __builtin_clzll(ready_);
+    Thread* thread = as<Thread>(heads_->at(state, priority));
+
+    remove(state, thread);
+    return thread;
+  }
+
+  size_t RunQueue::size(STATE, size_t priority) {
+    Object* head = heads_->at(state, priority);
+    if(head->nil_p()) return 0;
+
+    size_t count = 1;
+    for(Thread* thread = as<Thread>(head)->queue_next();
+        thread != head;
+        thread = thread->queue_next()) {
+      count++;
+    }
+
+    return count;
+  }
+}
@@ -0,0 +1,64 @@
+#ifndef RBX_RUN_QUEUE_HPP
+#define RBX_RUN_QUEUE_HPP
+
+#include <stdint.h>
+
+#include "prelude.hpp"
+#include "gc_root.hpp"
+
+namespace rubinius {
+  class Thread;
+  class Tuple;
+
+  /**
+   *  The Threads waiting to run, in one FIFO per priority.
+   *
+   *  A queued Thread is linked into a circular list through its own
+   *  queue_next and queue_prev slots, so the lists allocate nothing.
+   *  Only the head of each list is stored, in a Tuple, the tail being
+   *  the head's queue_prev. A bit per priority records which lists are
+   *  non-empty, so that queueing, removing and picking the next Thread
+   *  all take constant time.
+   *
+   *  Priorities above cMaxPriority share the cMaxPriority list.
+   */
+  class RunQueue {
+  public:
+    static const size_t cMaxPriority = 63;
+
+  private:
+    TypedRoot<Tuple*> heads_;
+    uint64_t ready_;
+
+  public:
+    RunQueue(Roots* roots);
+
+    /* Creates the list heads, once Tuple is available. */
+    void init(STATE);
+
+    static size_t priority_of(Thread* thread);
+
+    /* True if +thread+ is linked into one of the lists. */
+    static bool linked_p(Thread* thread);
+
+    /* Appends +thread+ to the list for its priority. */
+    void push(STATE, Thread* thread);
+
+    /* Unlinks +thread+, if it's linked. */
+    void remove(STATE, Thread* thread);
+
+    /* Unlinks and returns the first Thread of the highest priority, or
+     * NULL if there are none. */
+    Thread* pop(STATE);
+
+    bool empty_p() {
+      return ready_ == 0;
+    }
+
+    /* The number of Threads queued at +priority+. Walks the list, so
+     * it's only meant for tests and debugging. */
+    size_t size(STATE, size_t priority);
+  };
+}
+
+#endif
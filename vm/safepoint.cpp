@@ -0,0 +1,63 @@
+#include "vm/safepoint.hpp"
+
+#include "vm/vm.hpp"
+
+namespace rubinius {
+
+  Safepoint::Safepoint(VM* state)
+    : state_(state)
+    , requested_(false)
+    , parked_(false)
+    , blocking_(false)
+  { }
+
+  void Safepoint::stop() {
+    native::LockGuard guard(lock_);
+
+    while(requested_) changed_.wait(lock_);
+    requested_ = true;
+
+    // requested_ has to be visible before the VM sees the interrupt.
+    __sync_synchronize();
+    state_->interrupts.check = true;
+
+    while(!parked_ && !blocking_) changed_.wait(lock_);
+  }
+
+  void Safepoint::resume() {
+    native::LockGuard guard(lock_);
+
+    requested_ = false;
+    changed_.broadcast();
+  }
+
+  void Safepoint::wait_for_resume() {
+    native::LockGuard guard(lock_);
+
+    parked_ = true;
+    changed_.broadcast();
+
+    while(requested_) changed_.wait(lock_);
+
+    parked_ = false;
+  }
+
+  void Safepoint::enter_blocking() {
+    native::LockGuard guard(lock_);
+
+    blocking_ = true;
+    changed_.broadcast();
+  }
+
+  void Safepoint::leave_blocking() {
+    native::LockGuard guard(lock_);
+
+    while(requested_) changed_.wait(lock_);
+    blocking_ = false;
+  }
+
+  bool Safepoint::stopped_p() {
+    native::LockGuard guard(lock_);
+    return requested_ && (parked_ || blocking_);
+  }
+}
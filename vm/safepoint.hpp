@@ -0,0 +1,68 @@
+#ifndef RBX_SAFEPOINT_HPP
+#define RBX_SAFEPOINT_HPP
+
+#include "native_thread.hpp"
+
+namespace rubinius {
+  class VM;
+
+  /**
+   *  Stops the native thread running a VM's Ruby code where the heap and
+   *  the VM's tables are consistent, so another native thread can work on
+   *  them.
+   *
+   *  This is the protocol green Threads will need to run on several
+   *  native workers: a worker about to collect, or to change a method
+   *  table or cache the others use, first stops the rest. The VM's thread
+   *  is at a safepoint when it handles interrupts.check, which stop() sets
+   *  for it, and while it is blocked outside Ruby code between
+   *  enter_blocking() and leave_blocking().
+   *
+   *  Only one stop() is in effect at a time; a second one waits for the
+   *  first to resume().
+   */
+  class Safepoint {
+    VM* state_;
+    native::Mutex lock_;
+    native::Condition changed_;
+
+    /* Set between stop() and resume(). Read without the lock by park(). */
+    volatile bool requested_;
+
+    /* The VM's thread is waiting in park(). */
+    bool parked_;
+
+    /* The VM's thread is outside Ruby code. */
+    bool blocking_;
+
+    void wait_for_resume();
+
+  public:
+    Safepoint(VM* state);
+
+    /* Called from another native thread, or from the VM's own while it's
+     * blocking. Returns once the VM's thread is at a safepoint. */
+    void stop();
+
+    /* Lets the VM's thread run Ruby code again. */
+    void resume();
+
+    /* Called by the VM's thread when it checks its interrupts. Waits
+     * there if a stop() is in effect. */
+    void park() {
+      if(requested_) wait_for_resume();
+    }
+
+    /* Bracket code run by the VM's thread that may block without
+     * checking its interrupts, such as waiting in the event loop.
+     * leave_blocking() waits if a stop() is in effect. */
+    void enter_blocking();
+    void leave_blocking();
+
+    /* Whether a stop() is in effect and the VM's thread has reached a
+     * safepoint. */
+    bool stopped_p();
+  };
+}
+
+#endif
@@ -0,0 +1,224 @@
+#include "vm/sampler.hpp"
+
+#include "vm/object_utils.hpp"
+#include "vm/vm.hpp"
+#include "objectmemory.hpp"
+
+#include "builtin/array.hpp"
+#include "builtin/class.hpp"
+#include "builtin/compiledmethod.hpp"
+#include "builtin/contexts.hpp"
+#include "builtin/fixnum.hpp"
+#include "builtin/staticscope.hpp"
+#include "builtin/string.hpp"
+#include "builtin/symbol.hpp"
+#include "builtin/task.hpp"
+
+#include <sys/time.h>
+
+#include <algorithm>
+
+namespace rubinius {
+
+  static Sampler* running_sampler = NULL;
+
+  static void sampler_signal_handler(int sig) {
+    if(running_sampler) running_sampler->take_sample();
+  }
+
+  Sampler::Sampler(VM* state)
+    : state_(state)
+    , head_(0)
+    , tail_(0)
+    , dropped_(0)
+    , gc_samples_(0)
+  { }
+
+  Sampler::~Sampler() {
+    stop();
+  }
+
+  void Sampler::start(int hz) {
+    if(running_sampler) running_sampler->stop();
+
+    head_ = tail_ = 0;
+    dropped_ = gc_samples_ = 0;
+    stacks_.clear();
+
+    running_sampler = this;
+
+    struct sigaction action;
+    action.sa_handler = sampler_signal_handler;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, &old_action_);
+
+    if(hz < 1) hz = 1;
+    long usec = 1000000 / hz;
+    if(usec < 1) usec = 1;
+
+    struct itimerval timer;
+    timer.it_interval.tv_sec = usec / 1000000;
+    timer.it_interval.tv_usec = usec % 1000000;
+    timer.it_value = timer.it_interval;
+    setitimer(ITIMER_PROF, &timer, NULL);
+  }
+
+  void Sampler::stop() {
+    if(running_sampler != this) return;
+
+    struct itimerval timer;
+    timer.it_interval.tv_sec = 0;
+    timer.it_interval.tv_usec = 0;
+    timer.it_value = timer.it_interval;
+    setitimer(ITIMER_PROF, &timer, NULL);
+
+    sigaction(SIGPROF, &old_action_, NULL);
+    running_sampler = NULL;
+  }
+
+  /* Runs in the signal handler, so this must not allocate, lock or raise.
+   * Samples taken while the GC runs are only counted, since the objects
+   * they'd point at are moving. */
+  void Sampler::take_sample() {
+    if(state_->om->collecting) {
+      gc_samples_++;
+      return;
+    }
+
+    size_t head = head_;
+    if(head - tail_ >= cRingSize) {
+      dropped_++;
+      return;
+    }
+
+    MethodContext* ctx = state_->globals.current_task.get()->active();
+    if(!ctx->reference_p()) return;
+
+    Sample& sample = ring_[head & (cRingSize - 1)];
+    sample.cm = ctx->cm();
+    sample.ip = ctx->ip;
+    sample.epoch = state_->om->collections;
+
+    // The sample has to be complete before the VM can see it.
+    __sync_synchronize();
+    head_ = head + 1;
+
+    state_->interrupts.check_samples = true;
+    state_->interrupts.check = true;
+  }
+
+  static std::string module_name(STATE, Module* mod) {
+    if(Symbol* name = try_as<Symbol>(mod->name())) {
+      return name->c_str(state);
+    }
+
+    return "<anonymous>";
+  }
+
+  /* Matches MethodContext#normalized_name: Foo#bar for instance methods,
+   * Foo.bar for singleton methods on modules. */
+  static std::string method_name(STATE, Module* mod, Object* name) {
+    std::string str;
+
+    if(MetaClass* meta = try_as<MetaClass>(mod)) {
+      Object* attached = meta->attached_instance();
+      if(Module* inst = try_as<Module>(attached)) {
+        str = module_name(state, inst) + ".";
+      } else {
+        str = module_name(state, attached->class_object(state)) + "#";
+      }
+    } else if(kind_of<Module>(mod)) {
+      str = module_name(state, mod) + "#";
+    }
+
+    if(Symbol* sym = try_as<Symbol>(name)) {
+      str += sym->c_str(state);
+    } else {
+      str += "<unknown>";
+    }
+
+    return str;
+  }
+
+  static std::string context_name(STATE, MethodContext* ctx) {
+    if(BlockContext* blk = try_as<BlockContext>(ctx)) {
+      MethodContext* home = blk->home();
+      if(home->reference_p()) {
+        return method_name(state, home->module(), home->name()) + " {}";
+      }
+    }
+
+    return method_name(state, ctx->module(), ctx->name());
+  }
+
+  static std::string compiled_method_name(STATE, CompiledMethod* cm) {
+    Module* mod = reinterpret_cast<Module*>(Qnil);
+    if(StaticScope* scope = try_as<StaticScope>(cm->scope())) {
+      mod = scope->module();
+    }
+
+    return method_name(state, mod, cm->name());
+  }
+
+  void Sampler::process_samples() {
+    VM* state = state_;
+
+    if(tail_ == head_) return;
+
+    Frames frames;
+    MethodContext* active = G(current_task)->active();
+
+    for(MethodContext* ctx = active; ctx->reference_p(); ctx = ctx->sender()) {
+      frames.push_back(context_name(state, ctx));
+    }
+    std::reverse(frames.begin(), frames.end());
+
+    while(tail_ != head_) {
+      Sample sample = ring_[tail_ & (cRingSize - 1)];
+      __sync_synchronize();
+      tail_ = tail_ + 1;
+
+      if(sample.epoch != state->om->collections ||
+         !kind_of<CompiledMethod>(sample.cm)) {
+        dropped_++;
+        continue;
+      }
+
+      /* By now the sampled method may have returned or called something
+       * else. The stack at this point is the best we have, but the leaf
+       * is always the method that was running when the signal came. */
+      if(active->reference_p() && active->cm() == sample.cm) {
+        stacks_[frames]++;
+      } else {
+        Frames leaf(frames);
+        leaf.push_back(compiled_method_name(state, sample.cm));
+        stacks_[leaf]++;
+      }
+    }
+  }
+
+  Array* Sampler::results() {
+    VM* state = state_;
+
+    Array* ary = Array::create(state, stacks_.size());
+    size_t index = 0;
+
+    for(Stacks::iterator i = stacks_.begin(); i != stacks_.end(); i++) {
+      const Frames& frames = i->first;
+      Array* names = Array::create(state, frames.size());
+
+      for(size_t j = 0; j < frames.size(); j++) {
+        names->set(state, j, String::create(state, frames[j].c_str()));
+      }
+
+      Array* entry = Array::create(state, 2);
+      entry->set(state, 0, names);
+      entry->set(state, 1, Integer::from(state, i->second));
+
+      ary->set(state, index++, entry);
+    }
+
+    return ary;
+  }
+}
@@ -0,0 +1,87 @@
+#ifndef RBX_SAMPLER_HPP
+#define RBX_SAMPLER_HPP
+
+#include <signal.h>
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace rubinius {
+  class VM;
+  class Array;
+  class CompiledMethod;
+  class MethodContext;
+
+  /**
+   *  Statistical profiler driven by SIGPROF.
+   *
+   *  The signal handler does as little as possible: it copies the active
+   *  CompiledMethod and ip into a ring buffer and asks the VM to check
+   *  its interrupts. The samples are turned into call stacks there, by
+   *  walking the sender chain of the active context, and counted.
+   *
+   *  SIGPROF is per process, so only one Sampler can be running at once.
+   *  It belongs to the VM on the default loop, since that VM's native
+   *  thread is the only one that leaves signals unblocked and so is the
+   *  one the handler runs on.
+   */
+  class Sampler {
+  public:
+    struct Sample {
+      CompiledMethod* cm;
+      int ip;
+      size_t epoch;
+    };
+
+    typedef std::vector<std::string> Frames;
+    typedef std::map<Frames, size_t> Stacks;
+
+    /** Must be a power of 2. */
+    static const size_t cRingSize = 1024;
+
+  private:
+    VM* state_;
+    Sample ring_[cRingSize];
+
+    /* head_ is only written by the signal handler, tail_ only by the VM. */
+    volatile size_t head_;
+    volatile size_t tail_;
+
+    volatile size_t dropped_;
+    volatile size_t gc_samples_;
+
+    Stacks stacks_;
+    struct sigaction old_action_;
+
+  public:
+    Sampler(VM* state);
+    ~Sampler();
+
+    /* Starts sampling +hz+ times per second of CPU time. */
+    void start(int hz);
+    void stop();
+
+    /* Called from the SIGPROF handler. */
+    void take_sample();
+
+    /* Counts the samples taken since the last call against the current
+     * call stack. Must run before the GC can move the sampled methods. */
+    void process_samples();
+
+    /* An Array of [frames, count] pairs, frames being an Array of method
+     * names starting at the outermost one. */
+    Array* results();
+
+    size_t gc_samples() {
+      return gc_samples_;
+    }
+
+    size_t dropped() {
+      return dropped_;
+    }
+  };
+}
+
+#endif
@@ -100,6 +100,9 @@ namespace {
     /* Set temporary location info. NOTE: not reset, so off until next call. */
     context->current_location(file, line);
 
+    /* Ruby code must see what was written through RARRAY() and RSTRING(). */
+    context->flush_cached_data();
+
     context->action(NativeMethodContext::CALL_FROM_C);
     store_current_execution_point_in(context->inside_c_method_point());
     /* Execution resumes here when returning */
@@ -112,6 +115,9 @@ namespace {
 
     context->action(NativeMethodContext::ORIGINAL_CALL);
 
+    /* The objects may have been changed or moved while in the VM. */
+    context->update_cached_data();
+
     VALUE ret = context->value_returned_to_c();
 
     context->value_returned_to_c(RBX_Qnil);
@@ -327,6 +333,18 @@ extern "C" {
     return RBX_NIL_P(context->object_from(expression_result));
   }
 
+  struct RArray* rbx_subtend_hidden_rarray(VALUE array_handle) {
+    NativeMethodContext* context = NativeMethodContext::current();
+
+    return reinterpret_cast<struct RArray*>(context->cached_array(array_handle));
+  }
+
+  struct RString* rbx_subtend_hidden_rstring(VALUE string_handle) {
+    NativeMethodContext* context = NativeMethodContext::current();
+
+    return reinterpret_cast<struct RString*>(context->cached_string(string_handle));
+  }
+
   long rbx_subtend_hidden_rstring_len(VALUE string_handle) {
     NativeMethodContext* context = NativeMethodContext::current();
 
@@ -578,6 +596,7 @@ extern "C" {
 
   VALUE rb_ary_pop(VALUE self_handle) {
     NativeMethodContext* context = NativeMethodContext::current();
+    context->invalidate_cached(self_handle);
 
     Array* self = as<Array>(context->object_from(self_handle));
     return context->handle_for(self->pop(context->state()));
@@ -585,6 +604,7 @@ extern "C" {
 
   VALUE rb_ary_push(VALUE self_handle, VALUE object_handle) {
     NativeMethodContext* context = NativeMethodContext::current();
+    context->invalidate_cached(self_handle);
 
     Array* self = as<Array>(context->object_from(self_handle));
     self->append(context->state(), context->object_from(object_handle));
@@ -598,6 +618,7 @@ extern "C" {
 
   VALUE rb_ary_shift(VALUE self_handle) {
     NativeMethodContext* context = NativeMethodContext::current();
+    context->invalidate_cached(self_handle);
 
     Array* self = as<Array>(context->object_from(self_handle));
     return context->handle_for(self->shift(context->state()));
@@ -613,6 +634,7 @@ extern "C" {
 
   void rb_ary_store(VALUE self_handle, long int index, VALUE object_handle) {
     NativeMethodContext* context = NativeMethodContext::current();
+    context->invalidate_cached(self_handle);
 
     Array* self = as<Array>(context->object_from(self_handle));
     size_t total = self->size();
@@ -632,6 +654,7 @@ extern "C" {
 
   VALUE rb_ary_unshift(VALUE self_handle, VALUE object_handle) {
     NativeMethodContext* context = NativeMethodContext::current();
+    context->invalidate_cached(self_handle);
 
     Array* self = as<Array>(context->object_from(self_handle));
     self->unshift(context->state(), context->object_from(object_handle));
@@ -1118,6 +1141,7 @@ extern "C" {
 
   VALUE rb_str_append(VALUE self_handle, VALUE other_handle) {
     NativeMethodContext* context = NativeMethodContext::current();
+    context->invalidate_cached(self_handle);
 
     String* self = as<String>(context->object_from(self_handle));
     self->append(context->state(), as<String>(context->object_from(other_handle)));
@@ -1131,6 +1155,7 @@ extern "C" {
 
   VALUE rb_str_buf_cat(VALUE string_handle, const char* other, size_t size) {
     NativeMethodContext* context = NativeMethodContext::current();
+    context->invalidate_cached(string_handle);
 
     String* string = as<String>(context->object_from(string_handle));
     string->append(context->state(), other, size);
@@ -1184,6 +1209,7 @@ extern "C" {
   /** @todo Refactor into a String::replace(). --rue */
   void rb_str_flush_char_ptr(VALUE string_handle, char* c_string, size_t length) {
     NativeMethodContext* context = NativeMethodContext::current();
+    context->invalidate_cached(string_handle);
 
     ByteArray* data = ByteArray::create(context->state(), (length + 1));
     std::memcpy(data->bytes, c_string, length);
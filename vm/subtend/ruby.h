@@ -18,8 +18,6 @@
  *  @todo Blocks/iteration. rb_iterate normally uses fptrs, could
  *        maybe do that or then support 'function objects' --rue
  *
- *  @todo RARRAY, RSTRING etc. --rue
- *
  *  @todo Const correctness. --rue
  *
  *  @todo Add some type of checking for too-long C strings etc? --rue
@@ -222,6 +220,33 @@ extern "C" {
 #define Qundef ((VALUE)-4)
 
 
+/* Views of String and Array data.
+ *
+ * Layout matched by CachedString and CachedArray in
+ * builtin/nativemethodcontext.hpp, change both files if necessary.
+ *
+ * A view stays valid until the method returns. Writes through it
+ * reach the object at the next call back into Ruby or on return,
+ * and the view is refreshed after each call back into Ruby. After
+ * changing the object with rb_ary_* or rb_str_*, use RARRAY() or
+ * RSTRING() again to get an up to date view. Setting ptr to other
+ * memory copies len bytes (or elements) from it, but the memory
+ * still belongs to the C code.
+ */
+
+/** String data as seen from C. @see RSTRING(). */
+struct RString {
+  long    len;
+  char*   ptr;
+};
+
+/** Array elements as seen from C. @see RARRAY(). */
+struct RArray {
+  long    len;
+  VALUE*  ptr;
+};
+
+
 /* Global Class objects */
 
 #define rb_cArray             (rbx_subtend_hidden_global(RbxArray))
@@ -322,8 +347,20 @@ extern "C" {
 /** Zero out N elements of type starting at given pointer. */
 #define MEMZERO(p,type,n) memset((p), 0, (sizeof(type) * (n)))
 
-/** Whether object is nil. */
-#define NIL_P(v)          rbx_subtend_hidden_nil_p((v))
+/** Whether object is nil. nil always has the same Handle. */
+#define NIL_P(v)          ((v) == Qnil)
+
+/** View of the Array's elements. @see struct RArray. */
+#define RARRAY(ary)       rbx_subtend_hidden_rarray((ary))
+
+/** The length of array ary. */
+#define RARRAY_LEN(ary)   (RARRAY((ary))->len)
+
+/** The pointer to the array ary's elements. */
+#define RARRAY_PTR(ary)   (RARRAY((ary))->ptr)
+
+/** View of the String's data. @see struct RString. */
+#define RSTRING(str)      rbx_subtend_hidden_rstring((str))
 
 /** The length of string str. */
 #define RSTRING_LEN(str)  rbx_subtend_hidden_rstring_len((str))
@@ -332,7 +369,7 @@ extern "C" {
 #define RSTRING_PTR(str)  rbx_subtend_hidden_rstring_ptr((str))
 
 /** False if expression evaluates to nil or false, true otherwise. */
-#define RTEST(v)          rbx_subtend_hidden_rtest((v))
+#define RTEST(v)          (((v) != Qfalse) && ((v) != Qnil))
 
 /** Rubinius' SafeStringValue is the same as StringValue. */
 #define SafeStringValue   StringValue
@@ -408,6 +445,12 @@ extern "C" {
   /** False if expression evaluates to nil, true otherwise. @internal. */
   int     rbx_subtend_hidden_nil_p(VALUE expression_result);
 
+  /** View of the Array in array_handle. @internal. */
+  struct RArray* rbx_subtend_hidden_rarray(VALUE array_handle);
+
+  /** View of the String in string_handle. @internal. */
+  struct RString* rbx_subtend_hidden_rstring(VALUE string_handle);
+
   /** Length of string string_handle. @internal. */
   long    rbx_subtend_hidden_rstring_len(VALUE string_handle);
 
@@ -5,7 +5,9 @@
 #include "vm.hpp"
 #include "vm/object_utils.hpp"
 #include "objectmemory.hpp"
+#include "config.hpp"
 
+#include <sstream>
 #include <cxxtest/TestSuite.h>
 
 using namespace rubinius;
@@ -155,6 +157,43 @@ class TestBignum : public CxxTest::TestSuite {
     TS_ASSERT_EQUALS(obj->to_native(), dup->to_native());
   }
 
+  void test_small_values_are_inline() {
+    Bignum* obj = Bignum::from(state, (native_int)13);
+    TS_ASSERT(obj->inline_p());
+    TS_ASSERT(!obj->RequiresCleanup);
+
+    Integer* sq = as<Bignum>(Bignum::from_string(state, "1267650600228229401496703205376", 10))->mul(state,
+        as<Bignum>(Bignum::from_string(state, "1267650600228229401496703205377", 10)));
+    TS_ASSERT(as<Bignum>(sq)->inline_p());
+    TS_ASSERT(!sq->RequiresCleanup);
+  }
+
+  void test_large_values_own_digits() {
+    std::string digits(300, '9');
+    Bignum* obj = as<Bignum>(Bignum::from_string(state, digits.c_str(), 10));
+    TS_ASSERT(!obj->inline_p());
+    TS_ASSERT(obj->RequiresCleanup);
+
+    Bignum* inline_obj = Bignum::from(state, (native_int)13);
+    inline_obj->initialize_copy(state, obj);
+    TS_ASSERT(!inline_obj->inline_p());
+    TS_ASSERT(inline_obj->RequiresCleanup);
+    TS_ASSERT_EQUALS(mp_cmp(obj->mp_val(), inline_obj->mp_val()), MP_EQ);
+  }
+
+  void test_inline_digits_move_with_object() {
+    const char* digits = "1267650600228229401496703205376";
+    Object* obj = Bignum::from_string(state, digits, 10);
+    Root root(&state->globals.roots, obj);
+
+    state->om->collect_young(state->globals.roots);
+
+    Bignum* moved = as<Bignum>(root.get());
+    TS_ASSERT(obj != moved);
+    TS_ASSERT_EQUALS(std::string(digits),
+        moved->to_s(state, Fixnum::from(10))->byte_address());
+  }
+
   void test_normalize() {
     Bignum* obj = Bignum::from(state, (native_int)13);
     Object* out = Bignum::normalize(state, obj);
@@ -183,7 +222,7 @@ class TestBignum : public CxxTest::TestSuite {
   }
 
   void check_float(Float* f, Float* g) {
-    TS_ASSERT_DELTA(f->val, g->val, TOLERANCE);
+    TS_ASSERT_DELTA(f->val(), g->val(), TOLERANCE);
   }
 
   void test_add() {
@@ -622,6 +661,104 @@ class TestBignum : public CxxTest::TestSuite {
     TS_ASSERT_EQUALS(std::string(buf), s->byte_address());
   }
 
+  void test_to_s_large_radix() {
+    /* Long enough to go through the divide and conquer path */
+    std::string digits(5000, 'z');
+    digits[0] = '-';
+    digits[1] = '7';
+    digits[4000] = '0';
+
+    Object* b = Bignum::from_string(state, digits.c_str(), 36);
+    TS_ASSERT(kind_of<Bignum>(b));
+    String* s = as<Bignum>(b)->to_s(state, Fixnum::from(36));
+
+    TS_ASSERT_EQUALS(digits, s->byte_address());
+  }
+
+  void test_to_s_leading_zero_blocks() {
+    /* 10**3000 + 1 has long runs of zeros in every split */
+    std::string digits(3001, '0');
+    digits[0] = '1';
+    digits[3000] = '1';
+
+    Object* b = Bignum::from_string(state, digits.c_str(), 10);
+    String* s = as<Bignum>(b)->to_s(state, Fixnum::from(10));
+
+    TS_ASSERT_EQUALS(digits, s->byte_address());
+  }
+
+  void test_ntt_multiply() {
+    mp_int a, b, c, d;
+    mp_init_multi(&a, &b, &c, &d, NULL);
+
+    int sizes[] = { 1, 3, 40, 700 };
+    for(int i = 0; i < 4; i++) {
+      for(int j = 0; j < 4; j++) {
+        mp_rand(&a, sizes[i]);
+        mp_rand(&b, sizes[j]);
+        mp_neg(&b, &b);
+
+        Bignum::ntt_multiply(&a, &b, &c);
+        mp_mul(&a, &b, &d);
+        TS_ASSERT_EQUALS(mp_cmp(&c, &d), MP_EQ);
+      }
+    }
+
+    mp_clear_multi(&a, &b, &c, &d, NULL);
+  }
+
+  void test_ntt_multiply_square_in_place() {
+    mp_int a, b;
+    mp_init_multi(&a, &b, NULL);
+
+    /* All ones makes every coefficient of the square as large as it gets */
+    mp_2expt(&a, DIGIT_BIT * 1500);
+    mp_sub_d(&a, 1, &a);
+    mp_sqr(&a, &b);
+
+    Bignum::ntt_multiply(&a, &a, &a);
+    TS_ASSERT_EQUALS(mp_cmp(&a, &b), MP_EQ);
+
+    mp_clear_multi(&a, &b, NULL);
+  }
+
+  void test_configure_multiply_only_once() {
+    int karatsuba = KARATSUBA_MUL_CUTOFF;
+    int toom = TOOM_MUL_CUTOFF;
+
+    std::istringstream stream;
+    stream.str("rbx.bignum.karatsuba_mul = 100\nrbx.bignum.toom_mul = 4\n");
+    ConfigParser config;
+    config.import_stream(stream);
+
+    Bignum::configure_multiply(&config);
+    TS_ASSERT_EQUALS(KARATSUBA_MUL_CUTOFF, 100);
+    TS_ASSERT_EQUALS(TOOM_MUL_CUTOFF, 16);
+
+    std::istringstream later;
+    later.str("rbx.bignum.karatsuba_mul = 200\n");
+    ConfigParser other;
+    other.import_stream(later);
+
+    Bignum::configure_multiply(&other);
+    TS_ASSERT_EQUALS(KARATSUBA_MUL_CUTOFF, 100);
+
+    KARATSUBA_MUL_CUTOFF = karatsuba;
+    TOOM_MUL_CUTOFF = toom;
+  }
+
+  void test_mul_large() {
+    std::string digits(20000, '7');
+    Integer* a = Bignum::from_string(state, digits.c_str(), 10);
+    Integer* b = as<Bignum>(a)->mul(state, as<Bignum>(a));
+
+    mp_int expected;
+    mp_init(&expected);
+    mp_sqr(as<Bignum>(a)->mp_val(), &expected);
+    TS_ASSERT_EQUALS(mp_cmp(as<Bignum>(b)->mp_val(), &expected), MP_EQ);
+    mp_clear(&expected);
+  }
+
   void test_size() {
     Object* s = b1->size(state);
     TS_ASSERT(s->fixnum_p());
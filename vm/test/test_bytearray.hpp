@@ -229,4 +229,14 @@ class TestByteArray : public CxxTest::TestSuite {
     TS_ASSERT_EQUALS(seven, (Fixnum*)a->locate(state, foo_nl, three));
     TS_ASSERT_EQUALS(Fixnum::from(10), (Fixnum*)a->locate(state, String::create(state, "yx"), three));
   }
+
+  void test_locate_long_pattern() {
+    ByteArray* a = String::create(state, "abcabcabdabcabcabcabd!")->data();
+    String* pat = String::create(state, "abcabcabd");
+
+    TS_ASSERT_EQUALS(Fixnum::from(9), (Fixnum*)a->locate(state, pat, Fixnum::from(0)));
+    TS_ASSERT_EQUALS(Fixnum::from(21), (Fixnum*)a->locate(state, pat, Fixnum::from(1)));
+    TS_ASSERT_EQUALS(Qnil, a->locate(state, pat, Fixnum::from(13)));
+    TS_ASSERT_EQUALS(Qnil, a->locate(state, String::create(state, "abcabcabe"), Fixnum::from(0)));
+  }
 };
@@ -178,7 +178,7 @@ class TestChannel : public CxxTest::TestSuite {
     chan->receive(state);
 
     gettimeofday(&finish, NULL);
-    TS_ASSERT(ret->nil_p());
+    TS_ASSERT(kind_of<Fixnum>(ret));
     TS_ASSERT_EQUALS(G(current_thread), orig);
     TS_ASSERT_EQUALS(done, stack[0]);
     compare_interval_in_range(start,finish,200000U,250000U);
@@ -199,9 +199,22 @@ class TestChannel : public CxxTest::TestSuite {
     chan->receive(state);
 
     gettimeofday(&finish, NULL);
-    TS_ASSERT(ret->nil_p());
+    TS_ASSERT(kind_of<Fixnum>(ret));
     TS_ASSERT_EQUALS(G(current_thread), orig);
     TS_ASSERT_EQUALS(done, stack[0]);
     compare_interval_in_range(start, finish, 201000U, 251000U);
   }
+
+  void test_cancel() {
+    Float* point_one = Float::create(state, 0.1);
+    Fixnum* id = as<Fixnum>(Channel::send_in_seconds(state, chan, point_one, Qtrue));
+    size_t events = state->events->num_of_events();
+
+    TS_ASSERT(Channel::cancel(state, id)->nil_p());
+    TS_ASSERT_EQUALS(state->events->num_of_events(), events - 1);
+
+    // Cancelling again is harmless.
+    Channel::cancel(state, id);
+    TS_ASSERT_EQUALS(state->events->num_of_events(), events - 1);
+  }
 };
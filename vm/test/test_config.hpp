@@ -55,6 +55,20 @@ class TestConfig : public CxxTest::TestSuite {
     TS_ASSERT(ent->is_number());
   }
 
+  void test_number() {
+    std::istringstream stream;
+
+    stream.str("rbx.blah = 8\nrbx.foo = fun\n");
+
+    ConfigParser cfg;
+
+    cfg.import_stream(stream);
+
+    TS_ASSERT_EQUALS(cfg.number("rbx.blah", 3), 8);
+    TS_ASSERT_EQUALS(cfg.number("rbx.foo", 3), 3);
+    TS_ASSERT_EQUALS(cfg.number("rbx.missing", 3), 3);
+  }
+
   void test_get_section() {
     std::istringstream stream;
 
@@ -1,11 +1,13 @@
 #include "event.hpp"
 #include "builtin/io.hpp"
+#include "builtin/string.hpp"
 
 #include "vm.hpp"
 #include "objectmemory.hpp"
 
 #include <unistd.h>
 #include <signal.h>
+#include <vector>
 #include <cxxtest/TestSuite.h>
 
 using namespace rubinius;
@@ -51,6 +53,82 @@ class TestEventLoop : public CxxTest::TestSuite {
     TS_ASSERT_EQUALS(chan.value, Qnil);
   }
 
+  void test_timer_tag() {
+    TestChannelObject chan(state);
+    TypedRoot<String*> tag(state, String::create(state, "done"));
+    event::Timer* timer = new event::Timer(state, &chan, 0.01, tag.get());
+
+    state->events->start(timer);
+
+    // The tag is a root, so it survives and follows a move.
+    state->om->collect_young(state->globals.roots);
+
+    state->events->run_and_wait();
+    TS_ASSERT(chan.called);
+    TS_ASSERT_EQUALS(chan.value, tag.get());
+  }
+
+  void test_timer_cancel() {
+    TestChannelObject chan(state);
+    event::Timer* timer = new event::Timer(state, &chan, 0.01);
+    size_t before = state->events->num_of_events();
+
+    state->events->start(timer);
+    TS_ASSERT_EQUALS(state->events->num_of_events(), before + 1);
+    TS_ASSERT_EQUALS(state->events->timers.size(), 1U);
+
+    state->events->clear_by_id(timer->id);
+    TS_ASSERT_EQUALS(state->events->num_of_events(), before);
+    TS_ASSERT_EQUALS(state->events->timers.size(), 0U);
+
+    usleep(20000);
+    state->events->poll();
+    TS_ASSERT(!chan.called);
+  }
+
+  void test_timers_fire_in_order() {
+    TestChannelObject late(state);
+    TestChannelObject early(state);
+
+    state->events->start(new event::Timer(state, &late, 0.05));
+    state->events->start(new event::Timer(state, &early, 0.01));
+
+    state->events->run_and_wait();
+    TS_ASSERT(early.called);
+    TS_ASSERT(!late.called);
+
+    state->events->run_and_wait();
+    TS_ASSERT(late.called);
+    TS_ASSERT_EQUALS(state->events->timers.size(), 0U);
+  }
+
+  void test_many_timers() {
+    const size_t count = 2000;
+    TestChannelObject chan(state);
+    TestChannelObject last(state);
+    std::vector<event::Timer*> timers;
+
+    // Spread past one turn of the wheel.
+    for(size_t i = 0; i < count; i++) {
+      event::Timer* timer = new event::Timer(state, &chan, 1.0 + i * 0.001);
+      state->events->start(timer);
+      timers.push_back(timer);
+    }
+
+    TS_ASSERT_EQUALS(state->events->timers.size(), count);
+
+    for(size_t i = 0; i < count; i++) {
+      state->events->clear_by_id(timers[i]->id);
+    }
+
+    TS_ASSERT_EQUALS(state->events->timers.size(), 0U);
+
+    state->events->start(new event::Timer(state, &last, 0.01));
+    state->events->run_and_wait();
+    TS_ASSERT(last.called);
+    TS_ASSERT(!chan.called);
+  }
+
   void test_io_read() {
     int fds[2];
     TS_ASSERT(!pipe(fds));
@@ -106,6 +184,29 @@ class TestEventLoop : public CxxTest::TestSuite {
     close(fds[1]);
   }
 
+  void test_io_read_into_string() {
+    int fds[2];
+    TS_ASSERT(!pipe(fds));
+
+    TestChannelObject chan(state);
+    event::Read* read = new event::Read(state, &chan, fds[0]);
+
+    String* str = String::create(state, Fixnum::from(8));
+    read->into_buffer(str, 8);
+
+    state->events->start(read);
+    TS_ASSERT_EQUALS(write(fds[1], "abc", 3), 3);
+    state->events->poll();
+
+    TS_ASSERT(chan.called);
+    TS_ASSERT_EQUALS(chan.value, Fixnum::from(3));
+    TS_ASSERT_EQUALS(str->size(), 3U);
+    TS_ASSERT_SAME_DATA(str->byte_address(), "abc\0", 4);
+
+    close(fds[0]);
+    close(fds[1]);
+  }
+
   void test_signal() {
     event::Loop loop(ev_default_loop(0));
     TestChannelObject chan(state);
@@ -25,12 +25,60 @@ class TestFloat : public CxxTest::TestSuite {
   }
 
   void check_float(Float* f, Float* g) {
-    TS_ASSERT_DELTA(f->val, g->val, TOLERANCE);
+    TS_ASSERT_DELTA(f->val(), g->val(), TOLERANCE);
   }
 
   void test_create() {
     Float* flt = Float::create(state, 1.0);
-    TS_ASSERT_EQUALS(flt->val, 1.0);
+    TS_ASSERT_EQUALS(flt->val(), 1.0);
+  }
+
+  void test_create_flonum() {
+#ifdef RBX_FLONUM
+    double values[] = { 1.0, -1.0, 0.0, 0.5, 3.14159, -2.5e-30, 1.7e38,
+                        1.0 / 3.0, ldexp(1.0, -126), ldexp(1.0, 128) };
+
+    for(size_t i = 0; i < sizeof(values) / sizeof(double); i++) {
+      Float* flt = Float::create(state, values[i]);
+      TS_ASSERT(FLONUM_P(flt));
+      TS_ASSERT(kind_of<Float>(flt));
+      TS_ASSERT_EQUALS(flt->val(), values[i]);
+      TS_ASSERT_EQUALS(flt->class_object(state), G(floatpoint));
+      TS_ASSERT_EQUALS(flt->get_type(), FloatType);
+    }
+#endif
+  }
+
+  void test_create_boxed() {
+    double zero = 0.0;
+    double values[] = { -0.0, 1.0 / zero, -1.0 / zero, 1e300, -1e-300,
+                        ldexp(1.0, -128), ldexp(1.0, 129), ldexp(1.0, -511) };
+
+    for(size_t i = 0; i < sizeof(values) / sizeof(double); i++) {
+      Float* flt = Float::create(state, values[i]);
+      TS_ASSERT(flt->reference_p());
+      TS_ASSERT(kind_of<Float>(flt));
+      TS_ASSERT_EQUALS(flt->val(), values[i]);
+      TS_ASSERT_EQUALS(flt->class_object(state), G(floatpoint));
+    }
+
+    Float* nan = Float::create(state, zero / zero);
+    TS_ASSERT(nan->reference_p());
+    TS_ASSERT(std::isnan(nan->val()));
+  }
+
+  void test_add_does_not_allocate() {
+#ifdef RBX_FLONUM
+    Float* f = Float::create(state, 0.25);
+    size_t used = state->om->young.current->used();
+
+    for(int i = 0; i < 100; i++) {
+      f = f->add(state, Float::create(state, 0.5));
+    }
+
+    TS_ASSERT_EQUALS(f->val(), 50.25);
+    TS_ASSERT_EQUALS(state->om->young.current->used(), used);
+#endif
   }
 
   void test_coerce() {
@@ -45,7 +93,7 @@ class TestFloat : public CxxTest::TestSuite {
     String* str = String::create(state, "blah");
     Float* coercedStr = Float::coerce(state, str);
     TS_ASSERT(kind_of<Float>(coercedStr));
-    TS_ASSERT_EQUALS(coercedStr->val, 0.0);
+    TS_ASSERT_EQUALS(coercedStr->val(), 0.0);
   }
 
   void test_add() {
@@ -0,0 +1,235 @@
+#include "vm.hpp"
+#include "vmmethod.hpp"
+#include "instruction_stats.hpp"
+
+#include "builtin/class.hpp"
+#include "builtin/compiledmethod.hpp"
+#include "builtin/contexts.hpp"
+#include "builtin/iseq.hpp"
+#include "builtin/lookuptable.hpp"
+#include "builtin/sendsite.hpp"
+#include "builtin/staticscope.hpp"
+#include "builtin/string.hpp"
+#include "builtin/task.hpp"
+#include "builtin/tuple.hpp"
+
+#include "message.hpp"
+
+#include <cxxtest/TestSuite.h>
+
+#include <sstream>
+
+using namespace rubinius;
+
+class TestInstructionStats : public CxxTest::TestSuite {
+  public:
+
+  VM* state;
+
+  void setUp() {
+    state = new VM();
+  }
+
+  void tearDown() {
+    delete state;
+  }
+
+  CompiledMethod* create_cm(const char* name) {
+    CompiledMethod* cm = CompiledMethod::create(state);
+    InstructionSequence* iseq = InstructionSequence::create(state, 1);
+    iseq->opcodes()->put(state, 0, Fixnum::from(InstructionSequence::insn_push_nil));
+
+    cm->iseq(state, iseq);
+    cm->name(state, state->symbol(name));
+    cm->file(state, state->symbol("blah.rb"));
+    cm->scope(state, StaticScope::create(state));
+    cm->scope()->module(state, G(object));
+    return cm;
+  }
+
+  void test_record() {
+    InstructionStats stats;
+    VMMethod vmm(state, create_cm("blah"));
+    size_t method = stats.method_index(state, &vmm);
+
+    stats.record(InstructionStats::cNoPrevious, InstructionSequence::insn_push_nil, method);
+    stats.record(InstructionSequence::insn_push_nil, InstructionSequence::insn_pop, method);
+    stats.record(InstructionSequence::insn_pop, InstructionSequence::insn_push_nil, method);
+    stats.record(InstructionSequence::insn_push_nil, InstructionSequence::insn_pop, method);
+
+    TS_ASSERT_EQUALS(stats.count(InstructionSequence::insn_push_nil), 2ULL);
+    TS_ASSERT_EQUALS(stats.count(InstructionSequence::insn_pop), 2ULL);
+    TS_ASSERT_EQUALS(stats.pair_count(InstructionSequence::insn_push_nil,
+                                      InstructionSequence::insn_pop), 2ULL);
+    TS_ASSERT_EQUALS(stats.pair_count(InstructionSequence::insn_pop,
+                                      InstructionSequence::insn_push_nil), 1ULL);
+    TS_ASSERT_EQUALS(stats.pair_count(InstructionSequence::insn_noop,
+                                      InstructionSequence::insn_push_nil), 0ULL);
+    TS_ASSERT_EQUALS(stats.method(method).count, 4ULL);
+  }
+
+  void test_method_index_is_cached_per_stats() {
+    InstructionStats stats;
+    VMMethod vmm(state, create_cm("blah"));
+    VMMethod vmm2(state, create_cm("foo"));
+
+    TS_ASSERT_EQUALS(stats.method_index(state, &vmm), 0U);
+    TS_ASSERT_EQUALS(stats.method_index(state, &vmm2), 1U);
+    TS_ASSERT_EQUALS(stats.method_index(state, &vmm), 0U);
+    TS_ASSERT_EQUALS(stats.number_of_methods(), 2U);
+    TS_ASSERT_EQUALS(stats.method(0).name, std::string("Object#blah"));
+
+    InstructionStats stats2;
+    TS_ASSERT_EQUALS(stats2.method_index(state, &vmm2), 0U);
+    TS_ASSERT_EQUALS(stats2.number_of_methods(), 1U);
+  }
+
+  void test_print_csv() {
+    InstructionStats stats;
+    VMMethod vmm(state, create_cm("blah"));
+    size_t method = stats.method_index(state, &vmm);
+
+    stats.record(InstructionStats::cNoPrevious, InstructionSequence::insn_push_nil, method);
+    stats.record(InstructionSequence::insn_push_nil, InstructionSequence::insn_pop, method);
+
+    std::stringstream stream;
+    stats.print_csv(stream);
+    std::string csv = stream.str();
+
+    TS_ASSERT_EQUALS(csv.find("kind,name,detail,count\n"), 0U);
+    TS_ASSERT(csv.find("\ninstruction,push_nil,,1\n") != std::string::npos);
+    TS_ASSERT(csv.find("\npair,push_nil,pop,1\n") != std::string::npos);
+    TS_ASSERT(csv.find("\nmethod,Object#blah,blah.rb:-1,2\n") != std::string::npos);
+  }
+
+  void test_no_pairs_across_a_send() {
+    // nil; nil
+    CompiledMethod* callee = create_cm("callee");
+    InstructionSequence* callee_iseq = InstructionSequence::create(state, 2);
+    callee_iseq->opcodes()->put(state, 0, Fixnum::from(InstructionSequence::insn_push_nil));
+    callee_iseq->opcodes()->put(state, 1, Fixnum::from(InstructionSequence::insn_ret));
+    callee->iseq(state, callee_iseq);
+    callee->stack_size(state, Fixnum::from(1));
+    callee->total_args(state, Fixnum::from(0));
+    callee->required_args(state, callee->total_args());
+    callee->formalize(state);
+    G(true_class)->method_table()->store(state, state->symbol("callee"), callee);
+
+    // true.callee; nil
+    CompiledMethod* cm = create_cm("caller");
+    InstructionSequence* iseq = InstructionSequence::create(state, 7);
+    Tuple* ops = iseq->opcodes();
+    ops->put(state, 0, Fixnum::from(InstructionSequence::insn_push_self));
+    ops->put(state, 1, Fixnum::from(InstructionSequence::insn_send_stack));
+    ops->put(state, 2, Fixnum::from(0));
+    ops->put(state, 3, Fixnum::from(0));
+    ops->put(state, 4, Fixnum::from(InstructionSequence::insn_pop));
+    ops->put(state, 5, Fixnum::from(InstructionSequence::insn_push_nil));
+    ops->put(state, 6, Fixnum::from(InstructionSequence::insn_ret));
+
+    Tuple* literals = Tuple::create(state, 1);
+    literals->put(state, 0, SendSite::create(state, state->symbol("callee")));
+
+    cm->iseq(state, iseq);
+    cm->literals(state, literals);
+    cm->stack_size(state, Fixnum::from(10));
+    cm->total_args(state, Fixnum::from(0));
+    cm->required_args(state, cm->total_args());
+    cm->formalize(state);
+    G(true_class)->method_table()->store(state, state->symbol("caller"), cm);
+
+    Task* task = Task::create(state);
+
+    Message msg(state);
+    msg.recv = Qtrue;
+    msg.lookup_from = G(true_class);
+    msg.name = state->symbol("caller");
+    msg.send_site = SendSite::create(state, state->symbol("caller"));
+    msg.use_from_task(task, 0);
+    task->send_message(msg);
+
+    InstructionStats* stats = new InstructionStats();
+    state->instruction_stats = stats;
+
+    MethodContext* ctx = task->active();
+    ctx->vmm->resume(task, ctx);                      // up to the send
+    task->active()->vmm->resume(task, task->active()); // the callee
+    TS_ASSERT_EQUALS(task->active(), ctx);
+    ctx->vmm->resume(task, ctx);                      // after the send
+
+    TS_ASSERT_EQUALS(stats->count(InstructionSequence::insn_push_nil), 2ULL);
+    TS_ASSERT_EQUALS(stats->pair_count(InstructionSequence::insn_push_self,
+                                       InstructionSequence::insn_send_stack), 1ULL);
+    TS_ASSERT_EQUALS(stats->pair_count(InstructionSequence::insn_push_nil,
+                                       InstructionSequence::insn_ret), 2ULL);
+
+    TS_ASSERT_EQUALS(stats->pair_count(InstructionSequence::insn_noop,
+                                       InstructionSequence::insn_push_self), 0ULL);
+    TS_ASSERT_EQUALS(stats->pair_count(InstructionSequence::insn_send_stack,
+                                       InstructionSequence::insn_push_nil), 0ULL);
+    TS_ASSERT_EQUALS(stats->pair_count(InstructionSequence::insn_ret,
+                                       InstructionSequence::insn_pop), 0ULL);
+
+    state->instruction_stats = NULL;
+    delete stats;
+  }
+
+  void test_stopping_from_counted_code() {
+    CompiledMethod* stop = CompiledMethod::create(state);
+    stop->iseq(state, InstructionSequence::create(state, 1));
+    stop->iseq()->opcodes()->put(state, 0, Fixnum::from(InstructionSequence::insn_ret));
+    stop->primitive(state, state->symbol("vm_stop_instruction_stats"));
+    stop->stack_size(state, Fixnum::from(1));
+    stop->total_args(state, Fixnum::from(1));
+    stop->required_args(state, stop->total_args());
+    stop->formalize(state);
+    G(true_class)->method_table()->store(state, state->symbol("stop"), stop);
+
+    // true.stop("/dev/null"); nil
+    CompiledMethod* cm = create_cm("counted");
+    InstructionSequence* iseq = InstructionSequence::create(state, 9);
+    Tuple* ops = iseq->opcodes();
+    ops->put(state, 0, Fixnum::from(InstructionSequence::insn_push_self));
+    ops->put(state, 1, Fixnum::from(InstructionSequence::insn_push_literal));
+    ops->put(state, 2, Fixnum::from(0));
+    ops->put(state, 3, Fixnum::from(InstructionSequence::insn_send_stack));
+    ops->put(state, 4, Fixnum::from(1));
+    ops->put(state, 5, Fixnum::from(1));
+    ops->put(state, 6, Fixnum::from(InstructionSequence::insn_pop));
+    ops->put(state, 7, Fixnum::from(InstructionSequence::insn_push_nil));
+    ops->put(state, 8, Fixnum::from(InstructionSequence::insn_ret));
+
+    Tuple* literals = Tuple::create(state, 2);
+    literals->put(state, 0, String::create(state, "/dev/null"));
+    literals->put(state, 1, SendSite::create(state, state->symbol("stop")));
+
+    cm->iseq(state, iseq);
+    cm->literals(state, literals);
+    cm->stack_size(state, Fixnum::from(10));
+    cm->total_args(state, Fixnum::from(0));
+    cm->required_args(state, cm->total_args());
+    cm->formalize(state);
+    G(true_class)->method_table()->store(state, state->symbol("counted"), cm);
+
+    Task* task = Task::create(state);
+
+    Message msg(state);
+    msg.recv = Qtrue;
+    msg.lookup_from = G(true_class);
+    msg.name = state->symbol("counted");
+    msg.send_site = SendSite::create(state, state->symbol("counted"));
+    msg.use_from_task(task, 0);
+    task->send_message(msg);
+
+    state->instruction_stats = new InstructionStats();
+
+    MethodContext* ctx = task->active();
+    ctx->vmm->resume(task, ctx);
+
+    // The stats are gone, so counting stops right after the send.
+    TS_ASSERT_EQUALS(state->instruction_stats, (InstructionStats*)NULL);
+    TS_ASSERT_EQUALS(task->active(), ctx);
+    TS_ASSERT_EQUALS(ctx->ip, 6);
+    TS_ASSERT(kind_of<String>(ctx->top()));
+  }
+};
@@ -1,4 +1,5 @@
 #include "builtin/io.hpp"
+#include "builtin/array.hpp"
 #include "builtin/string.hpp"
 
 #include <cstdio>
@@ -133,6 +134,130 @@ class TestIO : public CxxTest::TestSuite {
     TS_ASSERT_SAME_DATA(buf, "abdc", 4);
   }
 
+  void test_write_vector() {
+    char buf[9];
+
+    Array* ary = Array::create(state, 3);
+    ary->set(state, 0, String::create(state, "abc"));
+    ary->set(state, 1, String::create(state, ""));
+    ary->set(state, 2, String::create(state, "defghi"));
+
+    TS_ASSERT_EQUALS(Fixnum::from(9), io->write_vector(state, ary, Fixnum::from(0)));
+
+    lseek(fd, 0, SEEK_SET);
+    TS_ASSERT_EQUALS(::read(fd, buf, 9U), 9);
+    TS_ASSERT_SAME_DATA(buf, "abcdefghi", 9);
+  }
+
+  void test_write_vector_with_offset() {
+    char buf[5];
+
+    Array* ary = Array::create(state, 2);
+    ary->set(state, 0, String::create(state, "abc"));
+    ary->set(state, 1, String::create(state, "defghi"));
+
+    TS_ASSERT_EQUALS(Fixnum::from(5), io->write_vector(state, ary, Fixnum::from(4)));
+    TS_ASSERT_EQUALS(Fixnum::from(0), io->write_vector(state, ary, Fixnum::from(9)));
+
+    lseek(fd, 0, SEEK_SET);
+    TS_ASSERT_EQUALS(::read(fd, buf, 5U), 5);
+    TS_ASSERT_SAME_DATA(buf, "efghi", 5);
+  }
+
+  void test_copy_to() {
+    char buf[6];
+    int src_fd = make_io();
+    IO* src = IO::create(state, src_fd);
+
+    TS_ASSERT_EQUALS(::write(src_fd, "abcdef", 6), 6);
+
+    TS_ASSERT_EQUALS(Fixnum::from(3), src->copy_to(state, io, Fixnum::from(3), Fixnum::from(2)));
+    TS_ASSERT_EQUALS(Fixnum::from(1), src->copy_to(state, io, Fixnum::from(10), Fixnum::from(5)));
+    TS_ASSERT_EQUALS(Fixnum::from(0), src->copy_to(state, io, Fixnum::from(10), Fixnum::from(6)));
+
+    lseek(fd, 0, SEEK_SET);
+    TS_ASSERT_EQUALS(::read(fd, buf, 6U), 4);
+    TS_ASSERT_SAME_DATA(buf, "cdef", 4);
+
+    remove_io(src_fd);
+  }
+
+  void test_copy_to_from_pipe() {
+    char buf[3];
+    int fds[2];
+    TS_ASSERT(!pipe(fds));
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+
+    IO* src = IO::create(state, fds[0]);
+    TS_ASSERT_EQUALS(Qfalse, src->copy_to(state, io, Fixnum::from(3), Qnil));
+
+    TS_ASSERT_EQUALS(::write(fds[1], "xyz", 3), 3);
+    TS_ASSERT_EQUALS(Fixnum::from(3), src->copy_to(state, io, Fixnum::from(3), Qnil));
+
+    lseek(fd, 0, SEEK_SET);
+    TS_ASSERT_EQUALS(::read(fd, buf, 3U), 3);
+    TS_ASSERT_SAME_DATA(buf, "xyz", 3);
+
+    close(fds[0]);
+    close(fds[1]);
+  }
+
+  void test_copy_to_full_pipe_from_pipe() {
+    int src_fds[2], dst_fds[2];
+    TS_ASSERT(!pipe(src_fds));
+    TS_ASSERT(!pipe(dst_fds));
+    fcntl(src_fds[0], F_SETFL, fcntl(src_fds[0], F_GETFL) | O_NONBLOCK);
+    fcntl(dst_fds[1], F_SETFL, fcntl(dst_fds[1], F_GETFL) | O_NONBLOCK);
+
+    while(::write(dst_fds[1], "-", 1) == 1);
+    TS_ASSERT_EQUALS(::write(src_fds[1], "xyz", 3), 3);
+
+    IO* src = IO::create(state, src_fds[0]);
+    IO* dst = IO::create(state, dst_fds[1]);
+    Object* ret = src->copy_to(state, dst, Fixnum::from(3), Qnil);
+
+    // Without sendfile the bytes already read out of the pipe come back
+    // rather than waiting on dst.
+    if(Array* partial = try_as<Array>(ret)) {
+      TS_ASSERT_EQUALS(Fixnum::from(0), partial->get(state, 0));
+      String* rest = as<String>(partial->get(state, 1));
+      TS_ASSERT_EQUALS(3U, rest->size());
+      TS_ASSERT_SAME_DATA("xyz", rest->byte_address(), 3);
+    } else {
+      TS_ASSERT_EQUALS(Qnil, ret);
+    }
+
+    close(src_fds[0]);
+    close(src_fds[1]);
+    close(dst_fds[0]);
+    close(dst_fds[1]);
+  }
+
+  void test_blocking_read() {
+    int fds[2];
+    TS_ASSERT(!pipe(fds));
+
+    IO* pipe_io = IO::create(state, fds[0]);
+    TS_ASSERT_EQUALS(Qfalse, pipe_io->blocking_read(state, Fixnum::from(4)));
+
+    TS_ASSERT_EQUALS(::write(fds[1], "ab", 2), 2);
+    String* str = as<String>(pipe_io->blocking_read(state, Fixnum::from(4)));
+    TS_ASSERT_EQUALS(2U, str->size());
+    TS_ASSERT_SAME_DATA("ab", str->byte_address(), 2);
+
+    close(fds[1]);
+    TS_ASSERT_EQUALS(Qnil, pipe_io->blocking_read(state, Fixnum::from(4)));
+
+    close(fds[0]);
+  }
+
+  void test_blocking_read_closed() {
+    io->descriptor(state, Fixnum::from(-1));
+    TS_ASSERT_THROWS_ASSERT(io->blocking_read(state, Fixnum::from(4)),
+        const RubyException &e,
+        TS_ASSERT(Exception::io_error_p(state, e.exception)));
+  }
+
   void test_query() {
     TS_ASSERT_EQUALS(Qnil, io->query(state, state->symbol("unknown")));
 
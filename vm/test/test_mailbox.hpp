@@ -0,0 +1,134 @@
+#include "vm.hpp"
+#include "event.hpp"
+#include "mailbox.hpp"
+#include "virtual.hpp"
+#include "environment.hpp"
+#include "sampler.hpp"
+
+#include "builtin/array.hpp"
+#include "builtin/exception.hpp"
+#include "builtin/fixnum.hpp"
+#include "builtin/string.hpp"
+#include "builtin/system.hpp"
+
+#include <pthread.h>
+#include <cxxtest/TestSuite.h>
+
+using namespace rubinius;
+
+class TestMailboxCallback : public ObjectCallback {
+public:
+  size_t calls;
+  Object* value;
+
+  TestMailboxCallback(STATE) : ObjectCallback(state), calls(0), value(Qnil) { }
+
+  virtual void call(Object* obj) {
+    calls++;
+    value = obj;
+  }
+};
+
+static void* current_state_on_thread(void* arg) {
+  VM* state = new VM();
+  bool registered = VM::current_state() == state;
+  delete state;
+
+  *static_cast<bool*>(arg) = registered;
+  return NULL;
+}
+
+class TestMailbox : public CxxTest::TestSuite {
+  public:
+
+  VM* state;
+  VM* other;
+
+  void setUp() {
+    state = new VM();
+    other = new VM();
+  }
+
+  void tearDown() {
+    delete other;
+    delete state;
+  }
+
+  void test_vms_have_their_own_mailbox() {
+    TS_ASSERT(state->mailbox->id() != other->mailbox->id());
+  }
+
+  void test_only_one_vm_owns_the_default_loop() {
+    TS_ASSERT(state->owns_default_loop);
+    TS_ASSERT(!other->owns_default_loop);
+    TS_ASSERT(state->events->base != other->events->base);
+  }
+
+  void test_send_copies_the_message() {
+    String* str = String::create(state, "hello");
+    Array* ary = Array::create(state, 2);
+    ary->set(state, 0, Fixnum::from(1));
+    ary->set(state, 1, str);
+
+    TS_ASSERT(Mailbox::send(state, other->mailbox->id(), ary));
+    TS_ASSERT_EQUALS(other->mailbox->size(), 1U);
+
+    Array* copy = as<Array>(other->mailbox->receive(other));
+    TS_ASSERT(copy != ary);
+    TS_ASSERT_EQUALS(copy->get(other, 0), Fixnum::from(1));
+
+    String* str_copy = as<String>(copy->get(other, 1));
+    TS_ASSERT(str_copy != str);
+    TS_ASSERT_EQUALS(std::string(str_copy->c_str()), "hello");
+
+    TS_ASSERT_EQUALS(other->mailbox->receive(other), (Object*)NULL);
+  }
+
+  void test_send_to_unknown_mailbox() {
+    TS_ASSERT(!Mailbox::send(state, 0, Qnil));
+  }
+
+  void test_send_rejects_what_cannot_be_copied() {
+    TS_ASSERT_THROWS(Mailbox::send(state, other->mailbox->id(), G(object)),
+                     const RubyException &);
+    TS_ASSERT_EQUALS(other->mailbox->size(), 0U);
+  }
+
+  void test_listen() {
+    TestMailboxCallback* cb = new TestMailboxCallback(other);
+
+    Mailbox::send(state, other->mailbox->id(), Fixnum::from(1));
+    other->mailbox->listen(other, cb);
+
+    Mailbox::send(state, other->mailbox->id(), Fixnum::from(2));
+    other->events->poll();
+
+    TS_ASSERT_EQUALS(cb->calls, 2U);
+    TS_ASSERT_EQUALS(cb->value, Fixnum::from(2));
+    TS_ASSERT_EQUALS(other->mailbox->size(), 0U);
+  }
+
+  void test_join_unknown_vm() {
+    TestMailboxCallback* cb = new TestMailboxCallback(state);
+    TS_ASSERT_EQUALS(Environment::join(state, 12345, cb), 0U);
+  }
+
+  void test_sampler_only_runs_in_the_default_vm() {
+    TS_ASSERT_EQUALS(reinterpret_cast<Object*>(kPrimitiveFailed),
+        System::sampler_activate(other, Fixnum::from(100)));
+    TS_ASSERT(!other->sampler);
+  }
+
+  void test_current_state_is_per_native_thread() {
+    bool registered = false;
+    pthread_t thread;
+
+    VM* before = VM::current_state();
+
+    TS_ASSERT_EQUALS(pthread_create(&thread, NULL, current_state_on_thread, &registered), 0);
+    pthread_join(thread, NULL);
+
+    TS_ASSERT(registered);
+    TS_ASSERT_EQUALS(VM::current_state(), before);
+  }
+};
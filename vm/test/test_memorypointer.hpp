@@ -109,7 +109,7 @@ class TestMemoryPointer : public CxxTest::TestSuite {
     double one = 1.0;
     MemoryPointer* ptr = MemoryPointer::create(state, &one);
     Float* f = ptr->read_float(state);
-    TS_ASSERT_EQUALS(1.0, f->val);
+    TS_ASSERT_EQUALS(1.0, f->val());
   }
 
   void test_write_float() {
@@ -117,7 +117,7 @@ class TestMemoryPointer : public CxxTest::TestSuite {
     MemoryPointer* ptr = MemoryPointer::create(state, &one);
     ptr->write_float(state, Float::create(state, 2.0));
     Float* f = ptr->read_float(state);
-    TS_ASSERT_EQUALS(2.0, f->val);
+    TS_ASSERT_EQUALS(2.0, f->val());
   }
 
   void test_read_pointer() {
@@ -225,7 +225,7 @@ class TestMemoryPointer : public CxxTest::TestSuite {
     MemoryPointer* ptr = MemoryPointer::create(state, &one);
     Object* obj = ptr->get_field(state, 0, RBX_FFI_TYPE_FLOAT);
 
-    TS_ASSERT(obj->check_type(FloatType));
+    TS_ASSERT(kind_of<Float>(obj));
     TS_ASSERT_EQUALS(as<Float>(obj)->to_double(state), 1.0);
   }
 
@@ -234,7 +234,7 @@ class TestMemoryPointer : public CxxTest::TestSuite {
     MemoryPointer* ptr = MemoryPointer::create(state, &one);
     Object* obj = ptr->get_field(state, 0, RBX_FFI_TYPE_DOUBLE);
 
-    TS_ASSERT(obj->check_type(FloatType));
+    TS_ASSERT(kind_of<Float>(obj));
     TS_ASSERT_EQUALS(as<Float>(obj)->to_double(state), 1.0);
   }
 
@@ -0,0 +1,111 @@
+#include "vm.hpp"
+#include "objectmemory.hpp"
+#include "metrics.hpp"
+
+#include "builtin/array.hpp"
+#include "builtin/fixnum.hpp"
+#include "builtin/lookuptable.hpp"
+
+#include <cxxtest/TestSuite.h>
+
+#include <sstream>
+
+using namespace rubinius;
+
+class TestMetrics : public CxxTest::TestSuite {
+  public:
+
+  VM* state;
+
+  void setUp() {
+    state = new VM();
+  }
+
+  void tearDown() {
+    delete state;
+  }
+
+  LookupTable* section(LookupTable* tbl, const char* name) {
+    return as<LookupTable>(tbl->fetch(state, state->symbol(name)));
+  }
+
+  void test_bucket_for() {
+    TS_ASSERT_EQUALS(metrics::Histogram::bucket_for(0), 0U);
+    TS_ASSERT_EQUALS(metrics::Histogram::bucket_for(1), 1U);
+    TS_ASSERT_EQUALS(metrics::Histogram::bucket_for(2), 2U);
+    TS_ASSERT_EQUALS(metrics::Histogram::bucket_for(3), 2U);
+    TS_ASSERT_EQUALS(metrics::Histogram::bucket_for(1024), 11U);
+    TS_ASSERT_EQUALS(metrics::Histogram::bucket_for(~0ULL),
+                     metrics::Histogram::cBuckets - 1);
+  }
+
+  void test_histogram_record() {
+    metrics::Histogram hist;
+
+    hist.record(3);
+    hist.record(2);
+    hist.record(100);
+
+    TS_ASSERT_EQUALS(hist.count(), 3ULL);
+    TS_ASSERT_EQUALS(hist.total(), 105ULL);
+    TS_ASSERT_EQUALS(hist.max(), 100ULL);
+    TS_ASSERT_EQUALS(hist.bucket(2), 2ULL);
+    TS_ASSERT_EQUALS(hist.bucket(7), 1ULL);
+  }
+
+  void test_histogram_to_lookup_table() {
+    metrics::Histogram hist;
+    hist.record(5);
+
+    LookupTable* tbl = hist.to_lookup_table(state);
+    TS_ASSERT_EQUALS(tbl->fetch(state, state->symbol("count")), Fixnum::from(1));
+    TS_ASSERT_EQUALS(tbl->fetch(state, state->symbol("max")), Fixnum::from(5));
+
+    Array* buckets = as<Array>(tbl->fetch(state, state->symbol("buckets")));
+    TS_ASSERT_EQUALS(buckets->size(), 4U);
+    TS_ASSERT_EQUALS(buckets->get(state, 3), Fixnum::from(1));
+  }
+
+  void test_collections_are_counted() {
+    state->metrics.clear();
+
+    state->om->collect_young(state->globals.roots);
+    state->om->collect_young(state->globals.roots);
+    state->om->collect_mature(state->globals.roots);
+
+    TS_ASSERT_EQUALS(state->metrics.young_collections, 2ULL);
+    TS_ASSERT_EQUALS(state->metrics.young_pause_us.count(), 2ULL);
+    TS_ASSERT_EQUALS(state->metrics.mature_collections, 1ULL);
+    TS_ASSERT_EQUALS(state->metrics.mature_pause_us.count(), 1ULL);
+  }
+
+  void test_to_lookup_table() {
+    state->metrics.clear();
+    state->metrics.thread_switches = 3;
+    state->om->collect_young(state->globals.roots);
+
+    LookupTable* tbl = state->metrics.to_lookup_table(state);
+
+    LookupTable* gc = section(tbl, "gc");
+    TS_ASSERT_EQUALS(gc->fetch(state, state->symbol("young_collections")),
+                     Fixnum::from(1));
+    TS_ASSERT(kind_of<LookupTable>(gc->fetch(state, state->symbol("young_pause_us"))));
+
+    LookupTable* scheduler = section(tbl, "scheduler");
+    TS_ASSERT_EQUALS(scheduler->fetch(state, state->symbol("thread_switches")),
+                     Fixnum::from(3));
+
+    LookupTable* memory = section(tbl, "memory");
+    TS_ASSERT(kind_of<Integer>(memory->fetch(state, state->symbol("young_bytes_used"))));
+  }
+
+  void test_print() {
+    state->metrics.clear();
+    state->metrics.send_site_hits = 7;
+
+    std::stringstream stream;
+    state->metrics.print(state, stream);
+
+    TS_ASSERT(stream.str().find("dispatch.send_site_hits: 7\n") != std::string::npos);
+  }
+};
@@ -488,8 +488,8 @@ class TestNativeFunction : public CxxTest::TestSuite {
     Object* out = func->call(state, msg);
 
     TS_ASSERT(kind_of<Float>(out));
-    TS_ASSERT(as<Float>(out)->val > 13.19);
-    TS_ASSERT(as<Float>(out)->val < 13.21);
+    TS_ASSERT(as<Float>(out)->val() > 13.19);
+    TS_ASSERT(as<Float>(out)->val() < 13.21);
   }
 
   void test_bind_with_double() {
@@ -513,7 +513,7 @@ class TestNativeFunction : public CxxTest::TestSuite {
     Object* out = func->call(state, msg);
 
     TS_ASSERT(kind_of<Float>(out));
-    TS_ASSERT_EQUALS(as<Float>(out)->val, 13.2);
+    TS_ASSERT_EQUALS(as<Float>(out)->val(), 13.2);
   }
 
   void test_bind_with_string_returned() {
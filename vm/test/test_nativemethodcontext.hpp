@@ -1,11 +1,20 @@
+#include "builtin/array.hpp"
 #include "builtin/nativemethodcontext.hpp"
+#include "builtin/string.hpp"
 #include "vm.hpp"
 #include "objectmemory.hpp"
+#include "message.hpp"
 
+#include <pthread.h>
 #include <cxxtest/TestSuite.h>
 
 using namespace rubinius;
 
+static void* global_handles_on_thread(void* arg) {
+  *static_cast<HandleStorage**>(arg) = &NativeMethodContext::global_handles();
+  return NULL;
+}
+
 class TestNativeMethodContext : public CxxTest::TestSuite {
   public:
 
@@ -21,4 +30,128 @@ class TestNativeMethodContext : public CxxTest::TestSuite {
   void test_nativemethodcontext_fields() {
     TS_ASSERT_EQUALS(0U, NativeMethodContext::fields);
   }
+
+  void test_global_handles_are_per_native_thread() {
+    HandleStorage* other = NULL;
+    pthread_t thread;
+
+    TS_ASSERT_EQUALS(pthread_create(&thread, NULL, global_handles_on_thread, &other), 0);
+    pthread_join(thread, NULL);
+
+    TS_ASSERT(other != NULL);
+    TS_ASSERT(other != &NativeMethodContext::global_handles());
+  }
+
+  void test_release_frame_reuses_stack_and_handles() {
+    Task* task = Task::create(state);
+    Message msg(state);
+    msg.recv = Qnil;
+    msg.module = G(object);
+    msg.name = state->symbol("blah");
+
+    NativeMethodContext* first = NativeMethodContext::create(state, &msg, task);
+    void* stack = first->stack();
+
+    first->handle_for(Fixnum::from(1));
+    TS_ASSERT_EQUALS(5U, first->handles().size());
+
+    first->release_frame();
+    TS_ASSERT_EQUALS(static_cast<void*>(NULL), first->stack());
+
+    /* A second release is harmless. */
+    first->release_frame();
+
+    NativeMethodContext* second = NativeMethodContext::create(state, &msg, task);
+    TS_ASSERT_EQUALS(stack, second->stack());
+    TS_ASSERT_EQUALS(NativeMethodContext::BASIC_HANDLES, second->handles().size());
+    TS_ASSERT_EQUALS(Qnil, second->object_from(2));
+
+    second->release_frame();
+  }
+
+  NativeMethodContext* new_context() {
+    Task* task = Task::create(state);
+    Message msg(state);
+    msg.recv = Qnil;
+    msg.module = G(object);
+    msg.name = state->symbol("blah");
+
+    return NativeMethodContext::create(state, &msg, task);
+  }
+
+  void test_handle_for_special_objects() {
+    NativeMethodContext* nmc = new_context();
+
+    TS_ASSERT_EQUALS(-1, nmc->handle_for(Qfalse));
+    TS_ASSERT_EQUALS(-2, nmc->handle_for(Qtrue));
+    TS_ASSERT_EQUALS(-3, nmc->handle_for(Qnil));
+    TS_ASSERT_EQUALS(NativeMethodContext::BASIC_HANDLES, nmc->handles().size());
+
+    nmc->release_frame();
+  }
+
+  void test_cached_array_writes_back() {
+    NativeMethodContext* nmc = new_context();
+    Array* ary = Array::create(state, 3);
+    ary->set(state, 0, Fixnum::from(1));
+    ary->set(state, 1, Fixnum::from(2));
+    ary->set(state, 2, Fixnum::from(3));
+
+    Handle handle = nmc->handle_for(ary);
+    CachedArray* view = nmc->cached_array(handle);
+
+    TS_ASSERT_EQUALS(3, view->len);
+    TS_ASSERT_EQUALS(Fixnum::from(2), nmc->object_from(view->ptr[1]));
+    TS_ASSERT_EQUALS(view, nmc->cached_array(handle));
+
+    view->ptr[0] = nmc->handle_for(Fixnum::from(9));
+    view->len = 2;
+    nmc->flush_cached_data();
+
+    TS_ASSERT_EQUALS(2U, ary->size());
+    TS_ASSERT_EQUALS(Fixnum::from(9), ary->get(state, 0));
+
+    nmc->release_frame();
+  }
+
+  void test_cached_array_is_shared_by_handles() {
+    NativeMethodContext* nmc = new_context();
+    Array* ary = Array::create(state, 1);
+    ary->set(state, 0, Fixnum::from(1));
+
+    Handle first = nmc->handle_for(ary);
+    Handle second = nmc->handle_for(ary);
+
+    TS_ASSERT(first != second);
+    TS_ASSERT_EQUALS(nmc->cached_array(first), nmc->cached_array(second));
+
+    nmc->release_frame();
+  }
+
+  void test_cached_string_writes_back() {
+    NativeMethodContext* nmc = new_context();
+    String* str = String::create(state, "12345");
+
+    Handle handle = nmc->handle_for(str);
+    CachedString* view = nmc->cached_string(handle);
+
+    TS_ASSERT_EQUALS(5, view->len);
+    TS_ASSERT_EQUALS(str->byte_address(), view->ptr);
+
+    view->ptr[0] = 'a';
+    view->len = 3;
+    nmc->flush_cached_data();
+
+    TS_ASSERT_EQUALS(std::string("a23"), str->c_str());
+
+    char foo[] = "foo";
+    view->ptr = foo;
+    nmc->flush_cached_data();
+    nmc->update_cached_data();
+
+    TS_ASSERT_EQUALS(std::string("foo"), str->c_str());
+    TS_ASSERT_EQUALS(str->byte_address(), view->ptr);
+
+    nmc->release_frame();
+  }
 };
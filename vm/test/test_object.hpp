@@ -1,8 +1,11 @@
 #include "vm.hpp"
 #include "objectmemory.hpp"
 #include "builtin/object.hpp"
+#include "builtin/bignum.hpp"
 #include "builtin/compactlookuptable.hpp"
+#include "builtin/float.hpp"
 
+#include <cmath>
 #include <cxxtest/TestSuite.h>
 
 using namespace rubinius;
@@ -152,6 +155,16 @@ class TestObject : public CxxTest::TestSuite {
     TS_ASSERT_DIFFERS(tup->metaclass(state), tup2->metaclass(state));
   }
 
+  void test_dup_and_clone_of_flonum() {
+#ifdef RBX_FLONUM
+    Float* flo = Float::create(state, 1.5);
+    TS_ASSERT(FLONUM_P(flo));
+
+    TS_ASSERT_EQUALS(flo, flo->dup(state));
+    TS_ASSERT_EQUALS(flo, flo->clone(state));
+#endif
+  }
+
   void test_clone() {
     Tuple* tup = Tuple::create(state, 1);
     tup->put(state, 0, Qtrue);
@@ -340,6 +353,28 @@ class TestObject : public CxxTest::TestSuite {
     TS_ASSERT(id4->to_native() % 2 != 0);
   }
 
+  void test_id_of_flonums_uses_whole_word() {
+#ifdef RBX_FLONUM
+    Float* one = Float::create(state, 1.0);
+    Float* tiny = Float::create(state, ldexp(1.0, -96));
+    TS_ASSERT(FLONUM_P(one));
+    TS_ASSERT(FLONUM_P(tiny));
+
+    Integer* id1 = one->id(state);
+    Integer* id2 = tiny->id(state);
+
+    TS_ASSERT(!same_integer(id1, id2));
+    TS_ASSERT(same_integer(id1, Float::create(state, 1.0)->id(state)));
+    TS_ASSERT(!same_integer(id1, Fixnum::from(33)->id(state)));
+#endif
+  }
+
+  /* ids are normalized, so a Fixnum never equals a Bignum. */
+  bool same_integer(Integer* a, Integer* b) {
+    if(kind_of<Fixnum>(a) || kind_of<Fixnum>(b)) return a == b;
+    return mp_cmp(as<Bignum>(a)->mp_val(), as<Bignum>(b)->mp_val()) == MP_EQ;
+  }
+
   void test_infect() {
     Object* obj1 = util_new_object();
     Object* obj2 = util_new_object();
@@ -556,6 +556,92 @@ class TestObjectMemory : public CxxTest::TestSuite {
     state->om->type_info[ObjectType] = ti;
   }
 
+    class CountingCleanupper : public TypeInfo {
+    public:
+      Object* last;
+      int count;
+
+      CountingCleanupper() : TypeInfo(ObjectType, true), last(NULL), count(0) {}
+
+      virtual void cleanup(Object* obj) { last = obj; count++; }
+    };
+
+  void test_collect_young_cleans_only_dead_objects() {
+    CountingCleanupper* c = new CountingCleanupper();
+
+    TypeInfo* ti = state->om->type_info[ObjectType];
+    state->om->type_info[ObjectType] = c;
+
+    Roots roots;
+    Object* dead = state->om->new_object(G(object), 1);
+    Object* live = state->om->new_object(G(object), 1);
+    Root r(&roots, live);
+
+    state->om->collect_young(roots);
+
+    TS_ASSERT_EQUALS(c->count, 1);
+    TS_ASSERT_EQUALS(c->last, dead);
+
+    live = r.get();
+    TS_ASSERT(live->young_object_p());
+    r.set(Qnil);
+
+    state->om->collect_young(roots);
+
+    TS_ASSERT_EQUALS(c->count, 2);
+    TS_ASSERT_EQUALS(c->last, live);
+
+    state->om->type_info[ObjectType] = ti;
+  }
+
+  void test_new_object_bumps_through_buffer() {
+    ObjectMemory& om = *state->om;
+
+    Roots roots;
+    om.collect_young(roots);
+    TS_ASSERT_EQUALS(om.young.buffer.remaining(), 0U);
+
+    Object* obj = om.new_object(G(object), 1);
+    Object* obj2 = om.new_object(G(object), 1);
+
+    TS_ASSERT_EQUALS(obj->zone, YoungObjectZone);
+    TS_ASSERT_EQUALS((uintptr_t)obj2, (uintptr_t)obj + obj->size_in_bytes());
+    TS_ASSERT_EQUALS((uintptr_t)om.young.buffer.current,
+                     (uintptr_t)obj2 + obj2->size_in_bytes());
+  }
+
+  void test_retired_buffer_leaves_heap_walkable() {
+    ObjectMemory& om = *state->om;
+
+    om.new_object(G(object), 1);
+    TS_ASSERT(om.young.buffer.remaining() > 0);
+
+    om.young.retire_buffer();
+    TS_ASSERT_EQUALS(om.young.buffer.remaining(), 0U);
+
+    size_t walked = 0;
+    Object* obj = om.young.current->first_object();
+    while(obj < om.young.current->current) {
+      walked += obj->size_in_bytes();
+      obj = om.young.next_object(obj);
+    }
+
+    TS_ASSERT_EQUALS(walked, om.young.current->used());
+  }
+
+  void test_large_object_skips_buffer() {
+    ObjectMemory& om = *state->om;
+
+    om.new_object(G(object), 1);
+    address before = om.young.buffer.current;
+
+    size_t fields = BakerGC::cMaxBufferedBytes / SIZE_OF_OBJECT;
+    Object* obj = om.new_object(G(object), fields);
+
+    TS_ASSERT_EQUALS(obj->num_fields(), fields);
+    TS_ASSERT_EQUALS(om.young.buffer.current, before);
+  }
+
   void test_contexts_initialized() {
     TS_ASSERT(state->om->contexts.scan <= state->om->contexts.current);
   }
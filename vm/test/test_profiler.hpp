@@ -86,16 +86,50 @@ class TestProfiler : public CxxTest::TestSuite {
     profiler::Method* mo = prof.find_key(key);
 
     TS_ASSERT_EQUALS(mo->number_of_leaves(), 1U);
-    profiler::Leaves::iterator i = mo->leaves_begin();
-    profiler::Leaf* leaf = i->second;
+    profiler::Leaf& leaf = *mo->leaves_begin();
 
     profiler::Key key2(meth2, klass);
     profiler::Method* mo2 = prof.find_key(key2);
 
-    TS_ASSERT_EQUALS(leaf->method(), mo2);
+    TS_ASSERT_EQUALS(leaf.method(), mo2);
 
-    TS_ASSERT(leaf->total_time() > 0);
-    TS_ASSERT_EQUALS(leaf->total_time(), mo2->total_time());
+    TS_ASSERT(leaf.total_time() > 0);
+    TS_ASSERT_EQUALS(leaf.total_time(), mo2->total_time());
+    TS_ASSERT_EQUALS(leaf.called_times(), 1ULL);
+  }
+
+  void test_enter_found_method() {
+    Symbol* meth = state->symbol("blah");
+    Symbol* klass = state->symbol("Sweet");
+
+    profiler::Profiler prof;
+
+    profiler::Method* mo = prof.find_method(meth, klass);
+    TS_ASSERT_EQUALS(prof.find_method(meth, klass), mo);
+    TS_ASSERT_EQUALS(prof.depth(), 0U);
+
+    TS_ASSERT_EQUALS(prof.enter_method(mo), mo);
+    TS_ASSERT_EQUALS(prof.enter_method(mo), mo);
+    TS_ASSERT_EQUALS(prof.depth(), 2U);
+    TS_ASSERT_EQUALS(prof.number_of_entries(), 1U);
+    TS_ASSERT_EQUALS(mo->called_times(), 2ULL);
+
+    // The recursive call is the only leaf of the method.
+    TS_ASSERT_EQUALS(mo->number_of_leaves(), 1U);
+    TS_ASSERT_EQUALS(mo->leaves_begin()->method(), mo);
+
+    prof.leave_method();
+    TS_ASSERT_EQUALS(prof.current_method(), mo);
+    prof.leave_method();
+    TS_ASSERT_EQUALS(prof.depth(), 0U);
+  }
+
+  void test_profilers_are_numbered() {
+    profiler::Profiler prof;
+    profiler::Profiler prof2;
+
+    TS_ASSERT(prof.id() != 0ULL);
+    TS_ASSERT(prof.id() != prof2.id());
   }
 
   void test_print_results() {
@@ -130,4 +164,27 @@ class TestProfiler : public CxxTest::TestSuite {
     // form of the XML for now.
     TS_ASSERT(stream.str().find("profile") != std::string::npos);
   }
+
+  void test_print_callgrind() {
+    Symbol* meth = state->symbol("blah");
+    Symbol* meth2 = state->symbol("foo");
+    Symbol* klass = state->symbol("Sweet");
+
+    profiler::Profiler prof;
+
+    prof.enter_method(meth, klass);
+    prof.enter_method(meth2, klass);
+    prof.leave_method();
+    prof.enter_method(meth2, klass);
+    prof.leave_method();
+    prof.leave_method();
+
+    std::stringstream stream;
+    prof.print_callgrind(state, stream);
+
+    std::string out = stream.str();
+    TS_ASSERT_EQUALS(out.find("events: ns\n"), out.find("events:"));
+    TS_ASSERT(out.find("fn=Sweet.blah\n") != std::string::npos);
+    TS_ASSERT(out.find("cfn=Sweet.foo\ncalls=2 ") != std::string::npos);
+  }
 };
@@ -1,5 +1,6 @@
 #include "builtin/regexp.hpp"
 #include "vm.hpp"
+#include "objectmemory.hpp"
 
 #include <cxxtest/TestSuite.h>
 
@@ -130,9 +131,9 @@ class TestRegexp : public CxxTest::TestSuite {
     TS_ASSERT_EQUALS(as<Integer>(matches->full()->at(state, 0))->to_native(), 0);
     TS_ASSERT_EQUALS(as<Integer>(matches->full()->at(state, 1))->to_native(), 2);
 
-    TS_ASSERT_EQUALS(matches->region()->num_fields(), 1U);
-    TS_ASSERT_EQUALS(as<Integer>(as<Tuple>(matches->region()->at(state, 0))->at(state, 0))->to_native(), 1);
-    TS_ASSERT_EQUALS(as<Integer>(as<Tuple>(matches->region()->at(state, 0))->at(state, 1))->to_native(), 2);
+    TS_ASSERT_EQUALS(matches->region()->num_fields(), 2U);
+    TS_ASSERT_EQUALS(as<Integer>(matches->region()->at(state, 0))->to_native(), 1);
+    TS_ASSERT_EQUALS(as<Integer>(matches->region()->at(state, 1))->to_native(), 2);
   }
 
   void test_match_region_with_backward_captures() {
@@ -151,9 +152,53 @@ class TestRegexp : public CxxTest::TestSuite {
     TS_ASSERT_EQUALS(as<Integer>(matches->full()->at(state, 0))->to_native(), 1);
     TS_ASSERT_EQUALS(as<Integer>(matches->full()->at(state, 1))->to_native(), 3);
 
-    TS_ASSERT_EQUALS(matches->region()->num_fields(), 1U);
-    TS_ASSERT_EQUALS(as<Integer>(as<Tuple>(matches->region()->at(state, 0))->at(state, 0))->to_native(), 2);
-    TS_ASSERT_EQUALS(as<Integer>(as<Tuple>(matches->region()->at(state, 0))->at(state, 1))->to_native(), 3);
+    TS_ASSERT_EQUALS(matches->region()->num_fields(), 2U);
+    TS_ASSERT_EQUALS(as<Integer>(matches->region()->at(state, 0))->to_native(), 2);
+    TS_ASSERT_EQUALS(as<Integer>(matches->region()->at(state, 1))->to_native(), 3);
+  }
+
+  void test_initialize_same_pattern_twice() {
+    Regexp* first = Regexp::create(state);
+    first->initialize(state, String::create(state, "b(.)"), Fixnum::from(0), Qnil);
+
+    Regexp* second = Regexp::create(state);
+    second->initialize(state, String::create(state, "b(.)"), Fixnum::from(0), Qnil);
+
+    /* The second must keep working once the first is gone. */
+    state->om->find_type_info(first)->cleanup(first);
+
+    String *input = String::create(state, "abc");
+    MatchData* matches = (MatchData*)second->match_region(state, input,
+        Fixnum::from(0), Fixnum::from(3), Qtrue);
+
+    TS_ASSERT(!matches->nil_p());
+    TS_ASSERT_EQUALS(as<Integer>(matches->region()->at(state, 0))->to_native(), 2);
+  }
+
+  Object* search(const char* pattern, const char* subject) {
+    Regexp* re = Regexp::create(state);
+    re->initialize(state, String::create(state, pattern), Fixnum::from(0), Qnil);
+
+    String* input = String::create(state, subject);
+    return re->match_region(state, input, Fixnum::from(0),
+                            Fixnum::from(input->size()), Qtrue);
+  }
+
+  void test_match_region_with_literal_prefix() {
+    MatchData* matches = as<MatchData>(search("ab(c)", "xxabxabc"));
+    TS_ASSERT_EQUALS(as<Integer>(matches->full()->at(state, 0))->to_native(), 5);
+    TS_ASSERT_EQUALS(as<Integer>(matches->full()->at(state, 1))->to_native(), 8);
+
+    TS_ASSERT(search("ab(c)", "xxabxabd")->nil_p());
+    TS_ASSERT(search("abc", "ab")->nil_p());
+  }
+
+  void test_match_region_prefix_not_required() {
+    TS_ASSERT(!search("ab|cd", "xcd")->nil_p());
+    TS_ASSERT(!search("ab?c", "ac")->nil_p());
+    TS_ASSERT(!search("ab*", "a")->nil_p());
+    TS_ASSERT(!search("a[|]|x", "x")->nil_p());
+    TS_ASSERT(search("abc", "ABC")->nil_p());
   }
 
   void test_match_start() {
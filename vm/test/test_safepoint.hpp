@@ -0,0 +1,98 @@
+#include "vm.hpp"
+#include "safepoint.hpp"
+
+#include <pthread.h>
+#include <unistd.h>
+#include <cxxtest/TestSuite.h>
+
+using namespace rubinius;
+
+struct SafepointRequest {
+  VM* state;
+  volatile bool stopped;
+  volatile bool resumed;
+};
+
+/* Stops the VM, checks it stays stopped for a while, then resumes it. */
+static void* stop_and_resume(void* arg) {
+  SafepointRequest* req = static_cast<SafepointRequest*>(arg);
+
+  req->state->safepoint->stop();
+  req->stopped = req->state->safepoint->stopped_p();
+  usleep(10000);
+
+  req->resumed = true;
+  req->state->safepoint->resume();
+  return NULL;
+}
+
+/* Resumes a VM that was stopped by the test itself. */
+static void* resume_later(void* arg) {
+  SafepointRequest* req = static_cast<SafepointRequest*>(arg);
+
+  usleep(10000);
+  req->resumed = true;
+  req->state->safepoint->resume();
+  return NULL;
+}
+
+class TestSafepoint : public CxxTest::TestSuite {
+  public:
+
+  VM *state;
+
+  void setUp() {
+    state = new VM();
+  }
+
+  void tearDown() {
+    delete state;
+  }
+
+  void test_park_without_stop_returns() {
+    state->safepoint->park();
+    TS_ASSERT(!state->safepoint->stopped_p());
+  }
+
+  void test_stop_waits_for_interrupt_check() {
+    SafepointRequest req = { state, false, false };
+    pthread_t thread;
+
+    state->interrupts.check = false;
+    TS_ASSERT_EQUALS(pthread_create(&thread, NULL, stop_and_resume, &req), 0);
+
+    // Running Ruby code, until the interrupt asks us to stop.
+    for(int i = 0; i < 1000 && !state->interrupts.check; i++) {
+      usleep(1000);
+    }
+    TS_ASSERT(state->interrupts.check);
+
+    state->interrupts.check = false;
+    state->safepoint->park();
+
+    TS_ASSERT(req.stopped);
+    TS_ASSERT(req.resumed);
+    TS_ASSERT(!state->safepoint->stopped_p());
+
+    pthread_join(thread, NULL);
+  }
+
+  void test_blocking_is_a_safepoint() {
+    SafepointRequest req = { state, false, false };
+    pthread_t thread;
+
+    state->safepoint->enter_blocking();
+
+    // Doesn't wait on an interrupt check that would never come.
+    state->safepoint->stop();
+    TS_ASSERT(state->safepoint->stopped_p());
+
+    TS_ASSERT_EQUALS(pthread_create(&thread, NULL, resume_later, &req), 0);
+
+    // Coming back to Ruby code waits for the resume.
+    state->safepoint->leave_blocking();
+    TS_ASSERT(req.resumed);
+
+    pthread_join(thread, NULL);
+  }
+};
@@ -0,0 +1,126 @@
+#include "vm.hpp"
+#include "objectmemory.hpp"
+#include "sampler.hpp"
+
+#include "builtin/array.hpp"
+#include "builtin/compiledmethod.hpp"
+#include "builtin/contexts.hpp"
+#include "builtin/iseq.hpp"
+#include "builtin/staticscope.hpp"
+#include "builtin/string.hpp"
+#include "builtin/task.hpp"
+
+#include <cxxtest/TestSuite.h>
+
+using namespace rubinius;
+
+class TestSampler : public CxxTest::TestSuite {
+  public:
+
+  VM* state;
+
+  void setUp() {
+    state = new VM();
+  }
+
+  void tearDown() {
+    delete state;
+  }
+
+  MethodContext* activate_method(const char* name) {
+    CompiledMethod* cm = CompiledMethod::create(state);
+    cm->iseq(state, InstructionSequence::create(state, 1));
+    cm->stack_size(state, Fixnum::from(10));
+    cm->name(state, state->symbol(name));
+    cm->scope(state, StaticScope::create(state));
+    cm->scope()->module(state, G(object));
+
+    MethodContext* ctx = MethodContext::create(state, Qnil, cm);
+    ctx->module(state, G(object));
+    ctx->name(state, state->symbol(name));
+    ctx->sender(state, G(current_task)->active());
+
+    G(current_task)->active(state, ctx);
+    return ctx;
+  }
+
+  Array* frames_of(Array* results, size_t index) {
+    return as<Array>(as<Array>(results->get(state, index))->get(state, 0));
+  }
+
+  Object* count_of(Array* results, size_t index) {
+    return as<Array>(results->get(state, index))->get(state, 1);
+  }
+
+  void test_samples_are_counted_against_the_call_stack() {
+    Sampler sampler(state);
+
+    activate_method("outer");
+    activate_method("inner");
+
+    sampler.take_sample();
+    sampler.take_sample();
+    TS_ASSERT(state->interrupts.check_samples);
+
+    sampler.process_samples();
+
+    Array* results = sampler.results();
+    TS_ASSERT_EQUALS(results->size(), 1U);
+    TS_ASSERT_EQUALS(count_of(results, 0), Fixnum::from(2));
+
+    Array* frames = frames_of(results, 0);
+    size_t size = frames->size();
+    TS_ASSERT(size >= 2U);
+    TS_ASSERT_EQUALS(std::string("Object#outer"),
+        as<String>(frames->get(state, size - 2))->c_str());
+    TS_ASSERT_EQUALS(std::string("Object#inner"),
+        as<String>(frames->get(state, size - 1))->c_str());
+  }
+
+  void test_sampled_method_is_the_leaf() {
+    Sampler sampler(state);
+
+    activate_method("caller");
+    MethodContext* ctx = activate_method("sampled");
+
+    sampler.take_sample();
+
+    // The sampled method returned before the samples were processed.
+    G(current_task)->active(state, ctx->sender());
+    sampler.process_samples();
+
+    Array* results = sampler.results();
+    TS_ASSERT_EQUALS(results->size(), 1U);
+
+    Array* frames = frames_of(results, 0);
+    size_t size = frames->size();
+    TS_ASSERT_EQUALS(std::string("Object#caller"),
+        as<String>(frames->get(state, size - 2))->c_str());
+    TS_ASSERT_EQUALS(std::string("Object#sampled"),
+        as<String>(frames->get(state, size - 1))->c_str());
+  }
+
+  void test_samples_across_a_collection_are_dropped() {
+    Sampler sampler(state);
+
+    activate_method("blah");
+    sampler.take_sample();
+
+    state->om->collect_young(state->globals.roots);
+    sampler.process_samples();
+
+    TS_ASSERT_EQUALS(sampler.results()->size(), 0U);
+    TS_ASSERT_EQUALS(sampler.dropped(), 1U);
+  }
+
+  void test_samples_during_a_collection_are_counted() {
+    Sampler sampler(state);
+
+    state->om->collecting = true;
+    sampler.take_sample();
+    state->om->collecting = false;
+
+    TS_ASSERT_EQUALS(sampler.gc_samples(), 1U);
+    TS_ASSERT_EQUALS(sampler.results()->size(), 0U);
+  }
+};
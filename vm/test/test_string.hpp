@@ -122,6 +122,32 @@ class TestString : public CxxTest::TestSuite {
     TS_ASSERT_SAME_DATA("omote u\0ra\0", s1->byte_address(), 10);
   }
 
+  void test_append_reuses_unshared_data() {
+    str = String::create(state, "foo");
+    str->append(state, "b");
+
+    ByteArray* ba = str->data();
+    TS_ASSERT(str->size() + 2 < ba->size());
+
+    str->append(state, "a");
+    str->append(state, "r");
+
+    TS_ASSERT_EQUALS(ba, str->data());
+    TS_ASSERT_SAME_DATA("foobar\0", str->byte_address(), 7);
+  }
+
+  void test_append_to_shared() {
+    str = String::create(state, "foo");
+    String* str2 = str->string_dup(state);
+
+    str->append(state, "bar");
+
+    TS_ASSERT(str->data() != str2->data());
+    TS_ASSERT_EQUALS(Qfalse, str->shared());
+    TS_ASSERT_SAME_DATA("foobar\0", str->byte_address(), 7);
+    TS_ASSERT_SAME_DATA("foo\0", str2->byte_address(), 4);
+  }
+
   void test_append_with_charstar() {
     str = String::create(state, "blah");
     str->append(state, " foo");
@@ -147,6 +173,14 @@ class TestString : public CxxTest::TestSuite {
     TS_ASSERT_EQUALS(str1->equal(state, str3), Qfalse);
   }
 
+  void test_equal_with_embedded_null() {
+    String* str1 = String::create(state, "a\0b", 3);
+    String* str2 = String::create(state, "a\0c", 3);
+
+    TS_ASSERT_EQUALS(str1->equal(state, str2), Qfalse);
+    TS_ASSERT_EQUALS(str1->equal(state, str1->string_dup(state)), Qtrue);
+  }
+
   void test_to_double() {
     str = String::create(state, "2.10");
     double val = 2.10;
@@ -161,6 +195,19 @@ class TestString : public CxxTest::TestSuite {
     TS_ASSERT(val->equal(state, ret));
   }
 
+  void test_to_i_bignum() {
+    std::string digits(500, '9');
+    digits[0] = '-';
+    digits[100] = '_';
+
+    str = String::create(state, digits.c_str());
+    Integer* val = str->to_i(state, Fixnum::from(10), Qtrue);
+    TS_ASSERT(kind_of<Bignum>(val));
+
+    digits.erase(100, 1);
+    TS_ASSERT_EQUALS(digits, as<Bignum>(val)->to_s(state, Fixnum::from(10))->byte_address());
+  }
+
   void test_to_i() {
     str = String::create(state, "0");
     Integer* val = str->to_i(state);
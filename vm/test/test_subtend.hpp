@@ -80,6 +80,18 @@ extern "C" {
     return args[0];
   }
 
+  Handle write_through_two_handles(Handle receiver, Handle array)
+  {
+    hidden_context = NativeMethodContext::current();
+
+    VALUE other = hidden_context->handle_for(hidden_context->object_from(array));
+
+    RARRAY(array)->ptr[0] = hidden_context->handle_for(Fixnum::from(7));
+    RARRAY(other)->ptr[1] = hidden_context->handle_for(Fixnum::from(8));
+
+    return RARRAY(array)->ptr[1];
+  }
+
   Handle one_arg(Handle receiver, Handle arg1)
   {
     hidden_context = NativeMethodContext::current();
@@ -324,6 +336,35 @@ class TestSubtend : public CxxTest::TestSuite
     TS_ASSERT_EQUALS(as<Fixnum>(hidden_context->return_value())->to_int(), arg_count);
   }
 
+  void test_rarray_through_two_handles_to_the_same_array()
+  {
+    Array* array = Array::create(my_state, 2);
+    array->set(my_state, 0, Fixnum::from(1));
+    array->set(my_state, 1, Fixnum::from(2));
+
+    Array* args = Array::create(my_state, 1);
+    args->set(my_state, 0, array);
+
+    my_message->recv = my_state->new_object(my_state->globals.object.get());
+    my_message->set_arguments(my_state, args);
+    my_message->name = my_state->symbol("__subtend_fake_test_method__");
+
+    NativeMethod* method = NativeMethod::create(my_state,
+                                                String::create(my_state, __FILE__),
+                                                my_module,
+                                                my_message->name,
+                                                &write_through_two_handles,
+                                                Fixnum::from(1));
+
+    my_message->method = method;
+    method->execute(my_state, my_task, *my_message);
+
+    /* Both views are one, so neither write is lost at the flush. */
+    TS_ASSERT_EQUALS(hidden_context->return_value(), Fixnum::from(8));
+    TS_ASSERT_EQUALS(array->get(my_state, 0), Fixnum::from(7));
+    TS_ASSERT_EQUALS(array->get(my_state, 1), Fixnum::from(8));
+  }
+
   void test_ruby_to_c_call_clears_caller_stack()
   {
     Task* task = Task::create(my_state, 2);
@@ -18,7 +18,7 @@ public:
   }
 
   void test_thread_fileds() {
-    TS_ASSERT_EQUALS(6U, Thread::fields);
+    TS_ASSERT_EQUALS(10U, Thread::fields);
   }
 
   void test_current() {
@@ -32,6 +32,9 @@ public:
 
     TS_ASSERT_EQUALS(2, thr->priority()->to_native());
     TS_ASSERT_DIFFERS(thr, Thread::current(state));
+
+    TS_ASSERT(!RunQueue::linked_p(thr));
+    TS_ASSERT(thr->queue_prev()->nil_p());
   }
 
   void test_exited() {
@@ -136,29 +139,25 @@ public:
                      reinterpret_cast<Object*>(thr->wakeup(state)));
   }
 
-  void test_enlarge_for_priority() {
-    std::size_t current_max = state->globals.scheduled_threads->num_fields();
-
+  void test_priority_moves_queued_thread() {
     Thread* thread = Thread::create(state);
+    thread->wakeup(state);
 
+    TS_ASSERT_EQUALS(1U, state->run_queue.size(state, 2));
 
-    TS_ASSERT_EQUALS(state->globals.scheduled_threads->num_fields(),
-                     current_max);
-
-    thread->priority(state, Fixnum::from(current_max));
-
-    TS_ASSERT_EQUALS(state->globals.scheduled_threads->num_fields(),
-                     (current_max + 1));
+    thread->priority(state, Fixnum::from(7));
 
-    thread->priority(state, Fixnum::from(1));
-
-    TS_ASSERT_EQUALS(state->globals.scheduled_threads->num_fields(),
-                     (current_max + 1));
+    TS_ASSERT_EQUALS(0U, state->run_queue.size(state, 2));
+    TS_ASSERT_EQUALS(1U, state->run_queue.size(state, 7));
+  }
 
-    thread->priority(state, Fixnum::from(current_max + 10));
+  void test_priority_above_max_shares_max_queue() {
+    Thread* thread = Thread::create(state);
+    thread->priority(state, Fixnum::from(RunQueue::cMaxPriority + 10));
+    thread->wakeup(state);
 
-    TS_ASSERT_EQUALS(state->globals.scheduled_threads->num_fields(),
-                     (current_max + 11));
+    TS_ASSERT_EQUALS(1U, state->run_queue.size(state, RunQueue::cMaxPriority));
+    TS_ASSERT_EQUALS(thread, state->run_queue.pop(state));
   }
 
 };
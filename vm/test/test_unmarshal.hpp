@@ -139,7 +139,7 @@ public:
 
     Float* flt = as<Float>(obj);
 
-    TS_ASSERT_EQUALS(flt->val, 15.5);
+    TS_ASSERT_EQUALS(flt->val(), 15.5);
   }
 
   void test_float_infinity() {
@@ -151,7 +151,7 @@ public:
 
     Float* flt = as<Float>(obj);
 
-    TS_ASSERT(std::isinf(flt->val));
+    TS_ASSERT(std::isinf(flt->val()));
   }
 
   void test_float_neg_infinity() {
@@ -163,8 +163,8 @@ public:
 
     Float* flt = as<Float>(obj);
 
-    TS_ASSERT(std::isinf(flt->val));
-    TS_ASSERT(flt->val < 0.0);
+    TS_ASSERT(std::isinf(flt->val()));
+    TS_ASSERT(flt->val() < 0.0);
   }
 
   void test_float_nan() {
@@ -176,7 +176,7 @@ public:
 
     Float* flt = as<Float>(obj);
 
-    TS_ASSERT(std::isnan(flt->val));
+    TS_ASSERT(std::isnan(flt->val()));
   }
 
   void test_iseq() {
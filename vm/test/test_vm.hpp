@@ -1,14 +1,36 @@
 #include "vm.hpp"
 #include "objectmemory.hpp"
 #include "gc_debug.hpp"
+#include "config.hpp"
+#include "native_thread.hpp"
+#include "preemption.hpp"
+#include "event.hpp"
+
+#include "builtin/integer.hpp"
+#include "builtin/thread.hpp"
 
 #include <cxxtest/TestSuite.h>
 
 #include <map>
 #include <vector>
+#include <unistd.h>
 
 using namespace rubinius;
 
+/* Wakes a Thread when an event fires, as a Channel would. */
+class TestWakeThread : public ObjectCallback {
+public:
+  TypedRoot<Thread*> thread;
+
+  TestWakeThread(STATE, Thread* thr) : ObjectCallback(state), thread(state, thr) { }
+
+  virtual Object* object() { return Qnil; }
+
+  virtual void call(Object* obj) {
+    thread->wakeup(state);
+  }
+};
+
 class TestVM : public CxxTest::TestSuite {
   public:
 
@@ -140,6 +162,135 @@ class TestVM : public CxxTest::TestSuite {
     TS_ASSERT_EQUALS(Qtrue, cur->queued());
   }
 
+  void test_activate_thread_charges_cpu_time() {
+    Thread* cur = Thread::current(state);
+    Thread* thread = Thread::create(state);
+
+    uint64_t start = native::cpu_time_usec();
+    while(native::cpu_time_usec() - start < 2000) { }
+
+    state->activate_thread(thread);
+
+    TS_ASSERT(cur->cpu_time()->to_long_long() >= 2000);
+    TS_ASSERT_EQUALS(thread->cpu_time()->to_long_long(), 0);
+  }
+
+  void test_quantum_grows_when_preempted() {
+    Thread* cur = Thread::current(state);
+    Thread* thread = Thread::create(state);
+
+    state->interrupts.reschedule = true;
+    state->activate_thread(thread);
+
+    TS_ASSERT_EQUALS((uint64_t)cur->quantum()->to_native(), state->config.quantum * 2);
+    TS_ASSERT(!state->interrupts.reschedule);
+  }
+
+  void test_quantum_shrinks_when_given_up_early() {
+    Thread* cur = Thread::current(state);
+    Thread* thread = Thread::create(state);
+
+    // Booting the VM is charged to the first Thread.
+    state->charge_current_thread();
+    state->activate_thread(thread);
+
+    TS_ASSERT_EQUALS((uint64_t)cur->quantum()->to_native(), state->config.quantum / 2);
+  }
+
+  void test_quantum_stays_within_limits() {
+    Thread* cur = Thread::current(state);
+    Thread* thread = Thread::create(state);
+
+    cur->quantum(state, Fixnum::from(state->config.quantum_min));
+    state->activate_thread(thread);
+    TS_ASSERT_EQUALS((uint64_t)cur->quantum()->to_native(), state->config.quantum_min);
+
+    thread->quantum(state, Fixnum::from(state->config.quantum_max));
+    state->interrupts.reschedule = true;
+    state->activate_thread(cur);
+    TS_ASSERT_EQUALS((uint64_t)thread->quantum()->to_native(), state->config.quantum_max);
+  }
+
+  void test_setup_preemption_reads_quanta_from_config() {
+    std::istringstream stream;
+    stream.str("rbx.scheduler.quantum = 20\nrbx.scheduler.quantum_max = 100\n");
+    state->user_config->import_stream(stream);
+
+    state->setup_preemption();
+
+    TS_ASSERT_EQUALS(state->config.quantum, 20000U);
+    TS_ASSERT_EQUALS(state->config.quantum_min, 1000U);
+    TS_ASSERT_EQUALS(state->config.quantum_max, 100000U);
+  }
+
+  void test_preemption_armed_only_while_threads_wait() {
+    std::istringstream stream;
+    stream.str("rbx.scheduler.quantum = 60000\nrbx.scheduler.quantum_max = 60000\n");
+    state->user_config->import_stream(stream);
+    state->setup_preemption();
+
+    Thread* thread = Thread::create(state);
+
+    state->schedule_preemption();
+    TS_ASSERT(!state->preemption->armed_p());
+
+    thread->wakeup(state);
+    TS_ASSERT(state->preemption->armed_p());
+
+    state->dequeue_thread(thread);
+    state->schedule_preemption();
+    TS_ASSERT(!state->preemption->armed_p());
+  }
+
+  void test_preemption_polls_for_sleepers_beside_a_busy_thread() {
+    state->setup_preemption();
+
+    // The current Thread stays busy while +sleeper+ waits on a timer.
+    Thread* sleeper = Thread::create(state);
+    TestWakeThread wake(state, sleeper);
+
+    state->schedule_preemption();
+    TS_ASSERT(!state->preemption->armed_p());
+
+    state->events->start(new event::Timer(state, &wake, 0.001));
+    state->schedule_preemption();
+    TS_ASSERT(state->preemption->armed_p());
+    TS_ASSERT(state->preempt_for_events);
+
+    for(int i = 0; i < 1000 && state->preemption->fired() == 0; i++) {
+      usleep(1000);
+    }
+
+    TS_ASSERT_EQUALS(state->preemption->fired(), 1U);
+    TS_ASSERT(state->interrupts.check_events);
+
+    state->events->poll();
+    TS_ASSERT_EQUALS(Qtrue, sleeper->queued());
+
+    // Now it's waiting to run, so the busy Thread gets a quantum.
+    state->schedule_preemption();
+    TS_ASSERT(state->preemption->armed_p());
+    TS_ASSERT(!state->preempt_for_events);
+  }
+
+  void test_preemption_asks_for_reschedule() {
+    state->setup_preemption();
+
+    Thread* thread = Thread::create(state);
+    thread->wakeup(state);
+    TS_ASSERT(state->preemption->armed_p());
+
+    state->preemption->arm(1000);
+    for(int i = 0; i < 1000 && state->preemption->fired() == 0; i++) {
+      usleep(1000);
+    }
+
+    TS_ASSERT_EQUALS(state->preemption->fired(), 1U);
+    TS_ASSERT(!state->preemption->armed_p());
+    TS_ASSERT(state->interrupts.reschedule);
+    TS_ASSERT(state->interrupts.check_events);
+  }
+
   void test_find_and_activate() {
     Thread* cur = Thread::current(state);
     Thread* thread = Thread::create(state);
@@ -217,14 +368,13 @@ class TestVM : public CxxTest::TestSuite {
 
     TS_ASSERT_EQUALS(Qfalse, thread->queued());
 
-    List* zeroes = as<List>(state->globals.scheduled_threads->at(state, 0));
-    TS_ASSERT_EQUALS(0, zeroes->count()->to_native());
+    TS_ASSERT_EQUALS(0U, state->run_queue.size(state, 0));
 
     state->queue_thread(thread);
 
     TS_ASSERT_EQUALS(Qtrue, thread->queued());
-    TS_ASSERT_EQUALS(1, zeroes->count()->to_native());
-    TS_ASSERT_EQUALS(thread, as<Thread>(zeroes->shift(state)));
+    TS_ASSERT_EQUALS(1U, state->run_queue.size(state, 0));
+    TS_ASSERT_EQUALS(thread, state->run_queue.pop(state));
   }
 
   void test_queue_already_queued_thread_is_noop() {
@@ -243,14 +393,13 @@ class TestVM : public CxxTest::TestSuite {
     TS_ASSERT_EQUALS(Qfalse, thread->queued());
     TS_ASSERT_EQUALS(Qtrue, thread->sleep());
 
-    List* zeroes = as<List>(state->globals.scheduled_threads->at(state, 0));
-    TS_ASSERT_EQUALS(0, zeroes->count()->to_native());
+    TS_ASSERT_EQUALS(0U, state->run_queue.size(state, 0));
 
     state->queue_thread(thread);
 
     TS_ASSERT_EQUALS(Qtrue, thread->queued());
-    TS_ASSERT_EQUALS(1, zeroes->count()->to_native());
-    TS_ASSERT_EQUALS(thread, as<Thread>(zeroes->shift(state)));
+    TS_ASSERT_EQUALS(1U, state->run_queue.size(state, 0));
+    TS_ASSERT_EQUALS(thread, state->run_queue.pop(state));
 
     TS_ASSERT_EQUALS(Qtrue, thread->sleep());
   }
@@ -270,13 +419,53 @@ class TestVM : public CxxTest::TestSuite {
 
     state->queue_thread(thread);
 
-    List* zeroes = as<List>(state->globals.scheduled_threads->at(state, 0));
-    TS_ASSERT_EQUALS(1, zeroes->count()->to_native());
+    TS_ASSERT_EQUALS(1U, state->run_queue.size(state, 0));
 
     state->dequeue_thread(thread);
 
     TS_ASSERT_EQUALS(Qfalse, thread->queued());
-    TS_ASSERT_EQUALS(0, zeroes->count()->to_native());
+    TS_ASSERT_EQUALS(0U, state->run_queue.size(state, 0));
+  }
+
+  void test_find_and_activate_prefers_higher_priority() {
+    Thread* cur = Thread::current(state);
+    Thread* low = Thread::create(state);
+    Thread* high = Thread::create(state);
+    Thread* zero = Thread::create(state);
+
+    low->priority(state, Fixnum::from(1));
+    high->priority(state, Fixnum::from(5));
+    zero->priority(state, Fixnum::from(0));
+
+    low->wakeup(state);
+    zero->wakeup(state);
+    high->wakeup(state);
+
+    TS_ASSERT(state->find_and_activate_thread());
+    TS_ASSERT_EQUALS(high, Thread::current(state));
+
+    // The previous current Thread was queued at the default priority, 2.
+    TS_ASSERT_EQUALS(cur, state->run_queue.pop(state));
+    TS_ASSERT_EQUALS(low, state->run_queue.pop(state));
+    TS_ASSERT_EQUALS(zero, state->run_queue.pop(state));
+    TS_ASSERT_EQUALS((Thread*)NULL, state->run_queue.pop(state));
   }
 
+  void test_dequeue_thread_from_middle_of_queue() {
+    Thread* first = Thread::create(state);
+    Thread* middle = Thread::create(state);
+    Thread* last = Thread::create(state);
+
+    state->queue_thread(first);
+    state->queue_thread(middle);
+    state->queue_thread(last);
+    TS_ASSERT_EQUALS(3U, state->run_queue.size(state, 2));
+
+    state->dequeue_thread(middle);
+    TS_ASSERT_EQUALS(2U, state->run_queue.size(state, 2));
+
+    TS_ASSERT_EQUALS(first, state->run_queue.pop(state));
+    TS_ASSERT_EQUALS(last, state->run_queue.pop(state));
+    TS_ASSERT(state->run_queue.empty_p());
+  }
 };
@@ -34,6 +34,33 @@ public:
     TS_ASSERT_EQUALS(vmm.opcodes[0], 0U);
   }
 
+  void test_cached_profiler_method_matches_whole_key() {
+    CompiledMethod* cm = CompiledMethod::create(state);
+    cm->literals(state, Tuple::create(state, 0));
+
+    InstructionSequence* iseq = InstructionSequence::create(state, 1);
+    iseq->opcodes()->put(state, 0, Fixnum::from(0));
+    cm->iseq(state, iseq);
+
+    VMMethod vmm(state, cm);
+    profiler::Profiler prof;
+    Symbol* name = state->symbol("blah");
+
+    profiler::Method* meth =
+      prof.find_method(name, G(object)->name(), profiler::kSingleton);
+    vmm.cache_profiler_method(&prof, name, G(object), profiler::kSingleton, meth);
+
+    TS_ASSERT_EQUALS(meth,
+        vmm.cached_profiler_method(&prof, name, G(object), profiler::kSingleton));
+    TS_ASSERT(!vmm.cached_profiler_method(&prof, state->symbol("other"),
+          G(object), profiler::kSingleton));
+    TS_ASSERT(!vmm.cached_profiler_method(&prof, name, G(string), profiler::kSingleton));
+    TS_ASSERT(!vmm.cached_profiler_method(&prof, name, G(object), profiler::kBlock));
+
+    profiler::Profiler prof2;
+    TS_ASSERT(!vmm.cached_profiler_method(&prof2, name, G(object), profiler::kSingleton));
+  }
+
   void test_specialize_transforms_ivars_to_slots() {
     CompiledMethod* cm = CompiledMethod::create(state);
     Tuple* tup = Tuple::from(state, 1, state->symbol("@blah"));
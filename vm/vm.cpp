@@ -9,6 +9,7 @@
 #include "builtin/class.hpp"
 #include "builtin/contexts.hpp"
 #include "builtin/fixnum.hpp"
+#include "builtin/integer.hpp"
 #include "builtin/list.hpp"
 #include "builtin/symbol.hpp"
 #include "builtin/thread.hpp"
@@ -17,6 +18,12 @@
 #include "builtin/taskprobe.hpp"
 
 #include "config.hpp"
+#include "sampler.hpp"
+#include "instruction_stats.hpp"
+#include "mailbox.hpp"
+#include "native_thread.hpp"
+#include "preemption.hpp"
+#include "safepoint.hpp"
 
 #include <iostream>
 #include <signal.h>
@@ -28,8 +35,43 @@
 #define GO(whatever) globals.whatever
 
 namespace rubinius {
-  VM::VM(size_t bytes) : current_mark(NULL), reuse_llvm(true) {
+
+  // libev's default loop is the only one that can watch signals, so it
+  // goes to whichever VM asks first, and to the next one once that's gone.
+  static native::Mutex default_loop_lock;
+  static bool default_loop_taken = false;
+
+  static bool claim_default_loop() {
+    native::LockGuard guard(default_loop_lock);
+
+    if(default_loop_taken) return false;
+    default_loop_taken = true;
+    return true;
+  }
+
+  static void release_default_loop() {
+    native::LockGuard guard(default_loop_lock);
+    default_loop_taken = false;
+  }
+
+  VM::VM(size_t bytes, Mailbox* mailbox)
+    : sampler(NULL)
+    , instruction_stats(NULL)
+    , mailbox(mailbox ? mailbox : Mailbox::create())
+    , run_queue(&globals.roots)
+    , current_mark(NULL)
+    , reuse_llvm(true)
+    , owns_default_loop(false)
+    , preemption(NULL)
+    , preempt_for_events(false)
+    , safepoint(new Safepoint(this))
+    , thread_cpu_mark(native::cpu_time_usec())
+  {
     config.compile_up_front = false;
+    config.quantum = 10000;
+    config.quantum_min = 1000;
+    config.quantum_max = 40000;
+    config.event_poll_interval = 20000;
 
     VM::register_state(this);
 
@@ -43,14 +85,21 @@ namespace rubinius {
 
     bootstrap_ontology();
 
-    /* @todo Using a single default loop, revisit when many loops.
-     * @todo This needs to be handled through the environment.
+    /* @todo This needs to be handled through the environment.
      * (disabled epoll backend as it frequently caused hangs on epoll_wait)
      */
-    signal_events = new event::Loop(EVFLAG_FORKCHECK | EVBACKEND_SELECT | EVBACKEND_POLL);
-    events = signal_events;
+    int loop_flags = EVFLAG_FORKCHECK | EVBACKEND_SELECT | EVBACKEND_POLL;
 
-    signal_events->start(new event::Child::Event(this));
+    owns_default_loop = claim_default_loop();
+    if(owns_default_loop) {
+      signal_events = new event::Loop(loop_flags);
+      signal_events->start(new event::Child::Event(this));
+    } else {
+      signal_events = new event::Loop(ev_loop_new(loop_flags));
+      signal_events->owner = true;
+    }
+
+    events = signal_events;
 
     global_cache = new GlobalCache;
 
@@ -66,9 +115,15 @@ namespace rubinius {
   }
 
   VM::~VM() {
+    delete preemption;
+    delete sampler;
+    delete safepoint;
+    delete instruction_stats;
     delete om;
 
+    Mailbox::destroy(mailbox);
     delete signal_events;
+    if(owns_default_loop) release_default_loop();
 
     delete global_cache;
 #ifdef ENABLE_LLVM
@@ -76,15 +131,14 @@ namespace rubinius {
 #endif
   }
 
-  // HACK so not thread safe or anything!
-  static VM* __state = NULL;
+  static native::ThreadLocal<VM*> __state;
 
   VM* VM::current_state() {
-    return __state;
+    return __state.get();
   }
 
   void VM::register_state(VM *vm) {
-    __state = vm;
+    __state.set(vm);
   }
 
   void VM::boot_threads() {
@@ -196,6 +250,11 @@ namespace rubinius {
   }
 
   void VM::collect_maybe() {
+    // Samples refer to objects the GC may move.
+    if(sampler && (om->collect_young_now || om->collect_mature_now)) {
+      sampler->process_samples();
+    }
+
     if(om->collect_young_now) {
       om->collect_young_now = false;
       om->collect_young(globals.roots);
@@ -221,30 +280,15 @@ namespace rubinius {
   }
 
   bool VM::find_and_activate_thread() {
-    Tuple* scheduled = globals.scheduled_threads.get();
-
-    for(std::size_t i = scheduled->num_fields() - 1; i > 0; i--) {
-      List* list = as<List>(scheduled->at(this, i));
-
-      Thread* thread = try_as<Thread>(list->shift(this));
+    while(Thread* thread = run_queue.pop(this)) {
+      thread->queued(this, Qfalse);
 
-      while(thread) {
-        thread->queued(this, Qfalse);
+      /** @todo   Should probably try to prevent dead threads here.. */
+      if(thread->alive() == Qfalse) continue;
+      if(thread->sleep() == Qtrue) continue;
 
-        /** @todo   Should probably try to prevent dead threads here.. */
-        if(thread->alive() == Qfalse) {
-          thread = try_as<Thread>(list->shift(this));
-          continue;
-        }
-
-        if(thread->sleep() == Qtrue) {
-          thread = try_as<Thread>(list->shift(this));
-          continue;
-        }
-
-        activate_thread(thread);
-        return true;
-      }
+      activate_thread(thread);
+      return true;
     }
 
     return false;
@@ -259,9 +303,7 @@ namespace rubinius {
     events->poll();
 
     if(!find_and_activate_thread()) {
-      // It's 1 because the event that looks for SIGCHLD is
-      // always registered.
-      if(events->num_of_events() == 1) {
+      if(!waiting_on_events_p()) {
         throw DeadLock("no runnable threads, present or future.");
       }
 
@@ -280,21 +322,15 @@ namespace rubinius {
       return;
     }
 
-    List* lst = as<List>(globals.scheduled_threads->at(this,
-                         thread->priority()->to_native()));
-    lst->append(this, thread);
-
+    run_queue.push(this, thread);
     thread->queued(this, Qtrue);
+
+    if(thread != globals.current_thread.get()) schedule_preemption();
   }
 
   void VM::dequeue_thread(Thread* thread) {
     thread->queued(this, Qfalse);
-
-    Tuple* scheduled = globals.scheduled_threads.get();
-
-    /** @todo  Could it be in more than one somehow? --rue */
-    List* list = try_as<List>(scheduled->at(this, thread->priority()->to_native()));
-    (void) list->remove(this, thread);
+    run_queue.remove(this, thread);
 
     check_events();
   }
@@ -305,9 +341,30 @@ namespace rubinius {
       return;
     }
 
+    metrics.thread_switches++;
+
+    Thread* current = globals.current_thread.get();
+
+    // Preempted Threads are CPU bound, so give them longer to run next
+    // time. Threads that stop early get a shorter slice.
+    uint64_t used = charge_current_thread();
+    uint64_t quantum = current->quantum()->to_native();
+
+    if(interrupts.reschedule) {
+      quantum *= 2;
+    } else if(used < quantum / 2) {
+      quantum /= 2;
+    }
+
+    if(quantum > config.quantum_max) quantum = config.quantum_max;
+    if(quantum < config.quantum_min) quantum = config.quantum_min;
+
+    current->quantum(this, Fixnum::from(quantum));
+    interrupts.reschedule = false;
+
     /* May have been using Tasks directly. */
-    globals.current_thread->task(this, globals.current_task.get());
-    queue_thread(globals.current_thread.get());
+    current->task(this, globals.current_task.get());
+    queue_thread(current);
 
     thread->sleep(this, Qfalse);
     globals.current_thread.set(thread);
@@ -315,6 +372,49 @@ namespace rubinius {
     if(globals.current_task.get() != thread->task()) {
       activate_task(thread->task());
     }
+
+    // The new Thread gets a full slice.
+    if(preemption) preemption->disarm();
+    schedule_preemption();
+  }
+
+  uint64_t VM::charge_current_thread() {
+    uint64_t now = native::cpu_time_usec();
+    uint64_t used = now - thread_cpu_mark;
+    thread_cpu_mark = now;
+
+    Thread* thread = globals.current_thread.get();
+    uint64_t total = thread->cpu_time()->to_long_long() + used;
+    thread->cpu_time(this, Integer::from(this, (unsigned long long)total));
+
+    return used;
+  }
+
+  void VM::schedule_preemption() {
+    if(!preemption || !interrupts.use_preempt) return;
+
+    if(!run_queue.empty_p()) {
+      if(preempt_for_events || !preemption->armed_p()) {
+        preemption->arm(globals.current_thread->quantum()->to_native());
+        preempt_for_events = false;
+      }
+    } else if(waiting_on_events_p()) {
+      // Nothing else polls the loop while this Thread runs, so sleepers,
+      // timeouts, IO and signal traps would wait until it blocks.
+      if(!preemption->armed_p()) {
+        preemption->arm(config.event_poll_interval);
+        preempt_for_events = true;
+      }
+    } else {
+      preemption->disarm();
+    }
+  }
+
+  bool VM::waiting_on_events_p() {
+    // The VM on the default loop always has the event that looks
+    // for SIGCHLD registered.
+    size_t permanent = owns_default_loop ? 1 : 0;
+    return events->num_of_events() > permanent;
   }
 
   void VM::activate_task(Task* task) {
@@ -376,10 +476,18 @@ namespace rubinius {
         }
 
         while(!find_and_activate_thread()) {
+          // Nothing to preempt while we wait.
+          if(preemption) preemption->disarm();
+
+          safepoint->enter_blocking();
           events->run_and_wait();
+          safepoint->leave_blocking();
         }
 
+        // Only set when the current Thread was picked again.
+        interrupts.reschedule = false;
         interrupts.enable_preempt = interrupts.use_preempt;
+        schedule_preemption();
       }
 
       collect_maybe();
@@ -387,44 +495,28 @@ namespace rubinius {
     }
   }
 
-  // Trampoline to call scheduler_loop()
-  static void* __thread_tramp__(void* arg) {
-    VM* state = static_cast<VM*>(arg);
-    state->scheduler_loop();
-    return NULL;
-  }
-
-  // Create the preemption thread and call scheduler_loop() in the new thread
   void VM::setup_preemption() {
-    if(pthread_create(&preemption_thread, NULL, __thread_tramp__, this) != 0) {
+    config.quantum = user_config->number("rbx.scheduler.quantum",
+        config.quantum / 1000) * 1000;
+    config.quantum_min = user_config->number("rbx.scheduler.quantum_min",
+        config.quantum_min / 1000) * 1000;
+    config.quantum_max = user_config->number("rbx.scheduler.quantum_max",
+        config.quantum_max / 1000) * 1000;
+    config.event_poll_interval = user_config->number("rbx.scheduler.poll_interval",
+        config.event_poll_interval / 1000) * 1000;
+
+    if(config.quantum_min < 1000) config.quantum_min = 1000;
+    if(config.quantum_max < config.quantum_min) config.quantum_max = config.quantum_min;
+    if(config.quantum < config.quantum_min) config.quantum = config.quantum_min;
+    if(config.quantum > config.quantum_max) config.quantum = config.quantum_max;
+    if(config.event_poll_interval < 1000) config.event_poll_interval = 1000;
+
+    if(!preemption) preemption = new PreemptionTimer(this);
+    if(!preemption->start()) {
       std::cout << "Unable to create preemption thread!\n";
     }
   }
 
-  // Runs forever, telling the VM to reschedule threads ever 10 milliseconds
-  void VM::scheduler_loop() {
-    // First off, we don't want this thread ever receiving a signal.
-    sigset_t mask;
-    sigfillset(&mask);
-    if(pthread_sigmask(SIG_BLOCK, &mask, NULL) != 0) {
-      abort();
-    }
-
-    struct timespec requested;
-    struct timespec actual;
-
-    requested.tv_sec = 0;
-    requested.tv_nsec = 10000000; // 10 milliseconds
-
-    for(;;) {
-      nanosleep(&requested, &actual);
-      if(interrupts.enable_preempt) {
-        interrupts.reschedule = true;
-        interrupts.check_events = true;
-      }
-    }
-  }
-
   /* For debugging. */
   extern "C" {
     void __printbt__() {
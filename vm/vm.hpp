@@ -4,8 +4,11 @@
 #include "globals.hpp"
 #include "symboltable.hpp"
 #include "gc_object_mark.hpp"
+#include "metrics.hpp"
+#include "run_queue.hpp"
 
 #include <pthread.h>
+#include <stdint.h>
 
 namespace llvm {
   class Module;
@@ -29,9 +32,26 @@ namespace rubinius {
   class String;
   class Symbol;
   class ConfigParser;
+  class Sampler;
+  class InstructionStats;
+  class Mailbox;
+  class PreemptionTimer;
+  class Safepoint;
 
   struct Configuration {
     bool compile_up_front;
+
+    // Thread time slices, in microseconds. A Thread starts out with
+    // +quantum+. It doubles each time the Thread is preempted and halves
+    // each time the Thread gives up the CPU before using half of it, so
+    // CPU bound Threads switch less and I/O bound ones stay responsive.
+    uint64_t quantum;
+    uint64_t quantum_min;
+    uint64_t quantum_max;
+
+    // How often, in microseconds, a Thread running alone is interrupted
+    // to poll the event loop while other Threads wait on events.
+    uint64_t event_poll_interval;
   };
 
   struct Interrupts {
@@ -42,6 +62,8 @@ namespace rubinius {
     bool reschedule;
     bool use_preempt;
     bool enable_preempt;
+    bool check_samples;
+    bool dump_metrics;
 
     Interrupts() :
       check(false),
@@ -50,7 +72,9 @@ namespace rubinius {
       check_events(false),
       reschedule(false),
       use_preempt(false),
-      enable_preempt(false)
+      enable_preempt(false),
+      check_samples(false),
+      dump_metrics(false)
     { }
   };
 
@@ -68,26 +92,49 @@ namespace rubinius {
     Interrupts interrupts;
     SymbolTable symbols;
     ConfigParser *user_config;
+    Sampler* sampler;
+    InstructionStats* instruction_stats;
+    Mailbox* mailbox;
+    RunQueue run_queue;
+    metrics::Metrics metrics;
 
     // Temporary holder for rb_gc_mark() in subtend
     ObjectMark current_mark;
 
     bool reuse_llvm;
 
-    // The thread used to trigger preemptive thread switching
-    pthread_t preemption_thread;
+    // Whether +events+ is libev's default loop. Only one VM in the process
+    // gets it, and only it can watch signals and child processes.
+    bool owns_default_loop;
+
+    // Ends time slices when other Threads are waiting to run. NULL until
+    // setup_preemption().
+    PreemptionTimer* preemption;
+
+    // Whether +preemption+ is armed only to poll for events, rather than
+    // for the end of the current Thread's quantum.
+    bool preempt_for_events;
+
+    // Lets other native threads stop this VM's at a consistent point.
+    Safepoint* safepoint;
+
+    // The CPU time of this native thread when the current Thread was
+    // last charged for what it used.
+    uint64_t thread_cpu_mark;
 
     static const size_t default_bytes = 1048576;
 
     /* Inline methods */
     /* Prototypes */
-    VM(size_t bytes = default_bytes);
+    // Uses +mailbox+ if given one, otherwise creates a Mailbox.
+    VM(size_t bytes = default_bytes, Mailbox* mailbox = NULL);
     ~VM();
 
-    // Returns the current VM state object.
+    // Returns the VM running on the calling native thread.
     static VM* current_state();
 
-    // Registers a VM* object as the current state.
+    // Registers a VM* object as the one running on the calling native
+    // thread.
     static void register_state(VM*);
 
     void bootstrap_class();
@@ -154,6 +201,19 @@ namespace rubinius {
     void activate_thread(Thread* thread);
     void activate_task(Task* task);
 
+    // Adds the CPU time used since the last charge to the current
+    // Thread. Returns the time added, in microseconds.
+    uint64_t charge_current_thread();
+
+    // Arms the preemption timer for the current Thread's quantum if other
+    // Threads are waiting to run, or for the event poll interval if they
+    // are waiting on events. Disarms it if there's nothing to wait for.
+    void schedule_preemption();
+
+    // Whether anything other than the permanent SIGCHLD watcher is
+    // registered with +events+.
+    bool waiting_on_events_p();
+
 
 
     void raise_from_errno(const char* reason);
@@ -174,12 +234,9 @@ namespace rubinius {
     // In an infinite loop, run the current task.
     void run_and_monitor();
 
+    // Reads the quanta from the config and starts the preemption timer.
     void setup_preemption();
 
-    // Run in a seperate thread to provide preemptive thread
-    // scheduling.
-    void scheduler_loop();
-
     // Run the garbage collectors as soon as you can
     void run_gc_soon();
   };
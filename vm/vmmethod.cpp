@@ -28,7 +28,10 @@ namespace rubinius {
    * Turns a CompiledMethod's InstructionSequence into a C array of opcodes.
    */
   VMMethod::VMMethod(STATE, CompiledMethod* meth) :
-      original(state, meth), type(NULL) {
+      original(state, meth), type(NULL),
+      profiler_method(NULL), profiler_id(0), profiler_name(NULL),
+      profiler_module(state), profiler_kind(profiler::kNormal),
+      instruction_stats_id(0), instruction_stats_index(0) {
 
     meth->set_executor(VMMethod::execute);
 
@@ -270,6 +273,58 @@ namespace rubinius {
     }
   }
 
+  profiler::Method* VMMethod::cached_profiler_method(profiler::Profiler* prof,
+      Symbol* name, Module* mod, profiler::Kind kind) {
+    if(profiler_id == prof->id() && profiler_name == name &&
+       profiler_module.get() == mod && profiler_kind == kind) {
+      return profiler_method;
+    }
+
+    return NULL;
+  }
+
+  void VMMethod::cache_profiler_method(profiler::Profiler* prof, Symbol* name,
+      Module* mod, profiler::Kind kind, profiler::Method* meth) {
+    profiler_method = meth;
+    profiler_id = prof->id();
+    profiler_name = name;
+    profiler_module.set(mod);
+    profiler_kind = kind;
+  }
+
+  /* Only the first call of a method under a Profiler has to work out its
+   * key, later ones use the entry cached on the VMMethod. */
+  static void enter_profiler(STATE, Task* task, VMMethod* vmm,
+                             CompiledMethod* cm, Message& msg) {
+    profiler::Profiler* prof = task->profiler;
+    MetaClass* mc = try_as<MetaClass>(msg.module);
+    profiler::Kind kind = mc ? profiler::kNormal : profiler::kSingleton;
+
+    profiler::Method* prof_meth =
+      vmm->cached_profiler_method(prof, msg.name, msg.module, kind);
+
+    if(!prof_meth) {
+      if(mc) {
+        Object* attached = mc->attached_instance();
+        if(Module* mod = try_as<Module>(attached)) {
+          prof_meth = prof->find_method(msg.name, mod->name(), kind);
+        } else {
+          prof_meth = prof->find_method(msg.name, attached->id(state), kind);
+        }
+      } else {
+        prof_meth = prof->find_method(msg.name, msg.module->name(), kind);
+      }
+
+      if(!prof_meth->file()) {
+        prof_meth->set_position(cm->file(), cm->start_line(state));
+      }
+
+      vmm->cache_profiler_method(prof, msg.name, msg.module, kind, prof_meth);
+    }
+
+    prof->enter_method(prof_meth);
+  }
+
   template <typename ArgumentHandler>
   ExecuteStatus VMMethod::execute_specialized(STATE, Task* task, Message& msg) {
     CompiledMethod* cm = as<CompiledMethod>(msg.method);
@@ -311,21 +366,7 @@ namespace rubinius {
     task->make_active(ctx);
 
     if(unlikely(task->profiler)) {
-      profiler::Method* prof_meth;
-      if(MetaClass* mc = try_as<MetaClass>(msg.module)) {
-        Object* attached = mc->attached_instance();
-        if(Module* mod = try_as<Module>(attached)) {
-          prof_meth = task->profiler->enter_method(msg.name, mod->name(), profiler::kNormal);
-        } else {
-          prof_meth = task->profiler->enter_method(msg.name, attached->id(state), profiler::kNormal);
-        }
-      } else {
-        prof_meth = task->profiler->enter_method(msg.name, msg.module->name(), profiler::kSingleton);
-      }
-
-      if(!prof_meth->file()) {
-        prof_meth->set_position(cm->file(), cm->start_line(state));
-      }
+      enter_profiler(state, task, vmm, cm, msg);
     }
 
     return cExecuteRestart;
@@ -415,21 +456,7 @@ namespace rubinius {
     task->make_active(ctx);
 
     if(unlikely(task->profiler)) {
-      profiler::Method* prof_meth;
-      if(MetaClass* mc = try_as<MetaClass>(msg.module)) {
-        Object* attached = mc->attached_instance();
-        if(Module* mod = try_as<Module>(attached)) {
-          prof_meth = task->profiler->enter_method(msg.name, mod->name(), profiler::kNormal);
-        } else {
-          prof_meth = task->profiler->enter_method(msg.name, attached->id(state), profiler::kNormal);
-        }
-      } else {
-        prof_meth = task->profiler->enter_method(msg.name, msg.module->name(), profiler::kSingleton);
-      }
-
-      if(!prof_meth->file()) {
-        prof_meth->set_position(cm->file(), cm->start_line(state));
-      }
+      enter_profiler(state, task, vmm, cm, msg);
     }
 
     return cExecuteRestart;
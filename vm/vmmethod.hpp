@@ -6,6 +6,7 @@
 #include "executor.hpp"
 #include "gc_root.hpp"
 #include "primitives.hpp"
+#include "profiler.hpp"
 #include "type_info.hpp"
 
 namespace rubinius {
@@ -14,9 +15,10 @@ namespace rubinius {
 
   class CompiledMethod;
   class MethodContext;
+  class Module;
   class Opcode;
   class SendSite;
-
+  class Symbol;
 
   class VMMethod {
   public:
@@ -36,6 +38,21 @@ namespace rubinius {
     native_int stack_size;
     native_int number_of_locals;
 
+    /* The profiler entry this method was last entered as. It's only valid
+     * for the Profiler numbered profiler_id and for calls with the same
+     * name, module and kind, the parts of the entry's profiler::Key, since
+     * an alias or an inherited call is profiled separately. */
+    profiler::Method* profiler_method;
+    uint64_t profiler_id;
+    Symbol* profiler_name;
+    TypedRoot<Module*> profiler_module;
+    profiler::Kind profiler_kind;
+
+    /* The number this method is counted under by the InstructionStats
+     * numbered instruction_stats_id. */
+    uint64_t instruction_stats_id;
+    size_t instruction_stats_index;
+
     VMMethod(STATE, CompiledMethod* meth);
     virtual ~VMMethod();
 
@@ -48,8 +65,19 @@ namespace rubinius {
 
     virtual void resume(Task* task, MethodContext* ctx);
 
+    /* resume, counting each instruction into VM::instruction_stats. */
+    void resume_counting(Task* task, MethodContext* ctx);
+
     void setup_argument_handler(CompiledMethod* meth);
 
+    /* Returns profiler_method if it's valid for +prof+ and a call of
+     * +name+ in +mod+ profiled as +kind+, else NULL. */
+    profiler::Method* cached_profiler_method(profiler::Profiler* prof, Symbol* name,
+                                             Module* mod, profiler::Kind kind);
+    void cache_profiler_method(profiler::Profiler* prof, Symbol* name,
+                               Module* mod, profiler::Kind kind,
+                               profiler::Method* meth);
+
     std::vector<Opcode*> create_opcodes();
 
     /*